@@ -0,0 +1,158 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "randomid.h"
+
+#include <ctype.h> // isalnum
+#include <errno.h>
+#include <string.h> // memcpy
+#include <sys/random.h>
+#include <random>
+
+using namespace std;
+
+static const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static inline uint32_t Rotl(uint32_t v, int n)
+{
+    return (v << n) | (v >> (32 - n));
+}
+
+static inline void QuarterRound(uint32_t *x, int a, int b, int c, int d)
+{
+    x[a] += x[b];
+    x[d] = Rotl(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = Rotl(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = Rotl(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = Rotl(x[b] ^ x[c], 7);
+}
+
+void RandomID::ChaCha20Block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3], uint8_t out[64])
+{
+    uint32_t init[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+                         key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                         counter, nonce[0], nonce[1], nonce[2]};
+    uint32_t x[16];
+    memcpy(x, init, sizeof(x));
+    for (int i = 0; i < 10; i++)
+    {
+        QuarterRound(x, 0, 4, 8, 12);
+        QuarterRound(x, 1, 5, 9, 13);
+        QuarterRound(x, 2, 6, 10, 14);
+        QuarterRound(x, 3, 7, 11, 15);
+        QuarterRound(x, 0, 5, 10, 15);
+        QuarterRound(x, 1, 6, 11, 12);
+        QuarterRound(x, 2, 7, 8, 13);
+        QuarterRound(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        uint32_t v = x[i] + init[i];
+        out[i * 4] = static_cast<uint8_t>(v);
+        out[i * 4 + 1] = static_cast<uint8_t>(v >> 8);
+        out[i * 4 + 2] = static_cast<uint8_t>(v >> 16);
+        out[i * 4 + 3] = static_cast<uint8_t>(v >> 24);
+    }
+}
+
+void RandomID::Seed_(State &state)
+{
+    uint8_t seed[sizeof(state.key) + sizeof(state.nonce)];
+    size_t got = 0;
+    while (got < sizeof(seed))
+    {
+        ssize_t n = getrandom(seed + got, sizeof(seed) - got, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break; // 内核不支持getrandom
+        }
+        got += n;
+    }
+    if (got < sizeof(seed))
+    {
+        random_device rd;
+        for (size_t i = 0; i < sizeof(seed); i++)
+        {
+            seed[i] = static_cast<uint8_t>(rd());
+        }
+    }
+    memcpy(state.key, seed, sizeof(state.key));
+    memcpy(state.nonce, seed + sizeof(state.key), sizeof(state.nonce));
+    memset(seed, 0, sizeof(seed));
+    state.counter = 0;
+    state.used = sizeof(state.block);
+}
+
+// 取16字节随机数，每个块可产生4个ID
+void RandomID::Next_(State &state, uint8_t out[16])
+{
+    if (state.used == sizeof(state.block))
+    {
+        if (state.counter == UINT32_MAX)
+        {
+            Seed_(state); // 计数器用尽前重新播种，避免密钥流重复
+        }
+        ChaCha20Block(state.key, state.counter++, state.nonce, state.block);
+        state.used = 0;
+    }
+    memcpy(out, state.block + state.used, 16);
+    state.used += 16;
+}
+
+void RandomID::Generate(char *out)
+{
+    static thread_local State state;
+    static thread_local bool seeded = false;
+    if (!seeded)
+    {
+        Seed_(state);
+        seeded = true;
+    }
+    uint8_t bytes[16];
+    Next_(state, bytes);
+
+    // 每3字节编码为4个字符，最后1字节编码为2个字符
+    int pos = 0;
+    for (int i = 0; i < 15; i += 3)
+    {
+        uint32_t v = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+        out[pos++] = BASE64URL[(v >> 18) & 0x3F];
+        out[pos++] = BASE64URL[(v >> 12) & 0x3F];
+        out[pos++] = BASE64URL[(v >> 6) & 0x3F];
+        out[pos++] = BASE64URL[v & 0x3F];
+    }
+    out[pos++] = BASE64URL[bytes[15] >> 2];
+    out[pos++] = BASE64URL[(bytes[15] & 0x03) << 4];
+}
+
+string RandomID::Generate()
+{
+    char buf[LEN];
+    Generate(buf);
+    return string(buf, LEN);
+}
+
+bool RandomID::IsValid(const string &id)
+{
+    if (id.size() != static_cast<size_t>(LEN))
+    {
+        return false;
+    }
+    for (char c : id)
+    {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+        {
+            return false;
+        }
+    }
+    return true;
+}
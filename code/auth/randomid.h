@@ -0,0 +1,40 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef RANDOM_ID_H
+#define RANDOM_ID_H
+
+#include <stdint.h>
+#include <string>
+
+// session_id生成器：每个线程一个ChaCha20密钥流，首次使用时由getrandom播种
+// 每个ID取128位随机数，编码为22个base64url字符
+class RandomID
+{
+public:
+    static const int LEN = 22;
+
+    static void Generate(char *out); // 写入LEN个字符，不含结尾'\0'，不分配内存
+    static std::string Generate();
+    static bool IsValid(const std::string &id); // 长度为LEN且只含base64url字符
+
+    // RFC 8439 ChaCha20块函数，输出64字节密钥流
+    static void ChaCha20Block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3], uint8_t out[64]);
+
+private:
+    struct State
+    {
+        uint32_t key[8];
+        uint32_t nonce[3];
+        uint32_t counter;
+        uint8_t block[64];
+        int used; // block中已消耗的字节数
+    };
+
+    static void Seed_(State &state);
+    static void Next_(State &state, uint8_t out[16]);
+};
+
+#endif // RANDOM_ID_H
@@ -0,0 +1,236 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "sessionstore.h"
+
+#include <hiredis/hiredis.h>
+
+#include "log/log.h"
+#include "pool/connpool.h"
+#include "pool/connRAII.h"
+
+using namespace std;
+
+const size_t MemSessionStore::MIN_SWEEP;
+
+SessionStore *SessionStore::Instance()
+{
+    return Store_().get();
+}
+
+// 在启动线程中调用，须早于工作线程访问Instance()
+void SessionStore::Init(int backend)
+{
+    if (backend == BACKEND_MEMORY)
+    {
+        Store_().reset(new MemSessionStore());
+    }
+    else
+    {
+        Store_().reset(new RedisSessionStore());
+    }
+}
+
+unique_ptr<SessionStore> &SessionStore::Store_()
+{
+    static unique_ptr<SessionStore> store(new RedisSessionStore());
+    return store;
+}
+
+// 执行一条命令，出错时记录日志并返回nullptr
+static redisReply *RedisCommand(redisContext *redis, const char *fmt, const string &key)
+{
+    redisReply *reply = (redisReply *)redisCommand(redis, fmt, key.c_str());
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
+    {
+        if (reply != nullptr)
+        {
+            LOG_ERROR("Redis command error: %s", reply->str);
+            freeReplyObject(reply);
+        }
+        return nullptr;
+    }
+    return reply;
+}
+
+// SET NX EX 一次往返完成查重、写入与过期设置
+STORE_RESULT RedisSessionStore::Create(const string &key, const string &value, int ttlSec)
+{
+    redisContext *redis;
+    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
+    if (!redis)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    LOG_DEBUG("SET %s %s NX EX %d", key.c_str(), value.c_str(), ttlSec);
+    redisReply *reply = (redisReply *)redisCommand(redis, "SET %s %s NX EX %d", key.c_str(), value.c_str(), ttlSec);
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
+    {
+        if (reply != nullptr)
+        {
+            LOG_ERROR("Redis command error: %s", reply->str);
+            freeReplyObject(reply);
+        }
+        return STORE_UNAVAILABLE;
+    }
+    bool created = (reply->type == REDIS_REPLY_STATUS); // 成功返回OK，key已存在返回nil
+    freeReplyObject(reply);
+    return created ? STORE_OK : STORE_FAIL;
+}
+
+STORE_RESULT RedisSessionStore::Set(const string &key, const string &value, int ttlSec)
+{
+    redisContext *redis;
+    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
+    if (!redis)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    LOG_DEBUG("SET %s EX %d", key.c_str(), ttlSec);
+    redisReply *reply = (redisReply *)redisCommand(redis, "SET %s %b EX %d", key.c_str(), value.data(), value.size(), ttlSec);
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
+    {
+        if (reply != nullptr)
+        {
+            LOG_ERROR("Redis command error: %s", reply->str);
+            freeReplyObject(reply);
+        }
+        return STORE_UNAVAILABLE;
+    }
+    freeReplyObject(reply);
+    return STORE_OK;
+}
+
+STORE_RESULT RedisSessionStore::Get(const string &key, string &value)
+{
+    redisContext *redis;
+    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
+    if (!redis)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    LOG_DEBUG("GET %s", key.c_str());
+    redisReply *reply = (redisReply *)redisCommand(redis, "GET %s", key.c_str());
+    if (reply == nullptr)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    if (reply->type == REDIS_REPLY_ERROR)
+    {
+        STORE_RESULT res = IsWrongType(string(reply->str, reply->len)) ? STORE_FAIL : STORE_UNAVAILABLE;
+        LOG_ERROR("Redis command error: %s", reply->str);
+        freeReplyObject(reply);
+        return res;
+    }
+    STORE_RESULT res = STORE_FAIL;
+    if (reply->type == REDIS_REPLY_STRING)
+    {
+        value.assign(reply->str, reply->len);
+        res = STORE_OK;
+    }
+    freeReplyObject(reply);
+    return res;
+}
+
+STORE_RESULT RedisSessionStore::Remove(const string &key)
+{
+    redisContext *redis;
+    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
+    if (!redis)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    LOG_DEBUG("DEL %s", key.c_str());
+    redisReply *reply = RedisCommand(redis, "DEL %s", key);
+    if (reply == nullptr)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    freeReplyObject(reply);
+    return STORE_OK;
+}
+
+MemSessionStore::Shard &MemSessionStore::GetShard_(const string &key)
+{
+    return shards_[hash<string>()(key) % SHARD_NUM];
+}
+
+void MemSessionStore::Sweep_(Shard &shard, Clock::time_point now)
+{
+    for (auto it = shard.items.begin(); it != shard.items.end();)
+    {
+        if (it->second.expires <= now)
+        {
+            it = shard.items.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    // 清理后按剩余项数翻倍，均摊到每次插入为O(1)
+    shard.sweepAt = max(MIN_SWEEP, shard.items.size() * 2);
+}
+
+STORE_RESULT MemSessionStore::Create(const string &key, const string &value, int ttlSec)
+{
+    Clock::time_point now = Clock::now();
+    Shard &shard = GetShard_(key);
+    lock_guard<mutex> locker(shard.mtx);
+    if (shard.items.size() >= shard.sweepAt)
+    {
+        Sweep_(shard, now);
+    }
+    Entry &entry = shard.items[key];
+    if (!entry.value.empty() && entry.expires > now)
+    {
+        return STORE_FAIL;
+    }
+    entry.value = value;
+    entry.expires = now + chrono::seconds(ttlSec);
+    return STORE_OK;
+}
+
+STORE_RESULT MemSessionStore::Set(const string &key, const string &value, int ttlSec)
+{
+    Clock::time_point now = Clock::now();
+    Shard &shard = GetShard_(key);
+    lock_guard<mutex> locker(shard.mtx);
+    if (shard.items.size() >= shard.sweepAt)
+    {
+        Sweep_(shard, now);
+    }
+    Entry &entry = shard.items[key];
+    entry.value = value;
+    entry.expires = now + chrono::seconds(ttlSec);
+    return STORE_OK;
+}
+
+STORE_RESULT MemSessionStore::Get(const string &key, string &value)
+{
+    Clock::time_point now = Clock::now();
+    Shard &shard = GetShard_(key);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.items.find(key);
+    if (it == shard.items.end())
+    {
+        return STORE_FAIL;
+    }
+    if (it->second.expires <= now)
+    {
+        shard.items.erase(it);
+        return STORE_FAIL;
+    }
+    value = it->second.value;
+    return STORE_OK;
+}
+
+STORE_RESULT MemSessionStore::Remove(const string &key)
+{
+    Shard &shard = GetShard_(key);
+    lock_guard<mutex> locker(shard.mtx);
+    shard.items.erase(key);
+    return STORE_OK;
+}
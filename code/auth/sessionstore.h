@@ -0,0 +1,93 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "storeresult.h"
+
+// session存储接口：带过期时间的键值，保存session_id -> 用户名及token的吊销记录
+class SessionStore
+{
+public:
+    enum BACKEND
+    {
+        BACKEND_REDIS,
+        BACKEND_MEMORY,
+    };
+
+    virtual ~SessionStore() = default;
+
+    // 未调用Init时为Redis实现
+    static SessionStore *Instance();
+    static void Init(int backend);
+
+    virtual STORE_RESULT Create(const std::string &key, const std::string &value, int ttlSec) = 0; // key已存在返回STORE_FAIL
+    virtual STORE_RESULT Set(const std::string &key, const std::string &value, int ttlSec) = 0;    // 覆盖已有的值
+    virtual STORE_RESULT Get(const std::string &key, std::string &value) = 0;                    // key不存在返回STORE_FAIL
+    virtual STORE_RESULT Remove(const std::string &key) = 0;
+    virtual bool IsRedis() const { return false; } // 可由RedisAsync异步查询
+
+    // 上传会话与token吊销记录共用该存储，session使用独立的前缀，不能以其他记录的key冒充session_id
+    static std::string SessionKey(const std::string &sid) { return "sess:" + sid; }
+    // key的类型不是字符串(如旧版本以hash保存的session)，按key不存在处理
+    static bool IsWrongType(const std::string &err) { return err.compare(0, 9, "WRONGTYPE") == 0; }
+
+private:
+    static std::unique_ptr<SessionStore> &Store_();
+};
+
+// 基于RedisConnPool，Create为一条SET NX EX
+class RedisSessionStore : public SessionStore
+{
+public:
+    STORE_RESULT Create(const std::string &key, const std::string &value, int ttlSec) override;
+    STORE_RESULT Set(const std::string &key, const std::string &value, int ttlSec) override;
+    STORE_RESULT Get(const std::string &key, std::string &value) override;
+    STORE_RESULT Remove(const std::string &key) override;
+    bool IsRedis() const override { return true; }
+};
+
+// 进程内实现，分片加锁，过期项在访问时及分片增长时清理
+class MemSessionStore : public SessionStore
+{
+public:
+    STORE_RESULT Create(const std::string &key, const std::string &value, int ttlSec) override;
+    STORE_RESULT Set(const std::string &key, const std::string &value, int ttlSec) override;
+    STORE_RESULT Get(const std::string &key, std::string &value) override;
+    STORE_RESULT Remove(const std::string &key) override;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int SHARD_NUM = 16;
+    static const size_t MIN_SWEEP = 1024; // 分片项数超过该值后才触发清理
+
+    struct Entry
+    {
+        std::string value;
+        Clock::time_point expires;
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> items;
+        size_t sweepAt = MIN_SWEEP;
+    };
+
+    Shard &GetShard_(const std::string &key);
+    static void Sweep_(Shard &shard, Clock::time_point now);
+
+    Shard shards_[SHARD_NUM];
+};
+
+#endif // SESSION_STORE_H
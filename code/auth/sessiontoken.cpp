@@ -0,0 +1,235 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "sessiontoken.h"
+
+#include <ctime>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h> // CRYPTO_memcmp
+
+#include "log/log.h"
+#include "sessionstore.h"
+
+using namespace std;
+
+static const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+SessionToken::SessionToken()
+{
+    isOpen_ = false;
+    revocation_ = false;
+}
+
+SessionToken *SessionToken::Instance()
+{
+    static SessionToken inst;
+    return &inst;
+}
+
+void SessionToken::Init(const string &key, bool revocation)
+{
+    if (key.empty())
+    {
+        unsigned char buf[32];
+        RAND_bytes(buf, sizeof(buf));
+        key_.assign(reinterpret_cast<char *>(buf), sizeof(buf));
+        LOG_WARN("SessionToken: no key given, using a random key");
+    }
+    else
+    {
+        key_ = key;
+    }
+    revocation_ = revocation;
+    isOpen_ = true;
+}
+
+string SessionToken::Issue(const string &user, int timeoutSec)
+{
+    unsigned char id[12];
+    RAND_bytes(id, sizeof(id));
+    long long expires = static_cast<long long>(time(nullptr)) + timeoutSec;
+
+    string payload = to_string(expires) + "." + Base64UrlEncode_(id, sizeof(id)) + "." +
+                     Base64UrlEncode_(reinterpret_cast<const unsigned char *>(user.data()), user.size());
+    return payload + "." + Sign_(payload.data(), payload.size());
+}
+
+STORE_RESULT SessionToken::Verify(const string &token, string &user)
+{
+    string tokenId;
+    if (!CheckSignature(token, user, tokenId))
+    {
+        return STORE_FAIL;
+    }
+    if (revocation_)
+    {
+        STORE_RESULT res = CheckRevoked_(tokenId);
+        if (res == STORE_FAIL)
+        {
+            LOG_DEBUG("SessionToken revoked");
+        }
+        return res;
+    }
+    return STORE_OK;
+}
+
+bool SessionToken::CheckSignature(const string &token, string &user, string &tokenId)
+{
+    long long expires = 0;
+    if (!Parse_(token, expires, tokenId, user))
+    {
+        return false;
+    }
+    if (expires <= static_cast<long long>(time(nullptr)))
+    {
+        LOG_DEBUG("SessionToken expired");
+        return false;
+    }
+    return true;
+}
+
+STORE_RESULT SessionToken::Revoke(const string &token)
+{
+    long long expires = 0;
+    string tokenId, user;
+    if (!Parse_(token, expires, tokenId, user))
+    {
+        return STORE_FAIL;
+    }
+    if (!revocation_)
+    {
+        return STORE_OK; // 未开启吊销时仅清除客户端cookie
+    }
+    long long ttl = expires - static_cast<long long>(time(nullptr));
+    if (ttl <= 0)
+    {
+        return STORE_OK;
+    }
+
+    // 吊销记录与token同时过期，已存在说明重复登出
+    STORE_RESULT res = SessionStore::Instance()->Create(RevokedKey(tokenId), "1", static_cast<int>(ttl));
+    return res == STORE_UNAVAILABLE ? res : STORE_OK;
+}
+
+STORE_RESULT SessionToken::CheckRevoked_(const string &tokenId)
+{
+    string value;
+    STORE_RESULT res = SessionStore::Instance()->Get(RevokedKey(tokenId), value);
+    if (res == STORE_UNAVAILABLE)
+    {
+        return res; // 无法确认时不放行
+    }
+    return res == STORE_OK ? STORE_FAIL : STORE_OK;
+}
+
+string SessionToken::RevokedKey(const string &tokenId)
+{
+    return "revoked:" + tokenId;
+}
+
+bool SessionToken::Parse_(const string &token, long long &expires, string &tokenId, string &user)
+{
+    if (!isOpen_)
+    {
+        return false;
+    }
+    size_t p1 = token.find('.');
+    size_t p2 = (p1 == string::npos) ? p1 : token.find('.', p1 + 1);
+    size_t p3 = (p2 == string::npos) ? p2 : token.find('.', p2 + 1);
+    if (p3 == string::npos || token.find('.', p3 + 1) != string::npos)
+    {
+        return false;
+    }
+
+    // 先校验签名，再解析内容
+    string sign = Sign_(token.data(), p3);
+    const string given = token.substr(p3 + 1);
+    if (given.size() != sign.size() || CRYPTO_memcmp(given.data(), sign.data(), sign.size()) != 0)
+    {
+        LOG_DEBUG("SessionToken bad signature");
+        return false;
+    }
+
+    char *end = nullptr;
+    string expiresStr = token.substr(0, p1);
+    expires = strtoll(expiresStr.c_str(), &end, 10);
+    if (end == expiresStr.c_str() || *end != '\0')
+    {
+        return false;
+    }
+    tokenId = token.substr(p1 + 1, p2 - p1 - 1);
+    return Base64UrlDecode_(token.substr(p2 + 1, p3 - p2 - 1), user) && !user.empty();
+}
+
+string SessionToken::Sign_(const char *data, size_t len) const
+{
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLen = 0;
+    HMAC(EVP_sha256(), key_.data(), static_cast<int>(key_.size()),
+         reinterpret_cast<const unsigned char *>(data), len, mac, &macLen);
+    return Base64UrlEncode_(mac, macLen);
+}
+
+string SessionToken::Base64UrlEncode_(const unsigned char *data, size_t len)
+{
+    string out;
+    out.reserve((len * 4 + 2) / 3);
+    size_t i = 0;
+    for (; i + 2 < len; i += 3)
+    {
+        unsigned int v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += BASE64URL[(v >> 18) & 0x3f];
+        out += BASE64URL[(v >> 12) & 0x3f];
+        out += BASE64URL[(v >> 6) & 0x3f];
+        out += BASE64URL[v & 0x3f];
+    }
+    if (i + 1 == len)
+    {
+        unsigned int v = data[i] << 16;
+        out += BASE64URL[(v >> 18) & 0x3f];
+        out += BASE64URL[(v >> 12) & 0x3f];
+    }
+    else if (i + 2 == len)
+    {
+        unsigned int v = (data[i] << 16) | (data[i + 1] << 8);
+        out += BASE64URL[(v >> 18) & 0x3f];
+        out += BASE64URL[(v >> 12) & 0x3f];
+        out += BASE64URL[(v >> 6) & 0x3f];
+    }
+    return out;
+}
+
+bool SessionToken::Base64UrlDecode_(const string &str, string &out)
+{
+    out.clear();
+    unsigned int v = 0;
+    int bits = 0;
+    for (char c : str)
+    {
+        int d;
+        if (c >= 'A' && c <= 'Z')
+            d = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            d = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            d = c - '0' + 52;
+        else if (c == '-')
+            d = 62;
+        else if (c == '_')
+            d = 63;
+        else
+            return false;
+        v = (v << 6) | d;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            out += static_cast<char>((v >> bits) & 0xff);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef SESSION_TOKEN_H
+#define SESSION_TOKEN_H
+
+#include <string>
+
+#include "storeresult.h"
+
+// 无状态session：cookie为服务端密钥HMAC-SHA256签名的token，进程内即可完成校验
+// token格式: <过期时间>.<token id>.<base64url(用户名)>.<base64url(签名)>
+class SessionToken
+{
+public:
+    static SessionToken *Instance();
+
+    // key为空时随机生成（重启后已签发的token全部失效）；revocation开启时登出的token记录到SessionStore
+    void Init(const std::string &key, bool revocation);
+    bool IsOpen() const { return isOpen_; }
+    bool Revocation() const { return revocation_; }
+
+    std::string Issue(const std::string &user, int timeoutSec);
+    STORE_RESULT Verify(const std::string &token, std::string &user);
+    // 只校验签名与过期时间，吊销检查由调用方完成（异步查询时使用）
+    bool CheckSignature(const std::string &token, std::string &user, std::string &tokenId);
+    STORE_RESULT Revoke(const std::string &token);
+    static std::string RevokedKey(const std::string &tokenId); // 吊销记录在SessionStore中的key
+
+private:
+    SessionToken();
+    ~SessionToken() = default;
+
+    bool Parse_(const std::string &token, long long &expires, std::string &tokenId, std::string &user);
+    std::string Sign_(const char *data, size_t len) const;
+    STORE_RESULT CheckRevoked_(const std::string &tokenId); // 未吊销返回STORE_OK
+
+    static std::string Base64UrlEncode_(const unsigned char *data, size_t len);
+    static bool Base64UrlDecode_(const std::string &str, std::string &out);
+
+    bool isOpen_;
+    bool revocation_;
+    std::string key_;
+};
+
+#endif // SESSION_TOKEN_H
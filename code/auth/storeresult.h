@@ -0,0 +1,17 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef STORE_RESULT_H
+#define STORE_RESULT_H
+
+// 访问用户/session存储的结果，区分校验失败与存储不可用
+enum STORE_RESULT
+{
+    STORE_OK,
+    STORE_FAIL,        // 校验不通过/记录不存在
+    STORE_UNAVAILABLE, // 连接池繁忙或存储出错，应返回503
+};
+
+#endif // STORE_RESULT_H
@@ -0,0 +1,188 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "userstore.h"
+
+#include <string.h> // memset
+#include <mysql/mysql.h>
+#include <mysql/mysqld_error.h> // ER_DUP_ENTRY
+
+#include "log/log.h"
+#include "pool/connpool.h"
+#include "pool/connRAII.h"
+
+using namespace std;
+
+UserStore *UserStore::Instance()
+{
+    return Store_().get();
+}
+
+// 在启动线程中调用，须早于工作线程访问Instance()
+void UserStore::Init(int backend)
+{
+    if (backend == BACKEND_MEMORY)
+    {
+        Store_().reset(new MemUserStore());
+    }
+    else
+    {
+        Store_().reset(new MySQLUserStore());
+    }
+}
+
+unique_ptr<UserStore> &UserStore::Store_()
+{
+    static unique_ptr<UserStore> store(new MySQLUserStore());
+    return store;
+}
+
+// 绑定一个字符串参数，buffer指向调用方的字符串
+static void BindString(MYSQL_BIND &bind, const string &str, unsigned long &len)
+{
+    memset(&bind, 0, sizeof(bind));
+    len = str.size();
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char *>(str.data());
+    bind.buffer_length = len;
+    bind.length = &len;
+}
+
+// 查询用户密码，预处理语句按连接缓存，参数不再拼接进SQL
+static STORE_RESULT QueryPassword(MYSQL *sql, const string &name, string &pwd, bool &found)
+{
+    MYSQL_STMT *stmt = MySQLConnPool::Instance()->GetStmt(sql, "SELECT password FROM user WHERE username=? LIMIT 1");
+    if (stmt == nullptr)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    MYSQL_BIND param[1];
+    unsigned long nameLen = 0;
+    BindString(param[0], name, nameLen);
+
+    char password[256];
+    unsigned long passwordLen = 0;
+    bool isNull = false;
+    MYSQL_BIND result[1];
+    memset(result, 0, sizeof(result));
+    result[0].buffer_type = MYSQL_TYPE_STRING;
+    result[0].buffer = password;
+    result[0].buffer_length = sizeof(password);
+    result[0].length = &passwordLen;
+    result[0].is_null = &isNull;
+
+    if (mysql_stmt_bind_param(stmt, param) || mysql_stmt_bind_result(stmt, result) || mysql_stmt_execute(stmt))
+    {
+        LOG_ERROR("MySql query error: %s", mysql_stmt_error(stmt));
+        return STORE_UNAVAILABLE;
+    }
+    int ret = mysql_stmt_fetch(stmt);
+    mysql_stmt_free_result(stmt);
+    if (ret == 1)
+    {
+        LOG_ERROR("MySql fetch error: %s", mysql_stmt_error(stmt));
+        return STORE_UNAVAILABLE;
+    }
+    found = (ret == 0 || ret == MYSQL_DATA_TRUNCATED);
+    pwd.clear();
+    // 超长密码被截断时按空密码处理，调用方已拒绝空密码，比较必然失败
+    if (found && !isNull && passwordLen <= sizeof(password))
+    {
+        pwd.assign(password, passwordLen);
+    }
+    return STORE_OK;
+}
+
+STORE_RESULT MySQLUserStore::Verify(const string &name, const string &pwd)
+{
+    MYSQL *sql;
+    ConnRAII<MYSQL> sqlRAII(&sql, MySQLConnPool::Instance());
+    if (!sql)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    string password;
+    bool found = false;
+    STORE_RESULT res = QueryPassword(sql, name, password, found);
+    if (res != STORE_OK)
+    {
+        return res;
+    }
+    if (found && password == pwd)
+    {
+        return STORE_OK;
+    }
+    LOG_DEBUG("pwd error!");
+    return STORE_FAIL;
+}
+
+STORE_RESULT MySQLUserStore::Register(const string &name, const string &pwd)
+{
+    MYSQL *sql;
+    ConnRAII<MYSQL> sqlRAII(&sql, MySQLConnPool::Instance());
+    if (!sql)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    string password;
+    bool found = false;
+    STORE_RESULT res = QueryPassword(sql, name, password, found);
+    if (res != STORE_OK)
+    {
+        return res;
+    }
+    if (found)
+    {
+        LOG_DEBUG("user used!");
+        return STORE_FAIL;
+    }
+    LOG_DEBUG("regirster!");
+    MYSQL_STMT *stmt = MySQLConnPool::Instance()->GetStmt(sql, "INSERT INTO user(username, password) VALUES(?, ?)");
+    if (stmt == nullptr)
+    {
+        return STORE_UNAVAILABLE;
+    }
+    MYSQL_BIND insertParam[2];
+    unsigned long nameLen = 0, pwdLen = 0;
+    BindString(insertParam[0], name, nameLen);
+    BindString(insertParam[1], pwd, pwdLen);
+    if (mysql_stmt_bind_param(stmt, insertParam) || mysql_stmt_execute(stmt))
+    {
+        LOG_DEBUG("Insert error: %s", mysql_stmt_error(stmt));
+        // 查询与插入之间被并发注册抢先，与用户名已存在相同
+        return mysql_stmt_errno(stmt) == ER_DUP_ENTRY ? STORE_FAIL : STORE_UNAVAILABLE;
+    }
+    return STORE_OK;
+}
+
+MemUserStore::Shard &MemUserStore::GetShard_(const string &name)
+{
+    return shards_[hash<string>()(name) % SHARD_NUM];
+}
+
+STORE_RESULT MemUserStore::Verify(const string &name, const string &pwd)
+{
+    Shard &shard = GetShard_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.users.find(name);
+    if (it != shard.users.end() && it->second == pwd)
+    {
+        return STORE_OK;
+    }
+    LOG_DEBUG("pwd error!");
+    return STORE_FAIL;
+}
+
+STORE_RESULT MemUserStore::Register(const string &name, const string &pwd)
+{
+    Shard &shard = GetShard_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    if (!shard.users.emplace(name, pwd).second)
+    {
+        LOG_DEBUG("user used!");
+        return STORE_FAIL;
+    }
+    return STORE_OK;
+}
@@ -0,0 +1,68 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <mutex>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "storeresult.h"
+
+// 用户存储接口：登录校验与注册
+class UserStore
+{
+public:
+    enum BACKEND
+    {
+        BACKEND_MYSQL,
+        BACKEND_MEMORY,
+    };
+
+    virtual ~UserStore() = default;
+
+    // 未调用Init时为MySQL实现
+    static UserStore *Instance();
+    static void Init(int backend);
+
+    virtual STORE_RESULT Verify(const std::string &name, const std::string &pwd) = 0; // 用户不存在或密码错误返回STORE_FAIL
+    virtual STORE_RESULT Register(const std::string &name, const std::string &pwd) = 0; // 用户名已被使用返回STORE_FAIL
+
+private:
+    static std::unique_ptr<UserStore> &Store_();
+};
+
+// 基于MySQLConnPool与按连接缓存的预处理语句
+class MySQLUserStore : public UserStore
+{
+public:
+    STORE_RESULT Verify(const std::string &name, const std::string &pwd) override;
+    STORE_RESULT Register(const std::string &name, const std::string &pwd) override;
+};
+
+// 进程内实现，分片加锁，用于无外部服务时的压测
+class MemUserStore : public UserStore
+{
+public:
+    STORE_RESULT Verify(const std::string &name, const std::string &pwd) override;
+    STORE_RESULT Register(const std::string &name, const std::string &pwd) override;
+
+private:
+    static const int SHARD_NUM = 16;
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_map<std::string, std::string> users; // 用户名 -> 密码
+    };
+
+    Shard &GetShard_(const std::string &name);
+
+    Shard shards_[SHARD_NUM];
+};
+
+#endif // USER_STORE_H
@@ -0,0 +1,58 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "arena.h"
+
+#include <algorithm>
+
+#include "blockpool.h"
+
+using namespace std;
+
+const size_t Arena::BLOCK_SIZE;
+
+Arena::Arena() : head_(nullptr), pos_(0), used_(0) {}
+
+Arena::~Arena()
+{
+    Reset();
+}
+
+char *Arena::Alloc(size_t len)
+{
+    if (head_ == nullptr || head_->cap - pos_ < len)
+    {
+        size_t cap = 0;
+        Block *block = static_cast<Block *>(BlockPool::Instance()->Alloc(max(BLOCK_SIZE, len + sizeof(Block)), cap));
+        block->next = head_;
+        block->cap = cap - sizeof(Block);
+        head_ = block;
+        pos_ = 0;
+    }
+    char *p = head_->Data() + pos_;
+    pos_ += len;
+    used_ += len;
+    return p;
+}
+
+StrSpan Arena::Copy(const char *data, size_t len)
+{
+    char *p = Alloc(len);
+    memcpy(p, data, len);
+    return StrSpan(p, len);
+}
+
+// 常见请求只有一个块，归还即完成重置
+void Arena::Reset()
+{
+    while (head_ != nullptr)
+    {
+        Block *next = head_->next;
+        BlockPool::Instance()->Free(head_, head_->cap + sizeof(Block));
+        head_ = next;
+    }
+    pos_ = 0;
+    used_ = 0;
+}
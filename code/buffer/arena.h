@@ -0,0 +1,58 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <string>
+#include <string.h> // memcmp strncasecmp strlen
+
+// 指向Arena或其他缓冲区中的一段字符，不持有内存
+struct StrSpan
+{
+    const char *data = nullptr;
+    size_t len = 0;
+
+    StrSpan() = default;
+    StrSpan(const char *d, size_t l) : data(d), len(l) {}
+
+    bool empty() const { return len == 0; }
+    std::string str() const { return std::string(data, len); }
+    bool Equals(const char *s) const { return strlen(s) == len && memcmp(data, s, len) == 0; }
+    bool EqualsNoCase(const char *s) const { return strlen(s) == len && strncasecmp(data, s, len) == 0; }
+};
+
+// 单次请求内的线性分配器，内存块取自BlockPool，Reset时整体归还
+// 只用于保存字符数据，不做对齐
+class Arena
+{
+public:
+    Arena();
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    char *Alloc(size_t len);
+    StrSpan Copy(const char *data, size_t len);
+    void Reset();
+
+    size_t Used() const { return used_; }
+
+private:
+    struct Block
+    {
+        Block *next;
+        size_t cap; // 数据区容量，不含块头
+        char *Data() { return reinterpret_cast<char *>(this + 1); }
+    };
+
+    static const size_t BLOCK_SIZE = 4 * 1024; // 常见请求的请求行与头部一个块即可容纳
+
+    Block *head_; // 当前块，新块插在链首
+    size_t pos_;  // 当前块已用字节
+    size_t used_;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,160 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "blockpool.h"
+
+#include <stdio.h>
+#include <stdlib.h> // malloc free
+
+using namespace std;
+
+const size_t BlockPool::CLASS_SIZE[CLASS_NUM] = {1024, 4 * 1024, 16 * 1024, 64 * 1024};
+const size_t BlockPool::MAX_BLOCK;
+const size_t BlockPool::OVERFLOW_SIZE;
+const size_t BlockPool::THREAD_CACHE_BYTES;
+const size_t BlockPool::GLOBAL_CACHE_BYTES;
+
+BlockPool *BlockPool::Instance()
+{
+    static BlockPool inst;
+    return &inst;
+}
+
+char *BlockPool::ThreadOverflow()
+{
+    static thread_local char overflow[OVERFLOW_SIZE];
+    return overflow;
+}
+
+BlockPool::~BlockPool()
+{
+    for (int cls = 0; cls < CLASS_NUM; cls++)
+    {
+        for (void *data : global_[cls])
+        {
+            free(data);
+        }
+    }
+}
+
+// 线程退出时把缓存的块还给全局池
+BlockPool::ThreadCache::~ThreadCache()
+{
+    BlockPool *pool = BlockPool::Instance();
+    for (int cls = 0; cls < CLASS_NUM; cls++)
+    {
+        pool->Drain_(cls, free[cls], 0);
+    }
+}
+
+int BlockPool::ClassOf_(size_t size)
+{
+    for (int cls = 0; cls < CLASS_NUM; cls++)
+    {
+        if (size <= CLASS_SIZE[cls])
+        {
+            return cls;
+        }
+    }
+    return -1;
+}
+
+size_t BlockPool::ThreadLimit_(int cls)
+{
+    size_t limit = THREAD_CACHE_BYTES / CLASS_SIZE[cls];
+    return limit < 4 ? 4 : limit;
+}
+
+BlockPool::ThreadCache &BlockPool::Cache_()
+{
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+void *BlockPool::Alloc(size_t size, size_t &cap)
+{
+    int cls = ClassOf_(size);
+    if (cls < 0)
+    {
+        cap = size;
+        inUse_ += cap;
+        return malloc(size);
+    }
+    cap = CLASS_SIZE[cls];
+    inUse_ += cap;
+    vector<void *> &local = Cache_().free[cls];
+    if (local.empty())
+    {
+        Refill_(cls, local);
+    }
+    if (local.empty())
+    {
+        return malloc(cap);
+    }
+    void *data = local.back();
+    local.pop_back();
+    cached_ -= cap;
+    return data;
+}
+
+void BlockPool::Free(void *data, size_t cap)
+{
+    inUse_ -= cap;
+    int cls = ClassOf_(cap);
+    if (cls < 0 || CLASS_SIZE[cls] != cap)
+    {
+        free(data);
+        return;
+    }
+    vector<void *> &local = Cache_().free[cls];
+    local.push_back(data);
+    cached_ += cap;
+    if (local.size() > ThreadLimit_(cls))
+    {
+        Drain_(cls, local, ThreadLimit_(cls) / 2);
+    }
+}
+
+// 从全局池取半个线程缓存的块
+void BlockPool::Refill_(int cls, vector<void *> &local)
+{
+    size_t batch = ThreadLimit_(cls) / 2;
+    lock_guard<mutex> locker(mtx_);
+    vector<void *> &global = global_[cls];
+    while (batch-- > 0 && !global.empty())
+    {
+        local.push_back(global.back());
+        global.pop_back();
+    }
+}
+
+// 线程缓存只保留keep个块，其余放回全局池，全局池已满时释放
+void BlockPool::Drain_(int cls, vector<void *> &local, size_t keep)
+{
+    size_t globalLimit = GLOBAL_CACHE_BYTES / CLASS_SIZE[cls];
+    lock_guard<mutex> locker(mtx_);
+    vector<void *> &global = global_[cls];
+    while (local.size() > keep)
+    {
+        void *data = local.back();
+        local.pop_back();
+        if (global.size() < globalLimit)
+        {
+            global.push_back(data);
+        }
+        else
+        {
+            free(data);
+            cached_ -= CLASS_SIZE[cls];
+        }
+    }
+}
+
+string BlockPool::Stats() const
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "inuse:%zuKB cached:%zuKB", inUse_.load() / 1024, cached_.load() / 1024);
+    return buf;
+}
@@ -0,0 +1,65 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+// ChainBuffer使用的分级内存块池
+// 每个线程缓存少量各级空闲块，无锁分配与回收；线程缓存满或为空时与全局池批量交换
+// 超过最大等级的块直接分配与释放
+class BlockPool
+{
+public:
+    static const int CLASS_NUM = 4;
+    static const size_t CLASS_SIZE[CLASS_NUM]; // 1KB 4KB 16KB 64KB
+    static const size_t MAX_BLOCK = 64 * 1024;
+    static const size_t OVERFLOW_SIZE = 64 * 1024;
+
+    static BlockPool *Instance();
+
+    // 当前线程共享的溢出区，readv时兜底接收超出预估的数据，用完即拷出
+    static char *ThreadOverflow();
+
+    // 返回至少size字节的块，cap为实际容量
+    void *Alloc(size_t size, size_t &cap);
+    void Free(void *data, size_t cap);
+
+    size_t InUseBytes() const { return inUse_; }
+    size_t CachedBytes() const { return cached_; }
+    std::string Stats() const;
+
+private:
+    BlockPool() : inUse_(0), cached_(0) {}
+    ~BlockPool();
+
+    struct ThreadCache
+    {
+        std::vector<void *> free[CLASS_NUM];
+        ~ThreadCache();
+    };
+
+    static const size_t THREAD_CACHE_BYTES = 256 * 1024;     // 每个线程每级缓存上限
+    static const size_t GLOBAL_CACHE_BYTES = 16 * 1024 * 1024; // 全局每级缓存上限
+
+    static int ClassOf_(size_t size);
+    static size_t ThreadLimit_(int cls);
+    static ThreadCache &Cache_();
+
+    void Refill_(int cls, std::vector<void *> &local);
+    void Drain_(int cls, std::vector<void *> &local, size_t keep);
+
+    std::mutex mtx_;
+    std::vector<void *> global_[CLASS_NUM];
+    std::atomic<size_t> inUse_;  // 已借出的字节数
+    std::atomic<size_t> cached_; // 线程缓存与全局池中空闲块的字节数
+};
+
+#endif // BLOCK_POOL_H
@@ -6,9 +6,12 @@
 #include "buffer.h"
 
 #include <assert.h>
-#include <cstring>   // bzero
+#include <errno.h>
 #include <unistd.h>  // write
 #include <sys/uio.h> // readv
+#include <sys/ioctl.h> // FIONREAD
+
+#include "blockpool.h"
 
 using namespace std;
 
@@ -46,9 +49,9 @@ void Buffer::RetrieveUntil(const char *end)
     Retrieve(end - Peek());
 }
 
+// 只重置读写位置，已读内容不再清零，数据均按长度访问
 void Buffer::RetrieveAll()
 {
-    bzero(&buffer_[0], buffer_.size());
     readPos_ = 0;
     writePos_ = 0;
 }
@@ -110,14 +113,19 @@ void Buffer::EnsureWriteable(size_t len)
 
 ssize_t Buffer::ReadFd(int fd, int *saveErrno)
 {
-    char buff[65535];
+    // 按FIONREAD预留空间直接读入缓冲区，之后到达的数据落入线程共享的溢出区
+    int pending = 0;
+    if (ioctl(fd, FIONREAD, &pending) == 0 && static_cast<size_t>(pending) > WritableBytes())
+    {
+        EnsureWriteable(pending);
+    }
+    char *overflow = BlockPool::ThreadOverflow();
     struct iovec iov[2];
     const size_t writable = WritableBytes();
-    // 分散读，保证数据全部读完
     iov[0].iov_base = BeginPtr_() + writePos_;
     iov[0].iov_len = writable;
-    iov[1].iov_base = buff;
-    iov[1].iov_len = sizeof(buff);
+    iov[1].iov_base = overflow;
+    iov[1].iov_len = BlockPool::OVERFLOW_SIZE;
 
     const ssize_t len = readv(fd, iov, 2);
     if (len < 0)
@@ -131,7 +139,7 @@ ssize_t Buffer::ReadFd(int fd, int *saveErrno)
     else
     {
         writePos_ = buffer_.size();
-        Append(buff, len - writable);
+        Append(overflow, len - writable);
     }
     return len;
 }
@@ -9,7 +9,6 @@
 
 #include <vector>
 #include <string>
-#include <atomic>
 
 class Buffer
 {
@@ -47,9 +46,10 @@ private:
     const char *BeginPtr_() const;
     void MakeSpace_(size_t len);
 
+    // Buffer只属于一个连接或日志实例，由外部加锁保证独占访问，读写位置无需原子操作
     std::vector<char> buffer_;
-    std::atomic<std::size_t> readPos_;
-    std::atomic<std::size_t> writePos_;
+    std::size_t readPos_;
+    std::size_t writePos_;
 };
 
 #endif // BUFFER_H
\ No newline at end of file
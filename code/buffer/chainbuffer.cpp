@@ -0,0 +1,368 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "chainbuffer.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h> // memcpy memchr
+#include <unistd.h> // read
+#include <sys/ioctl.h> // FIONREAD
+
+#include "blockpool.h"
+
+using namespace std;
+
+const size_t ChainBuffer::npos;
+const int ChainBuffer::MAX_IOV;
+const size_t ChainBuffer::MIN_BLOCK;
+const size_t ChainBuffer::READ_BLOCK;
+const int ChainBuffer::MAX_READ_BLOCKS;
+
+ChainBuffer::ChainBuffer() : head_(nullptr), tail_(nullptr), count_(0), readable_(0) {}
+
+ChainBuffer::~ChainBuffer()
+{
+    RetrieveAll();
+}
+
+size_t ChainBuffer::ReadableBytes() const
+{
+    return readable_;
+}
+
+size_t ChainBuffer::BlockCount() const
+{
+    return count_;
+}
+
+const char *ChainBuffer::Peek() const
+{
+    if (head_ == nullptr)
+    {
+        return nullptr;
+    }
+    return head_->Data() + head_->readPos;
+}
+
+size_t ChainBuffer::PeekBytes() const
+{
+    if (head_ == nullptr)
+    {
+        return 0;
+    }
+    return head_->Readable();
+}
+
+const char *ChainBuffer::Linearize(size_t len)
+{
+    assert(len <= readable_);
+    if (len == 0 || PeekBytes() >= len)
+    {
+        return Peek();
+    }
+    // 前len字节拷贝到一个新块中放回链首，超过最大等级时分配独立的大块
+    Block *block = NewBlock_(len);
+    while (block->writePos < len)
+    {
+        size_t n = min(len - block->writePos, head_->Readable());
+        memcpy(block->Data() + block->writePos, head_->Data() + head_->readPos, n);
+        block->writePos += n;
+        head_->readPos += n;
+        if (head_->Readable() == 0)
+        {
+            PopFront_();
+        }
+    }
+    block->next = head_;
+    head_ = block;
+    if (tail_ == nullptr)
+    {
+        tail_ = block;
+    }
+    count_++;
+    return Peek();
+}
+
+bool ChainBuffer::Match_(const Block *block, size_t pos, const char *pat, size_t patLen) const
+{
+    for (size_t i = 0; i < patLen; i++, pos++)
+    {
+        while (pos == block->writePos)
+        {
+            block = block->next;
+            if (block == nullptr)
+            {
+                return false;
+            }
+            pos = block->readPos;
+        }
+        if (block->Data()[pos] != pat[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ChainBuffer::Find(const char *pat, size_t patLen) const
+{
+    assert(patLen > 0);
+    size_t offset = 0; // 当前块起始处相对可读数据的偏移
+    for (const Block *block = head_; block != nullptr; block = block->next)
+    {
+        const char *begin = block->Data() + block->readPos;
+        const char *end = block->Data() + block->writePos;
+        const char *p = begin;
+        while (p < end && (p = static_cast<const char *>(memchr(p, pat[0], end - p))) != nullptr)
+        {
+            if (Match_(block, p - block->Data(), pat, patLen))
+            {
+                return offset + (p - begin);
+            }
+            p++;
+        }
+        offset += end - begin;
+    }
+    return npos;
+}
+
+int ChainBuffer::PeekIov(struct iovec *iov, int maxCnt) const
+{
+    int cnt = 0;
+    for (const Block *block = head_; block != nullptr && cnt < maxCnt; block = block->next)
+    {
+        if (block->Readable() > 0)
+        {
+            iov[cnt].iov_base = const_cast<char *>(block->Data() + block->readPos);
+            iov[cnt].iov_len = block->Readable();
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+void ChainBuffer::Retrieve(size_t len)
+{
+    assert(len <= readable_);
+    readable_ -= len;
+    while (len > 0)
+    {
+        size_t n = min(len, head_->Readable());
+        head_->readPos += n;
+        len -= n;
+        if (head_->Readable() == 0)
+        {
+            PopFront_();
+        }
+    }
+}
+
+void ChainBuffer::RetrieveAll()
+{
+    while (head_ != nullptr)
+    {
+        PopFront_();
+    }
+    readable_ = 0;
+}
+
+void ChainBuffer::RetrieveTo(char *dst, size_t len)
+{
+    assert(len <= readable_);
+    size_t left = len;
+    for (const Block *block = head_; left > 0; block = block->next)
+    {
+        size_t n = min(left, block->Readable());
+        memcpy(dst, block->Data() + block->readPos, n);
+        dst += n;
+        left -= n;
+    }
+    Retrieve(len);
+}
+
+string ChainBuffer::RetrieveToStr(size_t len)
+{
+    string str(len, '\0');
+    if (len > 0)
+    {
+        RetrieveTo(&str[0], len);
+    }
+    return str;
+}
+
+string ChainBuffer::RetrieveAllToStr()
+{
+    return RetrieveToStr(readable_);
+}
+
+void ChainBuffer::Append(const string &str)
+{
+    Append(str.data(), str.size());
+}
+
+void ChainBuffer::Append(const char *str, size_t len)
+{
+    assert(str || len == 0);
+    while (len > 0)
+    {
+        if (tail_ == nullptr || tail_->writePos == tail_->cap)
+        {
+            // 新块按上一块翻倍增长，数据量大时直接取能容纳剩余数据的等级
+            size_t size = tail_ ? (tail_->cap + sizeof(Block)) * 2 : MIN_BLOCK;
+            size = min(max(size, len + sizeof(Block)), BlockPool::MAX_BLOCK);
+            PushBack_(NewBlock_(size - sizeof(Block)));
+        }
+        size_t n = min(len, tail_->cap - tail_->writePos);
+        memcpy(tail_->Data() + tail_->writePos, str, n);
+        tail_->writePos += n;
+        readable_ += n;
+        str += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::Append(ChainBuffer &other)
+{
+    if (&other == this || other.head_ == nullptr)
+    {
+        return;
+    }
+    if (tail_ == nullptr)
+    {
+        head_ = other.head_;
+    }
+    else
+    {
+        tail_->next = other.head_;
+    }
+    tail_ = other.tail_;
+    count_ += other.count_;
+    readable_ += other.readable_;
+    other.head_ = other.tail_ = nullptr;
+    other.count_ = 0;
+    other.readable_ = 0;
+}
+
+// 按FIONREAD预估的字节数借块，readv直接读入尾块剩余空间与新块
+// 预估之后到达的数据落入线程共享的溢出区再追加，每个字节至多拷贝一次
+ssize_t ChainBuffer::ReadFd(int fd, int *saveErrno)
+{
+    struct iovec iov[MAX_READ_BLOCKS + 2];
+    Block *blocks[MAX_READ_BLOCKS];
+    int cnt = 0, blockCnt = 0;
+    size_t tail = 0;
+    if (tail_ != nullptr && tail_->writePos < tail_->cap)
+    {
+        tail = tail_->cap - tail_->writePos;
+        iov[cnt].iov_base = tail_->Data() + tail_->writePos;
+        iov[cnt].iov_len = tail;
+        cnt++;
+    }
+
+    int pending = 0;
+    if (ioctl(fd, FIONREAD, &pending) < 0 || pending <= 0)
+    {
+        pending = (tail == 0) ? static_cast<int>(READ_BLOCK - sizeof(Block)) : 0;
+    }
+    size_t need = static_cast<size_t>(pending) > tail ? pending - tail : 0;
+    while (need > 0 && blockCnt < MAX_READ_BLOCKS)
+    {
+        Block *block = NewBlock_(min(need + sizeof(Block), BlockPool::MAX_BLOCK) - sizeof(Block));
+        blocks[blockCnt++] = block;
+        iov[cnt].iov_base = block->Data();
+        iov[cnt].iov_len = block->cap;
+        cnt++;
+        need -= min(need, block->cap);
+    }
+    char *overflow = BlockPool::ThreadOverflow();
+    iov[cnt].iov_base = overflow;
+    iov[cnt].iov_len = BlockPool::OVERFLOW_SIZE;
+    cnt++;
+
+    const ssize_t len = readv(fd, iov, cnt);
+    if (len < 0)
+    {
+        *saveErrno = errno;
+    }
+    size_t left = len > 0 ? len : 0;
+    if (tail > 0)
+    {
+        size_t n = min(left, tail);
+        tail_->writePos += n;
+        readable_ += n;
+        left -= n;
+    }
+    for (int i = 0; i < blockCnt; i++)
+    {
+        Block *block = blocks[i];
+        if (left == 0)
+        {
+            BlockPool::Instance()->Free(block, block->cap + sizeof(Block));
+            continue;
+        }
+        block->writePos = min(left, block->cap);
+        readable_ += block->writePos;
+        left -= block->writePos;
+        PushBack_(block);
+    }
+    if (left > 0)
+    {
+        Append(overflow, left);
+    }
+    return len;
+}
+
+ssize_t ChainBuffer::WriteFd(int fd, int *saveErrno)
+{
+    struct iovec iov[MAX_IOV];
+    int cnt = PeekIov(iov, MAX_IOV);
+    ssize_t len = writev(fd, iov, cnt);
+    if (len < 0)
+    {
+        *saveErrno = errno;
+        return len;
+    }
+    Retrieve(len);
+    return len;
+}
+
+// size为数据区大小，实际借出的块还包含块头
+ChainBuffer::Block *ChainBuffer::NewBlock_(size_t size)
+{
+    size_t cap = 0;
+    Block *block = static_cast<Block *>(BlockPool::Instance()->Alloc(size + sizeof(Block), cap));
+    block->next = nullptr;
+    block->cap = cap - sizeof(Block);
+    block->readPos = 0;
+    block->writePos = 0;
+    return block;
+}
+
+void ChainBuffer::PushBack_(Block *block)
+{
+    if (tail_ == nullptr)
+    {
+        head_ = block;
+    }
+    else
+    {
+        tail_->next = block;
+    }
+    tail_ = block;
+    count_++;
+}
+
+void ChainBuffer::PopFront_()
+{
+    Block *block = head_;
+    head_ = block->next;
+    if (head_ == nullptr)
+    {
+        tail_ = nullptr;
+    }
+    count_--;
+    BlockPool::Instance()->Free(block, block->cap + sizeof(Block));
+}
@@ -0,0 +1,81 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef CHAIN_BUFFER_H
+#define CHAIN_BUFFER_H
+
+#include <string>
+#include <sys/uio.h> // iovec
+
+// 分段缓冲区：由BlockPool中的内存块组成的单链表，块头保存在块内
+// 追加数据只写入尾块，扩容不搬移已有数据；读写fd时直接对各块做readv/writev
+// 数据取完即归还所有块，空闲连接的缓冲区不占用堆内存
+class ChainBuffer
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    ChainBuffer();
+    ~ChainBuffer();
+    ChainBuffer(const ChainBuffer &) = delete;
+    ChainBuffer &operator=(const ChainBuffer &) = delete;
+
+    size_t ReadableBytes() const;
+    size_t BlockCount() const;
+
+    // 首块中连续可读的部分
+    const char *Peek() const;
+    size_t PeekBytes() const;
+    // 保证前len字节连续并返回其起始地址，len不能超过ReadableBytes()
+    const char *Linearize(size_t len);
+    // 查找pat首次出现的偏移，可跨块匹配，未找到返回npos
+    size_t Find(const char *pat, size_t patLen) const;
+    // 将各块可读部分填入iov，返回使用的个数
+    int PeekIov(struct iovec *iov, int maxCnt) const;
+
+    void Retrieve(size_t len);
+    void RetrieveAll();
+    void RetrieveTo(char *dst, size_t len); // 拷出前len字节并取出
+    std::string RetrieveToStr(size_t len);
+    std::string RetrieveAllToStr();
+
+    void Append(const std::string &str);
+    void Append(const char *str, size_t len);
+    // 将other的全部块移到尾部，不拷贝数据，other被清空
+    void Append(ChainBuffer &other);
+
+    ssize_t ReadFd(int fd, int *Errno);
+    ssize_t WriteFd(int fd, int *Errno);
+
+private:
+    struct Block
+    {
+        Block *next;
+        size_t cap; // 数据区容量，不含块头
+        size_t readPos;
+        size_t writePos;
+
+        char *Data() { return reinterpret_cast<char *>(this + 1); }
+        const char *Data() const { return reinterpret_cast<const char *>(this + 1); }
+        size_t Readable() const { return writePos - readPos; }
+    };
+
+    static const int MAX_IOV = 64;
+    static const size_t MIN_BLOCK = 1024;      // 首块大小，容纳常见的响应头
+    static const size_t READ_BLOCK = 4 * 1024; // 无法获知待读字节数时新借的块
+    static const int MAX_READ_BLOCKS = 16;     // 单次ReadFd最多新借的块数
+
+    static Block *NewBlock_(size_t size);
+    void PushBack_(Block *block);
+    void PopFront_();
+    bool Match_(const Block *block, size_t pos, const char *pat, size_t patLen) const;
+
+    Block *head_;
+    Block *tail_;
+    size_t count_;
+    size_t readable_;
+};
+
+#endif // CHAIN_BUFFER_H
@@ -0,0 +1,107 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "credentialcache.h"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h> // CRYPTO_memcmp
+
+using namespace std;
+
+CredentialCache::CredentialCache()
+{
+    isOpen_ = false;
+    ttlMS_ = 0;
+    cache_ = nullptr;
+}
+
+CredentialCache *CredentialCache::Instance()
+{
+    static CredentialCache inst;
+    return &inst;
+}
+
+void CredentialCache::Init(int ttlMS, size_t capacity)
+{
+    if (ttlMS <= 0 || capacity == 0)
+    {
+        isOpen_ = false;
+        return;
+    }
+    unsigned char buf[32];
+    RAND_bytes(buf, sizeof(buf));
+    key_.assign(reinterpret_cast<char *>(buf), sizeof(buf));
+    ttlMS_ = ttlMS;
+    cache_.reset(new LruCache<string>(capacity));
+    isOpen_ = true;
+}
+
+string CredentialCache::Digest_(const string &pwd) const
+{
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLen = 0;
+    HMAC(EVP_sha256(), key_.data(), static_cast<int>(key_.size()),
+         reinterpret_cast<const unsigned char *>(pwd.data()), pwd.size(), mac, &macLen);
+    return string(reinterpret_cast<char *>(mac), macLen);
+}
+
+CredentialCache::RESULT CredentialCache::Lookup(const string &user, const string &pwd)
+{
+    if (!isOpen_)
+    {
+        return MISS;
+    }
+    string digest;
+    if (!cache_->Get(user, digest))
+    {
+        return MISS;
+    }
+    string given = Digest_(pwd);
+    if (given.size() != digest.size() || CRYPTO_memcmp(given.data(), digest.data(), digest.size()) != 0)
+    {
+        return MISMATCH;
+    }
+    return MATCH;
+}
+
+void CredentialCache::Insert(const string &user, const string &pwd)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+    cache_->Put(user, Digest_(pwd), ttlMS_);
+}
+
+void CredentialCache::Invalidate(const string &user)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+    cache_->Erase(user);
+}
+
+size_t CredentialCache::Size()
+{
+    return isOpen_ ? cache_->Size() : 0;
+}
+
+unsigned long long CredentialCache::Hits() const
+{
+    return isOpen_ ? cache_->Hits() : 0;
+}
+
+unsigned long long CredentialCache::Misses() const
+{
+    return isOpen_ ? cache_->Misses() : 0;
+}
+
+double CredentialCache::HitRatio() const
+{
+    return isOpen_ ? cache_->HitRatio() : 0.0;
+}
@@ -0,0 +1,52 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef CREDENTIAL_CACHE_H
+#define CREDENTIAL_CACHE_H
+
+#include <string>
+#include <memory>
+
+#include "lrucache.h"
+
+// 登录凭据缓存：用户名 -> 密码摘要，重复登录与注册查重无需访问MySQL
+// 只缓存数据库确认过的凭据，摘要使用进程内随机密钥的HMAC-SHA256，内存中不保留明文密码
+class CredentialCache
+{
+public:
+    enum RESULT
+    {
+        MISS,
+        MATCH,    // 用户存在且密码一致
+        MISMATCH, // 用户存在但密码不一致
+    };
+
+    static CredentialCache *Instance();
+
+    void Init(int ttlMS, size_t capacity = 65536);
+    bool IsOpen() const { return isOpen_; }
+
+    RESULT Lookup(const std::string &user, const std::string &pwd);
+    void Insert(const std::string &user, const std::string &pwd);
+    void Invalidate(const std::string &user); // 注册或修改密码时调用
+
+    size_t Size();
+    unsigned long long Hits() const;
+    unsigned long long Misses() const;
+    double HitRatio() const;
+
+private:
+    CredentialCache();
+    ~CredentialCache() = default;
+
+    std::string Digest_(const std::string &pwd) const;
+
+    bool isOpen_;
+    int ttlMS_;
+    std::string key_;
+    std::unique_ptr<LruCache<std::string>> cache_;
+};
+
+#endif // CREDENTIAL_CACHE_H
@@ -0,0 +1,217 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "listcache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "json/json.hpp"
+#include "log/log.h"
+
+using namespace std;
+
+const size_t ListCache::MAX_LISTING;
+
+ListCache::ListCache() : hits_(0), misses_(0)
+{
+    isOpen_ = false;
+    ttlMS_ = 0;
+    cache_ = nullptr;
+}
+
+ListCache *ListCache::Instance()
+{
+    static ListCache inst;
+    return &inst;
+}
+
+void ListCache::Init(int ttlMS, size_t capacity)
+{
+    if (ttlMS <= 0 || capacity == 0)
+    {
+        isOpen_ = false;
+        return;
+    }
+    ttlMS_ = ttlMS;
+    cache_.reset(new LruCache<EntryPtr>(capacity));
+    isOpen_ = true;
+}
+
+bool ListCache::DirMtime_(const string &dir, struct timespec &mtime)
+{
+    struct stat dirStat;
+    if (stat(dir.c_str(), &dirStat) != 0 || !S_ISDIR(dirStat.st_mode))
+    {
+        return false;
+    }
+    mtime = dirStat.st_mtim;
+    return true;
+}
+
+// 与DirListWriter的输出格式一致：{"fileName":...,"fileSize":...,"uploadDate":...}
+string ListCache::Item_(const string &name, size_t size, time_t mtime)
+{
+    nlohmann::json fileInfo;
+    fileInfo["fileName"] = name;
+    fileInfo["fileSize"] = static_cast<unsigned long long>(size);
+    fileInfo["uploadDate"] = static_cast<unsigned long long>(mtime);
+    return fileInfo.dump();
+}
+
+bool ListCache::Scan_(const string &dir, Entry &entry)
+{
+    DIR *dp = opendir(dir.c_str());
+    if (dp == nullptr)
+    {
+        return false;
+    }
+    entry.items.clear();
+    entry.bytes = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dp)) != nullptr)
+    {
+        if (ent->d_name[0] == '.') // 含上传中的临时文件
+        {
+            continue;
+        }
+        struct stat fileStat;
+        if (stat((dir + ent->d_name).c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+        {
+            continue;
+        }
+        string item = Item_(ent->d_name, fileStat.st_size, fileStat.st_mtime);
+        entry.bytes += item.size();
+        entry.items[ent->d_name] = move(item);
+    }
+    closedir(dp);
+    return true;
+}
+
+void ListCache::Build_(Entry &entry)
+{
+    if (entry.bytes + entry.items.size() + 1 > MAX_LISTING)
+    {
+        entry.listing.reset();
+        return;
+    }
+    shared_ptr<string> listing = make_shared<string>();
+    listing->reserve(entry.bytes + entry.items.size() + 1);
+    listing->push_back('[');
+    for (auto &it : entry.items)
+    {
+        if (listing->size() > 1)
+        {
+            listing->push_back(',');
+        }
+        listing->append(it.second);
+    }
+    listing->push_back(']');
+    entry.listing = listing;
+}
+
+ListCache::Listing ListCache::Get(const string &dir)
+{
+    if (!isOpen_)
+    {
+        return nullptr;
+    }
+    struct timespec mtime;
+    if (!DirMtime_(dir, mtime))
+    {
+        LOG_DEBUG("Try to create directory: %s", dir.c_str());
+        if (mkdir(dir.c_str(), 0777) != 0 || !DirMtime_(dir, mtime))
+        {
+            LOG_ERROR("Failed to create directory: %s", dir.c_str());
+            return nullptr;
+        }
+    }
+
+    EntryPtr entry;
+    bool cached = cache_->Get(dir, entry);
+    if (!cached)
+    {
+        entry = make_shared<Entry>();
+    }
+    lock_guard<mutex> locker(entry->mtx);
+    if (cached && entry->dirMtime.tv_sec == mtime.tv_sec && entry->dirMtime.tv_nsec == mtime.tv_nsec)
+    {
+        hits_++;
+        if (!entry->listing)
+        {
+            Build_(*entry);
+        }
+        return entry->listing;
+    }
+
+    // 先取mtime再扫描，扫描期间的修改在下次读取时被发现
+    misses_++;
+    if (!Scan_(dir, *entry))
+    {
+        cache_->Erase(dir);
+        return nullptr;
+    }
+    entry->dirMtime = mtime;
+    Build_(*entry);
+    if (!cached)
+    {
+        cache_->Put(dir, entry, ttlMS_);
+    }
+    return entry->listing;
+}
+
+// 已缓存的目录才需要更新，item为空表示删除；修改后记录新的目录mtime
+void ListCache::Modify_(const string &dir, const string &name, const string *item)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+    EntryPtr entry;
+    if (!cache_->Get(dir, entry))
+    {
+        return;
+    }
+    lock_guard<mutex> locker(entry->mtx);
+    if (!DirMtime_(dir, entry->dirMtime))
+    {
+        cache_->Erase(dir);
+        return;
+    }
+    auto it = entry->items.find(name);
+    if (it != entry->items.end())
+    {
+        entry->bytes -= it->second.size();
+        entry->items.erase(it);
+    }
+    if (item != nullptr)
+    {
+        entry->bytes += item->size();
+        entry->items[name] = *item;
+    }
+    entry->listing.reset();
+}
+
+void ListCache::Update(const string &dir, const string &name, size_t size, time_t mtime)
+{
+    string item = Item_(name, size, mtime);
+    Modify_(dir, name, &item);
+}
+
+void ListCache::Remove(const string &dir, const string &name)
+{
+    Modify_(dir, name, nullptr);
+}
+
+size_t ListCache::Size()
+{
+    return isOpen_ ? cache_->Size() : 0;
+}
+
+double ListCache::HitRatio() const
+{
+    unsigned long long hits = hits_, misses = misses_;
+    return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0;
+}
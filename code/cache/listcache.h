@@ -0,0 +1,69 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef LIST_CACHE_H
+#define LIST_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <memory>
+#include <time.h>
+
+#include "lrucache.h"
+
+// 用户目录文件列表的缓存：每个目录保存(文件名, 大小, 修改时间)索引和序列化后的JSON，
+// 上传与删除时增量更新，读取时用目录的修改时间校验，不一致则重新扫描目录
+// 目录约定只由本服务写入，mtime校验用于发现带外修改，精度取决于文件系统的时间戳
+class ListCache
+{
+public:
+    typedef std::shared_ptr<const std::string> Listing;
+
+    static ListCache *Instance();
+
+    void Init(int ttlMS = 600000, size_t capacity = 4096);
+    bool IsOpen() const { return isOpen_; }
+
+    // dir以'/'结尾，不存在时创建；返回空指针表示未缓存，由调用方逐项生成
+    Listing Get(const std::string &dir);
+    void Update(const std::string &dir, const std::string &name, size_t size, time_t mtime);
+    void Remove(const std::string &dir, const std::string &name);
+
+    size_t Size();
+    unsigned long long Hits() const { return hits_; }
+    unsigned long long Misses() const { return misses_; }
+    double HitRatio() const;
+
+    static const size_t MAX_LISTING = 4 * 1024 * 1024; // 超过该大小的列表不缓存
+
+private:
+    ListCache();
+    ~ListCache() = default;
+
+    struct Entry
+    {
+        std::mutex mtx;
+        struct timespec dirMtime;
+        std::map<std::string, std::string> items; // 文件名 -> 序列化后的列表项
+        size_t bytes;                             // 各项长度之和
+        Listing listing;                          // 为空表示需要重新拼接
+    };
+    typedef std::shared_ptr<Entry> EntryPtr;
+
+    static bool DirMtime_(const std::string &dir, struct timespec &mtime);
+    static bool Scan_(const std::string &dir, Entry &entry);
+    static std::string Item_(const std::string &name, size_t size, time_t mtime);
+    static void Build_(Entry &entry);
+    void Modify_(const std::string &dir, const std::string &name, const std::string *item);
+
+    bool isOpen_;
+    int ttlMS_;
+    std::unique_ptr<LruCache<EntryPtr>> cache_;
+    std::atomic<unsigned long long> hits_;
+    std::atomic<unsigned long long> misses_;
+};
+
+#endif // LIST_CACHE_H
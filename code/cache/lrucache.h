@@ -0,0 +1,172 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <assert.h>
+
+// 分片加锁、带过期时间的LRU缓存，键为字符串
+template <class V>
+class LruCache
+{
+public:
+    explicit LruCache(size_t capacity = 65536, size_t shardNum = 16);
+    ~LruCache() = default;
+
+    bool Get(const std::string &key, V &value);
+    void Put(const std::string &key, const V &value, int ttlMS);
+    void Erase(const std::string &key);
+    void Clear();
+
+    size_t Size();
+    size_t Capacity() const { return shardCap_ * shards_.size(); }
+    unsigned long long Hits() const { return hits_; }
+    unsigned long long Misses() const { return misses_; }
+    double HitRatio() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Node
+    {
+        std::string key;
+        V value;
+        Clock::time_point expires;
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::list<Node> lru; // 头部为最近使用
+        std::unordered_map<std::string, typename std::list<Node>::iterator> index;
+    };
+
+    Shard &GetShard_(const std::string &key);
+
+    size_t shardCap_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<unsigned long long> hits_;
+    std::atomic<unsigned long long> misses_;
+};
+
+template <class V>
+LruCache<V>::LruCache(size_t capacity, size_t shardNum) : hits_(0), misses_(0)
+{
+    assert(capacity > 0 && shardNum > 0);
+    shardCap_ = (capacity + shardNum - 1) / shardNum;
+    for (size_t i = 0; i < shardNum; i++)
+    {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+template <class V>
+typename LruCache<V>::Shard &LruCache<V>::GetShard_(const std::string &key)
+{
+    // 高位选分片，避免与分片内哈希桶的取模相关
+    size_t h = std::hash<std::string>()(key);
+    return *shards_[(h >> 16) % shards_.size()];
+}
+
+template <class V>
+bool LruCache<V>::Get(const std::string &key, V &value)
+{
+    Shard &shard = GetShard_(key);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+    {
+        misses_++;
+        return false;
+    }
+    if (it->second->expires <= Clock::now())
+    {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        misses_++;
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    value = it->second->value;
+    hits_++;
+    return true;
+}
+
+template <class V>
+void LruCache<V>::Put(const std::string &key, const V &value, int ttlMS)
+{
+    Shard &shard = GetShard_(key);
+    Clock::time_point expires = Clock::now() + std::chrono::milliseconds(ttlMS);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        it->second->value = value;
+        it->second->expires = expires;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+    shard.lru.push_front(Node{key, value, expires});
+    shard.index[key] = shard.lru.begin();
+    if (shard.lru.size() > shardCap_)
+    {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+    }
+}
+
+template <class V>
+void LruCache<V>::Erase(const std::string &key)
+{
+    Shard &shard = GetShard_(key);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+template <class V>
+void LruCache<V>::Clear()
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> locker(shard->mtx);
+        shard->index.clear();
+        shard->lru.clear();
+    }
+}
+
+template <class V>
+size_t LruCache<V>::Size()
+{
+    size_t size = 0;
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> locker(shard->mtx);
+        size += shard->lru.size();
+    }
+    return size;
+}
+
+template <class V>
+double LruCache<V>::HitRatio() const
+{
+    unsigned long long hits = hits_, misses = misses_;
+    return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0;
+}
+
+#endif // LRU_CACHE_H
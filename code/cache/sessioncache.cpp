@@ -0,0 +1,101 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "sessioncache.h"
+
+#include <algorithm>
+
+using namespace std;
+
+SessionCache::SessionCache()
+{
+    isOpen_ = false;
+    ttlMS_ = 0;
+    negTtlMS_ = 0;
+    cache_ = nullptr;
+}
+
+SessionCache *SessionCache::Instance()
+{
+    static SessionCache inst;
+    return &inst;
+}
+
+void SessionCache::Init(int ttlMS, int negTtlMS, size_t capacity)
+{
+    if (ttlMS <= 0 || capacity == 0)
+    {
+        isOpen_ = false;
+        return;
+    }
+    ttlMS_ = ttlMS;
+    negTtlMS_ = min(max(negTtlMS, 0), ttlMS); // 失败结果的缓存时间不超过成功结果
+    cache_.reset(new LruCache<Entry>(capacity));
+    isOpen_ = true;
+}
+
+SessionCache::RESULT SessionCache::Lookup(const string &sid, string &user)
+{
+    if (!isOpen_)
+    {
+        return MISS;
+    }
+    Entry entry;
+    if (!cache_->Get(sid, entry))
+    {
+        return MISS;
+    }
+    if (!entry.valid)
+    {
+        return INVALID;
+    }
+    user = entry.user;
+    return VALID;
+}
+
+void SessionCache::Insert(const string &sid, bool valid, const string &user)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+    if (valid)
+    {
+        cache_->Put(sid, Entry{true, user}, ttlMS_);
+    }
+    else if (negTtlMS_ > 0)
+    {
+        cache_->Put(sid, Entry{false, ""}, negTtlMS_);
+    }
+}
+
+void SessionCache::Invalidate(const string &sid)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+    cache_->Erase(sid);
+}
+
+size_t SessionCache::Size()
+{
+    return isOpen_ ? cache_->Size() : 0;
+}
+
+unsigned long long SessionCache::Hits() const
+{
+    return isOpen_ ? cache_->Hits() : 0;
+}
+
+unsigned long long SessionCache::Misses() const
+{
+    return isOpen_ ? cache_->Misses() : 0;
+}
+
+double SessionCache::HitRatio() const
+{
+    return isOpen_ ? cache_->HitRatio() : 0.0;
+}
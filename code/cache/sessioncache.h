@@ -0,0 +1,55 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef SESSION_CACHE_H
+#define SESSION_CACHE_H
+
+#include <string>
+#include <memory>
+
+#include "lrucache.h"
+
+// 进程内session缓存：session_id -> 用户名，缓存Redis校验的成功与失败结果
+class SessionCache
+{
+public:
+    enum RESULT
+    {
+        MISS,
+        VALID,
+        INVALID,
+    };
+
+    static SessionCache *Instance();
+
+    void Init(int ttlMS, int negTtlMS = 5000, size_t capacity = 65536);
+    bool IsOpen() const { return isOpen_; }
+
+    RESULT Lookup(const std::string &sid, std::string &user);
+    void Insert(const std::string &sid, bool valid, const std::string &user);
+    void Invalidate(const std::string &sid);
+
+    size_t Size();
+    unsigned long long Hits() const;
+    unsigned long long Misses() const;
+    double HitRatio() const;
+
+private:
+    SessionCache();
+    ~SessionCache() = default;
+
+    struct Entry
+    {
+        bool valid;
+        std::string user;
+    };
+
+    bool isOpen_;
+    int ttlMS_;
+    int negTtlMS_;
+    std::unique_ptr<LruCache<Entry>> cache_;
+};
+
+#endif // SESSION_CACHE_H
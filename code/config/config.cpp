@@ -19,16 +19,31 @@ Config::Config()
     sr_optLinger = false;  // 优雅退出 -L
     sr_optIPv6 = false;    // 双栈支持 -I
     sr_connPoolNum = 12;  // 连接池数量 -C 12
+    sr_connPoolTimeoutMS = 500; // 获取连接最多等待500ms，超时返回503 -w 500
+    sr_connPoolMinReady = 1;    // 每个连接池就绪1个连接即开始服务，其余后台建立，0为全部就绪 -m 1
+    sr_redisAsyncNum = 2;       // session查询使用2个异步Redis连接，0为同步查询 -A 2
+    sr_sessionCacheSec = 30; // session缓存30s，0为关闭 -c 30
+    sr_credCacheSec = 300;   // 登录凭据缓存300s，0为关闭 -U 300
+    sr_sessionMode = 0;      // session模式 0 Redis, 1 签名token, 2 签名token+Redis吊销 -S 0
+    sr_sessionKey = "";      // token签名密钥，为空时随机生成 -K <key>
+    sr_storeBackend = 0;     // 存储后端 0 MySQL+Redis, 1 进程内存 -B 0
+    sr_dedupStore = false;   // 上传文件按内容去重存储 -o
     sr_threadNum = 8;     // 线程池数量 -T 8
+    sr_fileIoThreadNum = 4; // 文件I/O线程池数量，0为在工作线程中读写磁盘 -F 4
     sr_enableLog = false;  // 日志开关 -l
     sr_logLevel = 1;      // 日志等级 -D 1
     sr_logQueSize = 1024; // 日志异步队列容量 -q 1024
+    sr_logFileMB = 64;    // 单个日志文件64MB -r 64
+    sr_logFileNum = 10;   // 保留10个历史日志文件 -n 10
+    sr_logCompress = false; // 历史日志压缩 -z
+    sr_enableAccessLog = false; // 访问日志开关 -a
+    sr_accessLogFormat = 1;     // 访问日志格式 -a 1
 }
 
 void Config::parse_arg(int argc, char *argv[])
 {
     int opt;
-    const char *str = "dp:e:t:LIC:T:lD:q:h";
+    const char *str = "dp:e:t:LIC:w:m:A:c:U:S:K:B:oT:F:lD:q:r:n:za:h";
     while ((opt = getopt(argc, argv, str)) != -1)
     {
         switch (opt)
@@ -68,11 +83,61 @@ void Config::parse_arg(int argc, char *argv[])
             sr_connPoolNum = atoi(optarg);
             break;
         }
+        case 'w':
+        {
+            sr_connPoolTimeoutMS = atoi(optarg);
+            break;
+        }
+        case 'm':
+        {
+            sr_connPoolMinReady = atoi(optarg);
+            break;
+        }
+        case 'A':
+        {
+            sr_redisAsyncNum = atoi(optarg);
+            break;
+        }
+        case 'c':
+        {
+            sr_sessionCacheSec = atoi(optarg);
+            break;
+        }
+        case 'U':
+        {
+            sr_credCacheSec = atoi(optarg);
+            break;
+        }
+        case 'S':
+        {
+            sr_sessionMode = atoi(optarg);
+            break;
+        }
+        case 'K':
+        {
+            sr_sessionKey = optarg;
+            break;
+        }
+        case 'B':
+        {
+            sr_storeBackend = atoi(optarg);
+            break;
+        }
+        case 'o':
+        {
+            sr_dedupStore = true;
+            break;
+        }
         case 'T':
         {
             sr_threadNum = atoi(optarg);
             break;
         }
+        case 'F':
+        {
+            sr_fileIoThreadNum = atoi(optarg);
+            break;
+        }
         case 'l':
         {
             sr_enableLog = true;
@@ -88,6 +153,27 @@ void Config::parse_arg(int argc, char *argv[])
             sr_logQueSize = atoi(optarg);
             break;
         }
+        case 'r':
+        {
+            sr_logFileMB = atoi(optarg);
+            break;
+        }
+        case 'n':
+        {
+            sr_logFileNum = atoi(optarg);
+            break;
+        }
+        case 'z':
+        {
+            sr_logCompress = true;
+            break;
+        }
+        case 'a':
+        {
+            sr_enableAccessLog = true;
+            sr_accessLogFormat = atoi(optarg);
+            break;
+        }
         case 'h':
         {
             cout << " -p <port>          port" << endl;
@@ -96,10 +182,24 @@ void Config::parse_arg(int argc, char *argv[])
             cout << " -L                 enable linger" << endl;
             cout << " -I                 enable IPv6" << endl;
             cout << " -C <num>           mysql connection pool num" << endl;
+            cout << " -w <ms>            connection pool acquire timeout, 503 when exceeded" << endl;
+            cout << " -m <num>           connections per pool ready before serving, 0 for all" << endl;
+            cout << " -A <num>           async redis connections for session lookup, 0 for blocking pool" << endl;
+            cout << " -c <sec>           session cache ttl, 0 for disable" << endl;
+            cout << " -U <sec>           login credential cache ttl, 0 for disable" << endl;
+            cout << " -S <mode>          session mode : 0 redis, 1 signed token, 2 signed token + redis revocation" << endl;
+            cout << " -K <key>           session token key, random if empty" << endl;
+            cout << " -B <backend>       user/session store : 0 mysql + redis, 1 in-memory" << endl;
+            cout << " -o                 content-addressed dedup storage for uploads" << endl;
             cout << " -T <threadnum>     threadnum" << endl;
+            cout << " -F <threadnum>     file I/O threadnum, 0 for worker threads" << endl;
             cout << " -l                 enable log" << endl;
             cout << " -D <level>         log level : 0 DEBUG, 1 INFO, 2 WARN, 3 ERROR" << endl;
             cout << " -q <capacity>      log que capacity" << endl;
+            cout << " -r <MB>            log file max size, 0 for unlimited" << endl;
+            cout << " -n <num>           log history files to keep" << endl;
+            cout << " -z                 gzip rotated log files" << endl;
+            cout << " -a <format>        enable access log : 0 common, 1 combined, 2 json" << endl;
             cout << " -d                 run as a daemon" << endl;
             exit(EXIT_SUCCESS);
         }
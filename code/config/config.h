@@ -16,10 +16,25 @@ public:
     bool sr_optLinger;  // Linger选项
     bool sr_optIPv6;    // 双栈支持选项
     int sr_connPoolNum; // 连接池数量
+    int sr_connPoolTimeoutMS; // 获取连接等待上限
+    int sr_connPoolMinReady;  // 启动时至少就绪的连接数
+    int sr_redisAsyncNum;     // 异步Redis连接数
+    int sr_sessionCacheSec; // session缓存时间
+    int sr_credCacheSec;    // 登录凭据缓存时间
+    int sr_sessionMode;     // session模式
+    const char *sr_sessionKey; // token签名密钥
+    int sr_storeBackend;       // 用户与session存储后端
+    bool sr_dedupStore;        // 去重存储开关
     int sr_threadNum;   // 线程池数量
+    int sr_fileIoThreadNum; // 文件I/O线程池数量
     bool sr_enableLog;  // 日志开关
     int sr_logLevel;    // 日志等级
     int sr_logQueSize;  // 日志异步队列容量
+    int sr_logFileMB;   // 单个日志文件大小上限(MB)
+    int sr_logFileNum;  // 保留的历史日志文件数
+    bool sr_logCompress; // 历史日志压缩开关
+    bool sr_enableAccessLog; // 访问日志开关
+    int sr_accessLogFormat;  // 访问日志格式
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "bodywriter.h"
+
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "json/json.hpp"
+#include "log/log.h"
+
+using namespace std;
+
+const size_t BodyWriter::SEGMENT_SIZE;
+
+DirListWriter::DirListWriter(const string &path) : path_(path), started_(false), count_(0)
+{
+    dir_ = opendir(path_.c_str());
+    if (dir_ == nullptr)
+    {
+        LOG_DEBUG("Try to create directory: %s", path_.c_str());
+        if (mkdir(path_.c_str(), 0777) != 0)
+        {
+            LOG_ERROR("Failed to create directory: %s", path_.c_str());
+            return;
+        }
+        dir_ = opendir(path_.c_str());
+    }
+}
+
+DirListWriter::~DirListWriter()
+{
+    if (dir_ != nullptr)
+    {
+        closedir(dir_);
+    }
+}
+
+// 输出格式：[{"fileName":...,"fileSize":...,"uploadDate":...},...]
+bool DirListWriter::Next(ChainBuffer &buff)
+{
+    size_t start = buff.ReadableBytes();
+    if (!started_)
+    {
+        started_ = true;
+        buff.Append("[", 1);
+    }
+    struct dirent *entry = nullptr;
+    while (dir_ != nullptr && buff.ReadableBytes() - start < SEGMENT_SIZE && (entry = readdir(dir_)) != nullptr)
+    {
+        if (entry->d_name[0] == '.') // 含上传中的临时文件
+        {
+            continue;
+        }
+
+        string entryPath = path_ + entry->d_name;
+        struct stat fileStat;
+        if (stat(entryPath.c_str(), &fileStat) != 0)
+        {
+            LOG_ERROR("Failed to get file stat for: %s", entryPath.c_str());
+            continue;
+        }
+
+        if (S_ISREG(fileStat.st_mode))
+        {
+            nlohmann::json fileInfo;
+            fileInfo["fileName"] = entry->d_name;
+            fileInfo["fileSize"] = static_cast<unsigned long long>(fileStat.st_size);
+            fileInfo["uploadDate"] = static_cast<unsigned long long>(fileStat.st_mtime);
+            if (count_++ > 0)
+            {
+                buff.Append(",", 1);
+            }
+            buff.Append(fileInfo.dump());
+        }
+    }
+    if (dir_ != nullptr && entry != nullptr)
+    {
+        return true;
+    }
+    buff.Append("]", 1);
+    return false;
+}
+
+bool SharedBodyWriter::Next(ChainBuffer &buff)
+{
+    size_t len = min(SEGMENT_SIZE, body_->size() - pos_);
+    buff.Append(body_->data() + pos_, len);
+    pos_ += len;
+    return pos_ < body_->size();
+}
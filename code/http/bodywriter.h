@@ -0,0 +1,58 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef BODY_WRITER_H
+#define BODY_WRITER_H
+
+#include <string>
+#include <memory>
+#include <dirent.h>
+
+#include "buffer/chainbuffer.h"
+
+// 分段生成的响应体：连接可写时才生成下一段，直接追加到输出缓冲区，
+// 写缓冲区中只保留有限的待发送数据
+class BodyWriter
+{
+public:
+    virtual ~BodyWriter() = default;
+    // 向buff追加下一段数据，返回false表示已全部生成
+    virtual bool Next(ChainBuffer &buff) = 0;
+
+    static const size_t SEGMENT_SIZE = 8 * 1024; // 每段的目标大小
+};
+
+// 用户目录的文件列表，按JSON数组逐项输出
+class DirListWriter : public BodyWriter
+{
+public:
+    explicit DirListWriter(const std::string &path); // path以'/'结尾，不存在时创建
+    ~DirListWriter();
+    DirListWriter(const DirListWriter &) = delete;
+    DirListWriter &operator=(const DirListWriter &) = delete;
+
+    bool Next(ChainBuffer &buff) override;
+
+private:
+    std::string path_;
+    DIR *dir_;
+    bool started_;
+    size_t count_; // 已输出的项数
+};
+
+// 已生成好的共享响应体，如缓存的文件列表；按段复制，生成期间内容不变
+class SharedBodyWriter : public BodyWriter
+{
+public:
+    explicit SharedBodyWriter(std::shared_ptr<const std::string> body) : body_(std::move(body)), pos_(0) {}
+
+    bool Next(ChainBuffer &buff) override;
+
+private:
+    std::shared_ptr<const std::string> body_;
+    size_t pos_;
+};
+
+#endif // BODY_WRITER_H
@@ -0,0 +1,149 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "chunked.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const size_t ChunkedDecoder::MAX_LINE;
+
+ChunkedDecoder::ChunkedDecoder() : state_(SIZE_LINE), remain_(0), total_(0), maxChunk_(0), maxBody_(0) {}
+
+void ChunkedDecoder::Reset(size_t maxChunk, size_t maxBody)
+{
+    state_ = SIZE_LINE;
+    remain_ = 0;
+    total_ = 0;
+    maxChunk_ = maxChunk;
+    maxBody_ = maxBody;
+}
+
+ChunkedDecoder::STATUS ChunkedDecoder::Next(ChainBuffer &buff, size_t &len)
+{
+    while (true)
+    {
+        switch (state_)
+        {
+        case SIZE_LINE:
+        {
+            const char *line = nullptr;
+            size_t lineLen = 0;
+            STATUS st = ReadLine_(buff, line, lineLen);
+            if (st != DATA)
+            {
+                return st;
+            }
+            bool valid = ParseSize_(line, lineLen, remain_);
+            buff.Retrieve(lineLen + 2);
+            if (!valid || remain_ > maxChunk_ || remain_ > maxBody_ - total_)
+            {
+                return ERROR;
+            }
+            state_ = remain_ > 0 ? CHUNK_DATA : TRAILER;
+            break;
+        }
+        case CHUNK_DATA:
+            if (remain_ == 0)
+            {
+                state_ = DATA_CRLF;
+                break;
+            }
+            len = min(remain_, buff.PeekBytes());
+            if (len == 0)
+            {
+                return NEED_MORE;
+            }
+            remain_ -= len;
+            total_ += len;
+            return DATA;
+        case DATA_CRLF:
+        {
+            if (buff.ReadableBytes() < 2)
+            {
+                return NEED_MORE;
+            }
+            const char *crlf = buff.Linearize(2);
+            if (crlf[0] != '\r' || crlf[1] != '\n')
+            {
+                return ERROR;
+            }
+            buff.Retrieve(2);
+            state_ = SIZE_LINE;
+            break;
+        }
+        case TRAILER: // trailer中的头部不使用，读到空行为止
+        {
+            const char *line = nullptr;
+            size_t lineLen = 0;
+            STATUS st = ReadLine_(buff, line, lineLen);
+            if (st != DATA)
+            {
+                return st;
+            }
+            buff.Retrieve(lineLen + 2);
+            if (lineLen == 0)
+            {
+                state_ = FINISHED;
+            }
+            break;
+        }
+        case FINISHED:
+            return DONE;
+        }
+    }
+}
+
+// 找到一行时line指向其连续的内容(不含CRLF)，由调用方连同CRLF一并取出
+ChunkedDecoder::STATUS ChunkedDecoder::ReadLine_(ChainBuffer &buff, const char *&line, size_t &len)
+{
+    size_t pos = buff.Find("\r\n", 2);
+    if (pos == ChainBuffer::npos)
+    {
+        return buff.ReadableBytes() > MAX_LINE ? ERROR : NEED_MORE;
+    }
+    if (pos > MAX_LINE)
+    {
+        return ERROR;
+    }
+    line = buff.Linearize(pos + 2);
+    len = pos;
+    return DATA;
+}
+
+// 十六进制块大小，其后可带";"开头的扩展
+bool ChunkedDecoder::ParseSize_(const char *line, size_t len, size_t &size)
+{
+    size = 0;
+    size_t i = 0;
+    for (; i < len; ++i)
+    {
+        char c = line[i];
+        int v;
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else
+            break;
+        if (i >= 15) // 超过15位十六进制必然超出限制，避免溢出
+        {
+            return false;
+        }
+        size = size * 16 + v;
+    }
+    if (i == 0)
+    {
+        return false;
+    }
+    while (i < len && (line[i] == ' ' || line[i] == '\t'))
+    {
+        ++i;
+    }
+    return i == len || line[i] == ';';
+}
@@ -0,0 +1,55 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef CHUNKED_H
+#define CHUNKED_H
+
+#include <stddef.h>
+
+#include "buffer/chainbuffer.h"
+
+// Transfer-Encoding: chunked 请求体的增量解码器
+// 每次从缓冲区中取出分帧字节，并报告紧随其后可直接使用的一段数据
+class ChunkedDecoder
+{
+public:
+    enum STATUS
+    {
+        DATA,      // buff开头的len字节为消息体数据，调用方处理后须自行取出
+        NEED_MORE, // 等待更多数据
+        DONE,      // 最后一个块及trailer已读完
+        ERROR,     // 格式错误或超出限制
+    };
+
+    ChunkedDecoder();
+
+    void Reset(size_t maxChunk, size_t maxBody);
+    STATUS Next(ChainBuffer &buff, size_t &len);
+
+    size_t BodyBytes() const { return total_; }
+
+    static const size_t MAX_LINE = 1024; // 块大小行(含扩展)与trailer行的长度上限
+
+private:
+    enum STATE
+    {
+        SIZE_LINE,
+        CHUNK_DATA,
+        DATA_CRLF,
+        TRAILER,
+        FINISHED,
+    };
+
+    static bool ParseSize_(const char *line, size_t len, size_t &size);
+    STATUS ReadLine_(ChainBuffer &buff, const char *&line, size_t &len);
+
+    STATE state_;
+    size_t remain_;   // 当前块剩余的数据字节
+    size_t total_;    // 已解码的消息体字节
+    size_t maxChunk_; // 单个块的上限
+    size_t maxBody_;  // 消息体总长的上限
+};
+
+#endif // CHUNKED_H
@@ -12,6 +12,7 @@
 #include <sys/sendfile.h> // sendfile
 
 #include "log/log.h"
+#include "log/accesslog.h"
 #include "pool/connRAII.h"
 
 using namespace std;
@@ -19,13 +20,23 @@ using namespace std;
 string HttpConn::resDir;
 string HttpConn::dataDir;
 atomic<int> HttpConn::userCount;
+atomic<uint64_t> HttpConn::nextId;
 bool HttpConn::isET;
+const int HttpConn::MAX_IOV;
+const size_t HttpConn::STREAM_LOW_WATER;
 
 HttpConn::HttpConn()
 {
     fd_ = -1;
+    id_ = 0;
     addr_ = {0};
+    fileIov_.iov_base = nullptr;
+    fileIov_.iov_len = 0;
     isClose_ = true;
+    busy_ = false;
+    reqTiming_ = false;
+    responding_ = false;
+    bytesSent_ = 0;
 };
 
 HttpConn::~HttpConn()
@@ -39,17 +50,27 @@ void HttpConn::Init(int fd, const sockaddr_storage &addr)
     userCount++;
     addr_ = addr;
     fd_ = fd;
+    id_ = ++nextId;
     writeBuff_.RetrieveAll();
     readBuff_.RetrieveAll();
+    fileIov_.iov_base = nullptr;
+    fileIov_.iov_len = 0;
     request_.Init(resDir, dataDir);
     isClose_ = false;
+    busy_ = false;
+    reqTiming_ = false;
+    responding_ = false;
+    bytesSent_ = 0;
     LOG_INFO("Client[%d](%s:%d) in, userCount:%d", fd_, GetIP().c_str(), GetPort(), (int)userCount);
 }
 
 void HttpConn::Close()
 {
+    LogAccess_(); // 响应未发送完毕即断开的请求也记录
+    request_.Release();
     response_.UnmapFile();
     response_.CloseFile();
+    response_.CloseWriter();
     if (isClose_ == false)
     {
         isClose_ = true;
@@ -105,9 +126,17 @@ ssize_t HttpConn::read(int *saveErrno)
 {
     ssize_t len = -1;
     // 如果是LT模式，那么只读取一次，如果是ET模式，会一直读取，直到读不出数据
+    // 原始上传的消息体不经过读缓冲区，由socket直接splice到文件
     do
     {
-        len = readBuff_.ReadFd(fd_, saveErrno);
+        if (readBuff_.ReadableBytes() == 0 && request_.CanSplice())
+        {
+            len = request_.SpliceBody(fd_, saveErrno);
+        }
+        else
+        {
+            len = readBuff_.ReadFd(fd_, saveErrno);
+        }
         if (len <= 0)
         {
             break;
@@ -121,15 +150,22 @@ ssize_t HttpConn::write(int *saveErrno)
     ssize_t len = -1;
     do
     {
-        if (iovCnt_ == 1 && iov_[0].iov_len == 0 && iov_[1].iov_len > 0) // SENDFILE
+        size_t buffLen = writeBuff_.ReadableBytes();
+        if (buffLen == 0 && fileIov_.iov_base == nullptr) // SENDFILE
         {
-            off_t offset = response_.FileLen() - iov_[1].iov_len;
-            len = sendfile(fd_, response_.FileFd(), &offset, response_.FileLen());
-            iov_[1].iov_len -= len;
+            off_t offset = response_.FileLen() - fileIov_.iov_len;
+            len = sendfile(fd_, response_.FileFd(), &offset, fileIov_.iov_len);
         }
         else
         {
-            len = writev(fd_, iov_, iovCnt_);
+            // 响应头与JSON等内容直接从写缓冲区各块发送，文件部分附在最后
+            struct iovec iov[MAX_IOV];
+            int cnt = writeBuff_.PeekIov(iov, MAX_IOV - 1);
+            if (fileIov_.iov_base != nullptr && fileIov_.iov_len > 0) // MMAP
+            {
+                iov[cnt++] = fileIov_;
+            }
+            len = writev(fd_, iov, cnt);
         }
 
         if (len <= 0)
@@ -137,26 +173,23 @@ ssize_t HttpConn::write(int *saveErrno)
             *saveErrno = errno;
             break;
         }
+        bytesSent_ += len;
 
-        if (ToWriteBytes() == 0)
-        {
-            break; // 传输结束
-        }
-        else if (iovCnt_ > 1 && static_cast<size_t>(len) > iov_[0].iov_len) // MMAP
+        size_t fromBuff = min(static_cast<size_t>(len), buffLen);
+        writeBuff_.Retrieve(fromBuff);
+        size_t fromFile = len - fromBuff;
+        if (fromFile > 0)
         {
-            iov_[1].iov_base = (uint8_t *)iov_[1].iov_base + (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if (iov_[0].iov_len)
+            if (fileIov_.iov_base != nullptr)
             {
-                writeBuff_.RetrieveAll();
-                iov_[0].iov_len = 0;
+                fileIov_.iov_base = (uint8_t *)fileIov_.iov_base + fromFile;
             }
+            fileIov_.iov_len -= fromFile;
         }
-        else if (iov_[0].iov_len != 0)
+        // 写缓冲区将空时才生成下一段，响应体未生成完毕时写缓冲区总不为空
+        if (response_.Streaming() && writeBuff_.ReadableBytes() < STREAM_LOW_WATER)
         {
-            iov_[0].iov_base = (uint8_t *)iov_[0].iov_base + len;
-            iov_[0].iov_len -= len;
-            writeBuff_.Retrieve(len);
+            response_.ProduceBody(writeBuff_);
         }
     } while (ToWriteBytes() > 0);
 
@@ -164,23 +197,69 @@ ssize_t HttpConn::write(int *saveErrno)
     {
         response_.CloseFile();
         response_.UnmapFile();
+        LogAccess_();
     }
     return len;
 }
 
-bool HttpConn::process()
+void HttpConn::LogAccess_()
 {
-    if (request_.State() == HttpRequest::FINISH)
+    if (!responding_)
     {
-        request_.Init(resDir, dataDir);
+        return;
     }
+    responding_ = false;
+    reqTiming_ = false;
 
-    if (readBuff_.ReadableBytes() <= 0)
+    AccessLog *accessLog = AccessLog::Instance();
+    if (!accessLog->IsOpen())
     {
-        return false;
+        return;
+    }
+    AccessRecord rec;
+    rec.clientIP = GetIP();
+    rec.user = request_.userInfo();
+    rec.method = request_.methodStr();
+    rec.path = request_.url();
+    rec.version = request_.version();
+    rec.referer = request_.GetHeader(HttpRequest::HDR_REFERER);
+    rec.userAgent = request_.GetHeader(HttpRequest::HDR_USER_AGENT);
+    rec.status = response_.Code();
+    rec.bytesSent = bytesSent_;
+    rec.latencyUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - reqStart_).count();
+    rec.upstreamUs = request_.upstreamUs();
+    accessLog->Append(rec);
+}
+
+bool HttpConn::process()
+{
+    HttpRequest::HTTP_CODE processStatus;
+    if (request_.IsSuspended() || request_.IsDiskWait())
+    {
+        processStatus = request_.Resume(readBuff_); // 异步session查询已返回，或已转到文件I/O线程
     }
+    else
+    {
+        if (request_.State() == HttpRequest::FINISH)
+        {
+            request_.Init(resDir, dataDir);
+        }
 
-    HttpRequest::HTTP_CODE processStatus = request_.parse(readBuff_);
+        // splice写入的消息体不经过读缓冲区，消息体阶段即使缓冲区为空也要检查是否已结束
+        if (readBuff_.ReadableBytes() <= 0 && request_.State() != HttpRequest::BODY)
+        {
+            return false;
+        }
+
+        if (!reqTiming_) // 新请求的首个数据包
+        {
+            reqTiming_ = true;
+            reqStart_ = chrono::steady_clock::now();
+            bytesSent_ = 0;
+        }
+
+        processStatus = request_.parse(readBuff_);
+    }
     int statusCode = 0;
     bool isKeepAlive = request_.IsKeepAlive();
 
@@ -198,13 +277,25 @@ bool HttpConn::process()
         statusCode = 401;
         LOG_DEBUG("Client[%d] req:unauth auth:need", fd_);
         break;
+    case HttpRequest::METHOD_NOT_ALLOWED:
+        statusCode = 405;
+        isKeepAlive = false; // 消息体未读取
+        LOG_DEBUG("Client[%d] req:method not allowed", fd_);
+        break;
     case HttpRequest::INTERNAL_ERROR:
         statusCode = 500;
         LOG_DEBUG("Client[%d] req:internal error", fd_);
         break;
+    case HttpRequest::SERVICE_UNAVAILABLE:
+        statusCode = 503;
+        LOG_DEBUG("Client[%d] req:service unavailable", fd_);
+        break;
     case HttpRequest::NO_REQUEST:
         LOG_DEBUG("Client[%d] req:wait next...", fd_);
         return false;
+    case HttpRequest::PENDING_REQUEST:
+        LOG_DEBUG("Client[%d] req:wait %s...", fd_, request_.IsDiskWait() ? "disk" : "session");
+        return false;
     default: // BAD_REQUEST
         statusCode = 400;
         isKeepAlive = false;
@@ -212,37 +303,28 @@ bool HttpConn::process()
     }
 
     response_.Init(request_.reqType(), request_.reqRes(), request_.authState(), request_.authInfo(), resDir, isKeepAlive, statusCode);
+    response_.SetBodyWriter(request_.TakeBodyWriter(), request_.version() == "1.1");
     response_.MakeResponse(writeBuff_);
-    // 响应头
-    iov_[0].iov_base = const_cast<char *>(writeBuff_.Peek());
-    iov_[0].iov_len = writeBuff_.ReadableBytes();
-    iovCnt_ = 1;
-
+    responding_ = true;
     // 文件
+    fileIov_.iov_base = nullptr;
+    fileIov_.iov_len = 0;
     if (response_.FileTransMethod() == HttpResponse::MMAP)
     {
         if (response_.FileLen() > 0 && response_.FilePtr())
         {
-            iov_[1].iov_base = response_.FilePtr();
-            iov_[1].iov_len = response_.FileLen();
-            iovCnt_ = 2;
+            fileIov_.iov_base = response_.FilePtr();
+            fileIov_.iov_len = response_.FileLen();
         }
     }
     else if (response_.FileTransMethod() == HttpResponse::SENDFILE)
     {
         if (response_.FileLen() > 0 && response_.FileFd() != -1)
         {
-            iov_[1].iov_base = nullptr;
-            iov_[1].iov_len = response_.FileLen();
-            iovCnt_ = 1;
+            fileIov_.iov_len = response_.FileLen();
         }
     }
-    else // NONE
-    {
-        iov_[1].iov_base = nullptr;
-        iov_[1].iov_len = 0;
-    }
 
-    LOG_DEBUG("Client[%d] response filesize:%d, %d  to %d", fd_, response_.FileLen(), iovCnt_, ToWriteBytes());
+    LOG_DEBUG("Client[%d] response filesize:%d, blocks:%d to %zu", fd_, response_.FileLen(), (int)writeBuff_.BlockCount(), ToWriteBytes());
     return true;
 }
@@ -9,12 +9,14 @@
 
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <sys/types.h>
 #include <arpa/inet.h> // sockaddr
 
-#include "buffer/buffer.h"
+#include "buffer/chainbuffer.h"
 #include "httprequest.h"
 #include "httpresponse.h"
+#include "pool/redisasync.h"
 
 class HttpConn
 {
@@ -41,9 +43,9 @@ public:
 
     bool process();
 
-    int ToWriteBytes()
+    size_t ToWriteBytes()
     {
-        return iov_[0].iov_len + iov_[1].iov_len;
+        return writeBuff_.ReadableBytes() + fileIov_.iov_len;
     }
 
     bool IsKeepAlive() const
@@ -51,25 +53,86 @@ public:
         return request_.IsKeepAlive();
     }
 
+    // 连接序号，fd复用后用于识别异步应答是否属于当前连接
+    uint64_t GetId() const
+    {
+        return id_;
+    }
+
+    bool IsSuspended() const
+    {
+        return request_.IsSuspended();
+    }
+
+    const std::vector<std::string> &SessionCommand() const
+    {
+        return request_.SessionCommand();
+    }
+
+    void OnSessionReply(const RedisReply *reply)
+    {
+        request_.OnSessionReply(reply);
+    }
+
+    bool IsBlocking() const
+    {
+        return request_.IsBlocking();
+    }
+
+    // 已投递到线程池、尚未交还给事件循环，期间超时不析构该连接
+    void SetBusy(bool busy)
+    {
+        busy_ = busy;
+    }
+
+    bool IsBusy() const
+    {
+        return busy_;
+    }
+
+    bool IsDiskWait() const
+    {
+        return request_.IsDiskWait();
+    }
+
+    // 当前请求的后续读写都在文件I/O线程池中处理
+    bool IsDiskBound() const
+    {
+        return request_.IsDiskBound();
+    }
+
     static bool isET;
     static std::string resDir;
     static std::string dataDir;
     static std::atomic<int> userCount;
+    static std::atomic<uint64_t> nextId;
 
 private:
+    void LogAccess_();
+
     int fd_;
+    uint64_t id_;
     struct sockaddr_storage addr_;
 
     bool isClose_;
 
-    int iovCnt_;
-    struct iovec iov_[2];
+    static const int MAX_IOV = 64;                     // 单次writev的块数上限
+    static const size_t STREAM_LOW_WATER = 16 * 1024; // 待发送数据低于此值时生成下一段响应体
+
+    struct iovec fileIov_; // 待发送的文件部分，SENDFILE时iov_base为nullptr
 
-    Buffer readBuff_;  // 读缓冲区
-    Buffer writeBuff_; // 写缓冲区
+    ChainBuffer readBuff_;  // 读缓冲区
+    ChainBuffer writeBuff_; // 写缓冲区
 
     HttpRequest request_;
     HttpResponse response_;
+    std::atomic<bool> busy_; // 事件循环线程置位，工作线程交还时清除
+
+    // 访问日志统计
+    bool reqTiming_;  // 已开始计时的请求
+    bool responding_; // 响应已生成，尚未记录
+    size_t bytesSent_;
+    std::chrono::steady_clock::time_point reqStart_;
 };
 
 #endif // HTTP_CONN_H
\ No newline at end of file
@@ -5,19 +5,33 @@
  */
 #include "httprequest.h"
 
-#include <fstream>
-#include <random>
-#include <regex>
+#include <algorithm>
+#include <chrono>
+#include <hiredis/hiredis.h> // REDIS_REPLY_*
+#include <ctype.h>
 #include <dirent.h>
 #include <sys/stat.h>
-#include <mysql/mysql.h> //mysql
 
 #include "log/log.h"
-#include "pool/connpool.h"
-#include "pool/connRAII.h"
+#include "auth/randomid.h"
+#include "auth/sessiontoken.h"
+#include "auth/sessionstore.h"
+#include "auth/userstore.h"
+#include "cache/sessioncache.h"
+#include "cache/credentialcache.h"
+#include "cache/listcache.h"
+#include "pool/redisasync.h"
 
 using namespace std;
 
+const size_t HttpRequest::MAX_KEEP_CAPACITY;
+const size_t HttpRequest::MAX_HEADER_NAME;
+const size_t HttpRequest::MAX_BODY_SIZE;
+const size_t HttpRequest::MAX_CHUNK_SIZE;
+const size_t HttpRequest::MAX_BUFFERED_BODY;
+
+bool HttpRequest::deferDisk = false;
+
 const unordered_map<string, HttpRequest::HTTP_METHOD> HttpRequest::HTTP_METHOD_MAP = {
     {"GET", GET},
     {"POST", POST},
@@ -29,199 +43,531 @@ const unordered_map<string, HttpRequest::HTTP_METHOD> HttpRequest::HTTP_METHOD_M
     {"TRACE", TRACE},
     {"PATCH", PATCH}};
 
-const unordered_set<string> HttpRequest::DEFAULT_HTML{
-    "/index",
-    "/picture",
-    "/video",
-    "/file",
-    "/user",
+// 常用头部名称(小写)到固定槽位
+const Router<HttpRequest::HEADER_ID> HttpRequest::HEADER_IDS{
+    {0, "host", HDR_HOST, 0},
+    {0, "content-length", HDR_CONTENT_LENGTH, 0},
+    {0, "content-type", HDR_CONTENT_TYPE, 0},
+    {0, "connection", HDR_CONNECTION, 0},
+    {0, "cookie", HDR_COOKIE, 0},
+    {0, "range", HDR_RANGE, 0},
+    {0, "if-none-match", HDR_IF_NONE_MATCH, 0},
+    {0, "accept-encoding", HDR_ACCEPT_ENCODING, 0},
+    {0, "transfer-encoding", HDR_TRANSFER_ENCODING, 0},
+    {0, "user-agent", HDR_USER_AGENT, 0},
+    {0, "referer", HDR_REFERER, 0},
 };
 
-const unordered_map<string, int> HttpRequest::DEFAULT_HTML_TAG{
-    {"/file.html", 0},
-    {"/user.html", 1},
+// 页面别名，不区分方法
+const Router<const char *> HttpRequest::PAGE_ALIAS{
+    {0, "/", "/index.html", 0},
+    {0, "/index", "/index.html", 0},
+    {0, "/picture", "/picture.html", 0},
+    {0, "/video", "/video.html", 0},
+    {0, "/file", "/file.html", 0},
+    {0, "/user", "/user.html", 0},
 };
 
-// 需与下面处理业务逻辑的TAG对应
-const unordered_map<string, int> HttpRequest::SPECIAL_PATH_TAG{
-    {"/fileslist", 0}, // get
-    {"/upload", 1},    // post
-    {"/download", 2},  // get
-    {"/delete", 3},    // post
-    {"/register", 4},  // post
-    {"/login", 5},     // post
-    {"/userinfo", 6},  // get
-    {"/logout", 7},    // get
+// 未列出的请求按静态资源处理
+const HttpRequest::RouteTable HttpRequest::ROUTES{
+    {GET, "/file.html", &HttpRequest::ServeStatic_, ROUTE_AUTH | ROUTE_BLOCKING},
+    {GET, "/user.html", &HttpRequest::HandleUserPage_, ROUTE_AUTH_OPTIONAL | ROUTE_BLOCKING},
+    {GET, "/fileslist", &HttpRequest::HandleFileList_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_DISK},
+    {GET, "/download", &HttpRequest::HandleDownload_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_DISK},
+    {GET, "/userinfo", &HttpRequest::HandleUserInfo_, ROUTE_AUTH},
+    {GET, "/logout", &HttpRequest::HandleLogout_, ROUTE_AUTH | ROUTE_BLOCKING},
+    {POST, "/register", &HttpRequest::HandleRegister_, ROUTE_BLOCKING},
+    {POST, "/login", &HttpRequest::HandleLogin_, ROUTE_BLOCKING},
+    {POST, "/upload", &HttpRequest::HandleUpload_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_STREAM | ROUTE_DISK},
+    {PUT, "/upload", &HttpRequest::HandleUpload_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_STREAM | ROUTE_DISK},
+    {POST, "/upload/session", &HttpRequest::HandleUploadCreate_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_DISK},
+    {GET, "/upload/session", &HttpRequest::HandleUploadStatus_, ROUTE_AUTH | ROUTE_BLOCKING},
+    {PUT, "/upload/chunk", &HttpRequest::HandleUploadChunk_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_STREAM | ROUTE_DISK},
+    {POST, "/upload/commit", &HttpRequest::HandleUploadCommit_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_DISK},
+    {POST, "/delete", &HttpRequest::HandleDelete_, ROUTE_AUTH | ROUTE_BLOCKING | ROUTE_DISK},
+};
+
+// 统计作用域内访问Redis/MySQL的耗时，累加到total
+class UpstreamTimer
+{
+public:
+    explicit UpstreamTimer(long long &total) : total_(total), start_(chrono::steady_clock::now()) {}
+    ~UpstreamTimer()
+    {
+        total_ += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    long long &total_;
+    chrono::steady_clock::time_point start_;
 };
 
 HttpRequest::HttpRequest()
 {
-    url_ = path_ = query_ = version_ = body_ = "";
     method_ = METHOD_UNKNOWN;
+    route_ = nullptr;
+    chunked_ = false;
+    bodyLeft_ = 0;
+    bodyOpen_ = false;
+    streaming_ = false;
+    rawUpload_ = false;
+    chunkIndex_ = 0;
+    chunkWritten_ = 0;
+    chunkOk_ = false;
     state_ = REQUEST_LINE;
     reqType_ = GET_HTML;
-    reqRes_ = "";
     authState_ = AUTH_ANON;
-    authInfo_ = "";
-    userInfo_ = "";
+    upstreamUs_ = 0;
+    sessionReady_ = false;
+    sessionRes_ = STORE_FAIL;
+    diskWait_ = false;
+    onDisk_ = false;
 }
 
 void HttpRequest::Init(const string &resDir, const string &dataDir)
 {
-    url_ = path_ = query_ = version_ = body_ = "";
+    upload_.Abort();
+    EndChunk_(false);
+    bodyWriter_.reset();
+    arena_.Reset();
+    url_ = query_ = version_ = StrSpan();
+    fill(knownHeader_, knownHeader_ + HDR_COUNT, StrSpan());
+    header_.clear();
+    cookies_.clear();
+    queryRes_.clear();
+    bodyRes_.clear();
+    path_.clear();
+    // Init在响应发送完毕时执行：表单与路径等小字符串保留容量供下个请求复用，其余释放，不随keep-alive连接常驻
+    if (body_.capacity() > MAX_KEEP_CAPACITY)
+    {
+        string().swap(body_);
+    }
+    body_.clear();
+    if (reqRes_.capacity() > MAX_KEEP_CAPACITY)
+    {
+        string().swap(reqRes_);
+    }
+    reqRes_.clear();
     method_ = METHOD_UNKNOWN;
+    route_ = nullptr;
+    chunked_ = false;
+    bodyLeft_ = 0;
+    bodyOpen_ = false;
+    streaming_ = false;
+    rawUpload_ = false;
     state_ = REQUEST_LINE;
     reqType_ = GET_HTML;
-    reqRes_ = "";
     authState_ = AUTH_ANON;
-    authInfo_ = "";
-    userInfo_ = "";
+    authInfo_.clear();
+    userInfo_.clear();
+    upstreamUs_ = 0;
+    sessionCmd_.clear();
+    sessionReady_ = false;
+    sessionRes_ = STORE_FAIL;
+    sessionUser_.clear();
+    diskWait_ = false;
+    onDisk_ = false;
     resDir_ = resDir;
     dataDir_ = dataDir;
+}
+
+void HttpRequest::Release()
+{
+    upload_.Abort(); // 上传中途断开
+    EndChunk_(false);
+    arena_.Reset();
+    fill(knownHeader_, knownHeader_ + HDR_COUNT, StrSpan());
     header_.clear();
     cookies_.clear();
     queryRes_.clear();
     bodyRes_.clear();
+    url_ = query_ = version_ = StrSpan();
 }
 
-bool HttpRequest::IsKeepAlive() const
+// 头部数量很少，线性查找即可；从后向前查找使重复的键以最后一次出现为准
+const StrSpan *HttpRequest::FindSpan_(const SpanPairs &pairs, const char *key, bool noCase)
 {
-    if (header_.count("Connection") == 1)
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it)
     {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1";
+        if (noCase ? it->first.EqualsNoCase(key) : it->first.Equals(key))
+        {
+            return &it->second;
+        }
     }
-    return false;
+    return nullptr;
+}
+
+bool HttpRequest::IsKeepAlive() const
+{
+    // 未读完的消息体无法与下一个请求区分，只能关闭连接
+    return !bodyOpen_ && knownHeader_[HDR_CONNECTION].EqualsNoCase("keep-alive") && version_.Equals("1.1");
 }
 
-HttpRequest::LINE_STATE HttpRequest::ParseLine_(Buffer &buff, string &line)
+HttpRequest::LINE_STATE HttpRequest::ParseLine_(ChainBuffer &buff, StrSpan &line)
 {
     const char CRLF[] = "\r\n";
-    if (state_ == BODY) // BODY部分特殊处理
+    // REQUEST_LINE和HEADERS部分按行处理
+    // lineLen 为第一个/r/n相对可读数据的偏移，/r/n可能跨越两个块
+    size_t lineLen = buff.Find(CRLF, 2);
+    // 未找到下一个CRLF
+    if (lineLen == ChainBuffer::npos)
+    {
+        return LINE_OPEN;
+    }
+    // 提取一行(不含CRLF)到arena_，末尾补'\0'便于日志输出
+    char *data = arena_.Alloc(lineLen + 1);
+    buff.RetrieveTo(data, lineLen);
+    data[lineLen] = '\0';
+    line = StrSpan(data, lineLen);
+    buff.Retrieve(2); // 将CRLF从缓冲区中取出
+    return LINE_OK;
+}
+
+// 十进制非负整数，不接受符号、空白与溢出
+bool HttpRequest::ParseLength_(const StrSpan &str, size_t maxLen, size_t &len)
+{
+    if (str.empty() || str.len > 19)
+    {
+        return false;
+    }
+    len = 0;
+    for (size_t i = 0; i < str.len; ++i)
     {
-        if (method_ == GET)
+        if (str.data[i] < '0' || str.data[i] > '9')
         {
-            LOG_DEBUG("GET method, no body");
-            line = "";
-            buff.RetrieveAll();
-            return LINE_OK;
+            return false;
         }
-        else if (method_ == POST)
-        {
-            size_t contentLen;
-            size_t maxAllowContentLength = 1024 * 1024 * 1024; // 1GB
-            LOG_DEBUG("POST method, has body");
-            if (header_.count("Content-Length") == 0)
-            {
-                LOG_ERROR("POST method, no Content-Length");
-                return LINE_ERROR;
-            }
+        len = len * 10 + (str.data[i] - '0');
+    }
+    return len <= maxLen;
+}
 
-            try
+HttpRequest::HTTP_CODE HttpRequest::parse(ChainBuffer &buff)
+{
+    while (state_ != FINISH)
+    {
+        if (state_ == BODY)
+        {
+            LINE_STATE bodyState = ReadBody_(buff);
+            if (bodyState == LINE_OPEN)
             {
-                contentLen = std::stoul(header_["Content-Length"]); // 获取body长度
-                if (contentLen > maxAllowContentLength)
-                {
-                    LOG_ERROR("POST method, Content-Length too long");
-                    return LINE_ERROR;
-                }
+                return NO_REQUEST;
             }
-            catch (const out_of_range &e)
+            if (bodyState == LINE_ERROR)
             {
-                // Handle the case where the string couldn't be converted to size_t
-                LOG_ERROR("POST method, Content-Length too long");
-                return LINE_ERROR;
+                return BAD_REQUEST;
             }
+            ParseRequest_();
+            return RequestCode_();
+        }
 
-            // multipart/form-data处理方式：分段分批读取，节约内存占用
-            if (header_["Content-Type"] == "multipart/form-data")
+        StrSpan line;
+        LINE_STATE lineState = ParseLine_(buff, line);
+        if (lineState == LINE_OPEN)
+        {
+            return NO_REQUEST;
+        }
+        if (lineState == LINE_ERROR)
+        {
+            return BAD_REQUEST;
+        }
+        if (state_ == REQUEST_LINE)
+        {
+            if (!ParseRequestLine_(line))
             {
-                // TODO: 分段分批读取
+                return BAD_REQUEST;
             }
-
-            // 其他Content-Type默认处理方式：按contentLen一次性读取
-            if (buff.ReadableBytes() < contentLen)
+        }
+        else
+        {
+            ParseHeader_(line);
+            if (state_ == BODY)
             {
-                return LINE_OPEN;
+                HTTP_CODE code = BeginBody_();
+                if (code != NO_REQUEST)
+                {
+                    return code;
+                }
             }
-            line = string(buff.Peek(), buff.Peek() + contentLen);
-            buff.RetrieveAll();
-            return LINE_OK;
         }
-        // TODO: 支持其他Method
     }
+    // 默认HttpRequest处理
+    return NO_REQUEST;
+}
 
-    // REQUEST_LINE和HEADERS部分按行处理
-    // lineEnd 为寻找到第一个/r/n所在的位置
-    const char *lineEnd = search(buff.Peek(), buff.BeginWriteConst(), CRLF, CRLF + 2);
-    // 未找到下一个CRLF
-    if (lineEnd == buff.BeginWriteConst())
+// 挂起时机有两种：流式路由在读取消息体之前，其余路由在消息体读完之后
+HttpRequest::HTTP_CODE HttpRequest::Resume(ChainBuffer &buff)
+{
+    assert((authState_ == AUTH_WAIT && sessionReady_) || diskWait_);
+    if (diskWait_)
     {
-        return LINE_OPEN;
+        diskWait_ = false;
+        onDisk_ = true; // 已鉴权，再次进入时跳过
     }
-    line = string(buff.Peek(), lineEnd); // 提取一行，不含CRLF
-    buff.RetrieveUntil(lineEnd + 2);     // 将已经提取的数据从缓冲区中取出
-    return LINE_OK;
+    if (route_->flags & ROUTE_STREAM)
+    {
+        HTTP_CODE code = BeginStream_();
+        return code != NO_REQUEST ? code : parse(buff);
+    }
+    ParseRequest_();
+    return RequestCode_();
 }
 
-HttpRequest::HTTP_CODE HttpRequest::parse(Buffer &buff)
+// 头部结束：确定消息体的分帧方式并查找路由
+HttpRequest::HTTP_CODE HttpRequest::BeginBody_()
 {
-    string line;
-    LINE_STATE lineState = LINE_OK;
-    while (((lineState = ParseLine_(buff, line)) == LINE_OK && state_ != FINISH))
+    const StrSpan &encoding = knownHeader_[HDR_TRANSFER_ENCODING];
+    const StrSpan &length = knownHeader_[HDR_CONTENT_LENGTH];
+    chunked_ = false;
+    bodyLeft_ = 0;
+    if (encoding.data != nullptr)
     {
-        switch (state_)
+        // 只支持chunked；同时带有Content-Length的请求可能被用于请求走私，直接拒绝
+        if (!encoding.EqualsNoCase("chunked") || length.data != nullptr)
         {
-        case REQUEST_LINE:
-            if (!ParseRequestLine_(line))
+            LOG_ERROR("Unsupported Transfer-Encoding");
+            return BAD_REQUEST;
+        }
+        chunked_ = true;
+        decoder_.Reset(MAX_CHUNK_SIZE, MAX_BODY_SIZE);
+    }
+    else if (length.data != nullptr && !ParseLength_(length, MAX_BODY_SIZE, bodyLeft_))
+    {
+        LOG_ERROR("Invalid Content-Length");
+        return BAD_REQUEST;
+    }
+    bodyOpen_ = chunked_ || bodyLeft_ > 0; // 两者都没有时消息体为空
+    body_.clear();
+
+    route_ = ROUTES.Find(method_, path_.data(), path_.size());
+    if (route_ == nullptr && method_ != GET && method_ != HEAD)
+    {
+        // 未注册的路径只按静态资源处理GET/HEAD，其余方法不读取消息体，响应后关闭连接
+        nlohmann::json reqRes;
+        reqRes["err"] = 405;
+        reqType_ = GET_INFO;
+        reqRes_ = reqRes.dump();
+        state_ = FINISH;
+        return METHOD_NOT_ALLOWED;
+    }
+    if (route_ != nullptr && (route_->flags & ROUTE_STREAM))
+    {
+        return BeginStream_();
+    }
+    return NO_REQUEST;
+}
+
+// 流式路由在读取消息体之前完成鉴权，鉴权未通过时不再读取消息体，响应后关闭连接
+HttpRequest::HTTP_CODE HttpRequest::BeginStream_()
+{
+    streaming_ = false;
+    rawUpload_ = false;
+    if (!onDisk_ && !Authorize_(route_->flags))
+    {
+        if (authState_ != AUTH_WAIT)
+        {
+            state_ = FINISH;
+        }
+        return RequestCode_();
+    }
+    if (DeferDisk_())
+    {
+        return PENDING_REQUEST; // 消息体留在读缓冲区，由文件I/O线程写入
+    }
+    if (route_->handler == &HttpRequest::HandleUploadChunk_)
+    {
+        return BeginChunk_();
+    }
+    const StrSpan &contentType = knownHeader_[HDR_CONTENT_TYPE];
+    if (!contentType.empty() && memmem(contentType.data, contentType.len, "multipart/form-data", 19) != nullptr)
+    {
+        string boundary = MultipartParser::GetBoundary(contentType.str());
+        if (!boundary.empty())
+        {
+            upload_.Open(dataDir_ + "/" + userInfo_ + "/", bodyLeft_);
+            multipart_.Reset(boundary, &upload_);
+            streaming_ = true;
+        }
+    }
+    else if (method_ == PUT && bodyLeft_ > 0)
+    {
+        // PUT /upload?file=${fileName}：消息体即文件内容，长度已知时可splice写入
+        const StrSpan *file = FindSpan_(queryRes_, "file", false);
+        upload_.Open(dataDir_ + "/" + userInfo_ + "/", bodyLeft_);
+        if (file != nullptr)
+        {
+            upload_.OpenFile(file->str());
+        }
+        rawUpload_ = true;
+        streaming_ = true;
+    }
+    return NO_REQUEST;
+}
+
+// 按Content-Length或chunked分帧，逐段把消息体交给OnBody_，返回LINE_OK表示消息体已结束
+HttpRequest::LINE_STATE HttpRequest::ReadBody_(ChainBuffer &buff)
+{
+    while (bodyOpen_)
+    {
+        size_t len = 0;
+        if (chunked_)
+        {
+            ChunkedDecoder::STATUS status = decoder_.Next(buff, len);
+            if (status == ChunkedDecoder::DONE)
             {
-                return BAD_REQUEST;
+                bodyOpen_ = false;
+                break;
             }
-            break;
-        case HEADERS:
-            ParseHeader_(line);
-            break;
-        case BODY:
-            ParseRequest_(line);
-            if (authState_ == AUTH_FAIL)
+            if (status == ChunkedDecoder::NEED_MORE)
             {
-                return FORBIDDENT_REQUEST;
+                return LINE_OPEN;
+            }
+            if (status == ChunkedDecoder::ERROR)
+            {
+                LOG_ERROR("Invalid chunked body");
+                return LINE_ERROR;
             }
-            else if (authState_ == AUTH_NEED)
+        }
+        else
+        {
+            len = min(bodyLeft_, buff.PeekBytes());
+            if (len == 0)
             {
-                return UNAUTH_REQUEST;
+                return LINE_OPEN;
             }
-            return GET_REQUEST;
-            break;
-        default:
-            break;
+            bodyLeft_ -= len;
+            bodyOpen_ = bodyLeft_ > 0;
+        }
+        if (!OnBody_(buff.Peek(), len))
+        {
+            return LINE_ERROR;
         }
+        buff.Retrieve(len);
     }
+    return LINE_OK;
+}
 
-    if (lineState == LINE_ERROR)
+// 流式路由的消息体边到达边交给multipart_或upload_，其他路由缓存到body_，静态资源丢弃
+bool HttpRequest::OnBody_(const char *data, size_t len)
+{
+    if (streaming_)
     {
-        return BAD_REQUEST;
+        if (chunkSession_)
+        {
+            chunkOk_ = chunkOk_ && chunkSession_->Write(chunkIndex_, chunkWritten_, data, len);
+            chunkWritten_ += len;
+        }
+        else if (rawUpload_)
+        {
+            upload_.Write(data, len);
+        }
+        else
+        {
+            multipart_.Feed(data, len);
+        }
+        return true;
     }
+    if (route_ == nullptr || (route_->flags & ROUTE_STREAM))
+    {
+        return true;
+    }
+    if (body_.size() + len > MAX_BUFFERED_BODY)
+    {
+        LOG_ERROR("Request body too large");
+        return false;
+    }
+    body_.append(data, len);
+    return true;
+}
 
-    // 默认HttpRequest处理
+// PUT /upload/chunk?id=${id}&index=${index}：长度须与该块一致，校验失败时不再读取消息体，响应后关闭连接
+HttpRequest::HTTP_CODE HttpRequest::BeginChunk_()
+{
+    const StrSpan *index = FindSpan_(queryRes_, "index", false);
+    chunkSession_ = FindUploadSession_();
+    int err = 404;
+    if (chunkSession_)
+    {
+        err = (chunked_ || index == nullptr || !ParseLength_(*index, chunkSession_->Chunks(), chunkIndex_))
+                  ? 400
+                  : chunkSession_->BeginChunk(chunkIndex_, bodyLeft_);
+    }
+    if (err != 0)
+    {
+        chunkSession_.reset();
+        nlohmann::json reqRes;
+        reqRes["err"] = err;
+        reqType_ = GET_INFO;
+        reqRes_ = reqRes.dump();
+        state_ = FINISH;
+        return GET_REQUEST;
+    }
+    chunkWritten_ = 0;
+    chunkOk_ = true;
+    streaming_ = true;
     return NO_REQUEST;
 }
 
-void HttpRequest::ParsePath_()
+// 块未完整接收时标记为缺失，可重新上传
+void HttpRequest::EndChunk_(bool ok)
 {
-    if (path_ == "/")
+    if (chunkSession_)
     {
-        path_ = "/index.html";
+        chunkSession_->EndChunk(chunkIndex_, ok);
+        chunkSession_.reset();
     }
-    else
+}
+
+UploadSessions::SessionPtr HttpRequest::FindUploadSession_()
+{
+    const StrSpan *id = FindSpan_(queryRes_, "id", false);
+    return id ? UploadSessions::Instance()->Find(id->str(), userInfo_) : nullptr;
+}
+
+// 读缓冲区中已有的消息体先经OnBody_写入，之后的部分直接从socket写入文件
+bool HttpRequest::CanSplice() const
+{
+    return state_ == BODY && rawUpload_ && bodyLeft_ > 0 && upload_.CanSplice();
+}
+
+ssize_t HttpRequest::SpliceBody(int fd, int *saveErrno)
+{
+    ssize_t len = upload_.Splice(fd, bodyLeft_, saveErrno);
+    if (len > 0)
     {
-        for (auto &item : DEFAULT_HTML)
-        {
-            if (item == path_)
-            {
-                path_ += ".html";
-                break;
-            }
-        }
+        bodyLeft_ -= len;
+        bodyOpen_ = bodyLeft_ > 0;
+    }
+    return len;
+}
+
+HttpRequest::HTTP_CODE HttpRequest::RequestCode_() const
+{
+    if (diskWait_)
+    {
+        return PENDING_REQUEST;
+    }
+    switch (authState_)
+    {
+    case AUTH_WAIT:
+        return PENDING_REQUEST;
+    case AUTH_FAIL:
+        return FORBIDDENT_REQUEST;
+    case AUTH_BUSY:
+        return SERVICE_UNAVAILABLE;
+    case AUTH_NEED:
+        return UNAUTH_REQUEST;
+    default:
+        return GET_REQUEST;
+    }
+}
+
+void HttpRequest::ParsePath_()
+{
+    const Router<const char *>::Route *alias = PAGE_ALIAS.Find(0, path_.data(), path_.size());
+    if (alias != nullptr)
+    {
+        path_ = alias->handler;
     }
 }
 
@@ -243,517 +589,631 @@ void HttpRequest::ParseMethod_(const string &methodStr)
     }
 }
 
-bool HttpRequest::ParseRequestLine_(const string &line)
+// 请求行格式：METHOD SP URL SP HTTP/VERSION，三段均不含空格
+bool HttpRequest::ParseRequestLine_(const StrSpan &line)
 {
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    smatch subMatch;
-    if (regex_match(line, subMatch, patten))
+    const char *begin = line.data, *end = line.data + line.len;
+    const char *sp1 = static_cast<const char *>(memchr(begin, ' ', line.len));
+    const char *sp2 = sp1 ? static_cast<const char *>(memchr(sp1 + 1, ' ', end - sp1 - 1)) : nullptr;
+    const char *proto = sp2 + 1;
+    if (sp2 == nullptr || memchr(proto, ' ', end - proto) != nullptr ||
+        end - proto < 5 || memcmp(proto, "HTTP/", 5) != 0)
     {
-        string methodStr = subMatch[1];
-        ParseMethod_(methodStr);
-        url_ = subMatch[2];
-        version_ = subMatch[3];
-        // Parse URL to extract path and query
-        size_t queryStartPos = url_.find('?');
-        if (queryStartPos != string::npos)
-        {
-            path_ = url_.substr(0, queryStartPos);
-            query_ = url_.substr(queryStartPos + 1);
-            ParsePath_();
-            ParseQuery_();
-        }
-        else
-        {
-            path_ = url_;
-            query_ = "";
-            ParsePath_();
-        }
-        LOG_DEBUG("[%s], [%s], [%s], [%s]", methodStr.c_str(), path_.c_str(), query_.c_str(), version_.c_str());
-        state_ = HEADERS;
-        return true;
+        LOG_ERROR("RequestLine Error");
+        return false;
     }
-    LOG_ERROR("RequestLine Error");
-    return false;
-}
 
-void HttpRequest::ParseHeader_(const string &line)
-{
-    regex patten("^([^:]*): ?(.*)$");
-    smatch subMatch;
-    if (regex_match(line, subMatch, patten))
+    ParseMethod_(string(begin, sp1));
+    url_ = StrSpan(sp1 + 1, sp2 - sp1 - 1);
+    version_ = StrSpan(proto + 5, end - proto - 5);
+    // Parse URL to extract path and query
+    const char *mark = static_cast<const char *>(memchr(url_.data, '?', url_.len));
+    if (mark != nullptr)
     {
-        header_[subMatch[1]] = subMatch[2];
-        if (subMatch[1] == "Cookie")
-        {
-            ParseCookies_(subMatch[2]);
-        }
+        path_.assign(url_.data, mark);
+        query_ = StrSpan(mark + 1, url_.data + url_.len - mark - 1);
+        ParsePath_();
+        ParseQuery_();
     }
     else
     {
-        state_ = BODY;
+        path_.assign(url_.data, url_.len);
+        query_ = StrSpan();
+        ParsePath_();
     }
+    LOG_DEBUG("[%.*s], [%s], [%.*s], [%.*s]", static_cast<int>(sp1 - begin), begin, path_.c_str(),
+              static_cast<int>(query_.len), query_.data, static_cast<int>(version_.len), version_.data);
+    state_ = HEADERS;
+    return true;
 }
 
-void HttpRequest::ParseCookies_(const string &cookieStr)
+// 头部格式：NAME: VALUE，冒号后至多一个可选空格；无冒号的行(空行)表示头部结束
+void HttpRequest::ParseHeader_(const StrSpan &line)
 {
-    regex cookiePattern("([^;=]+)=([^;]*)");
-    smatch cookieMatch;
-
-    auto cookieIter = sregex_iterator(cookieStr.begin(), cookieStr.end(), cookiePattern);
-    auto cookieEnd = sregex_iterator();
-
-    for (; cookieIter != cookieEnd; ++cookieIter)
+    const char *colon = static_cast<const char *>(memchr(line.data, ':', line.len));
+    if (colon == nullptr)
+    {
+        state_ = BODY;
+        return;
+    }
+    const char *value = colon + 1, *end = line.data + line.len;
+    if (value < end && *value == ' ')
     {
-        string key = (*cookieIter)[1];
-        string value = (*cookieIter)[2];
-        // Trim leading and trailing spaces
-        key.erase(0, key.find_first_not_of(" "));
-        key.erase(key.find_last_not_of(" ") + 1);
-        value.erase(0, value.find_first_not_of(" "));
-        value.erase(value.find_last_not_of(" ") + 1);
-        cookies_[key] = value;
+        ++value;
+    }
+    StrSpan name(line.data, colon - line.data), content(value, end - value);
+    HEADER_ID id;
+    if (!FindHeaderId_(name.data, name.len, id))
+    {
+        header_.emplace_back(name, content);
+        return;
+    }
+    knownHeader_[id] = content; // 重复出现时以最后一次为准
+    if (id == HDR_COOKIE)
+    {
+        ParseCookies_(content);
     }
 }
 
-void HttpRequest::CheckCookie_()
+// 转为小写后查表，名称超长的必然不是常用头部
+bool HttpRequest::FindHeaderId_(const char *name, size_t len, HEADER_ID &id)
 {
-    if (cookies_.count("session_id"))
+    char lower[MAX_HEADER_NAME];
+    if (len > MAX_HEADER_NAME)
     {
-        if (UserVerify(cookies_["session_id"], userInfo_))
-            authState_ = AUTH_PASS;
-        else
-            authState_ = AUTH_FAIL;
+        return false;
     }
-    else
+    for (size_t i = 0; i < len; ++i)
     {
-        authState_ = AUTH_NEED;
+        lower[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[i])));
     }
+    const Router<HEADER_ID>::Route *route = HEADER_IDS.Find(0, lower, len);
+    if (route == nullptr)
+    {
+        return false;
+    }
+    id = route->handler;
+    return true;
 }
 
-void HttpRequest::ParseRequest_(const string &line)
+// 去除首尾空格
+static StrSpan TrimSpan(const char *begin, const char *end)
 {
-    body_ = line;
-    // LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());
-    if (method_ == GET)
+    while (begin < end && *begin == ' ')
     {
-        ParseGet_();
+        ++begin;
     }
-    else if (method_ == POST)
+    while (end > begin && *(end - 1) == ' ')
     {
-        ParsePost_();
+        --end;
     }
-    // TODO: 支持其他Method
-    state_ = FINISH;
+    return StrSpan(begin, end - begin);
 }
 
-void HttpRequest::ParseGet_()
+void HttpRequest::ParseCookies_(const StrSpan &cookieStr)
 {
-    if (SPECIAL_PATH_TAG.count(path_))
+    const char *pos = cookieStr.data, *end = cookieStr.data + cookieStr.len;
+    while (pos < end)
     {
-        nlohmann::json reqRes;
-        int tag = SPECIAL_PATH_TAG.find(path_)->second;
-        LOG_DEBUG("Tag:%d", tag);
-
-        CheckCookie_();
-        if (authState_ != AUTH_PASS)
+        const char *semi = static_cast<const char *>(memchr(pos, ';', end - pos));
+        const char *itemEnd = semi ? semi : end;
+        const char *eq = static_cast<const char *>(memchr(pos, '=', itemEnd - pos));
+        if (eq != nullptr && eq != pos)
         {
-            return;
+            cookies_.emplace_back(TrimSpan(pos, eq), TrimSpan(eq + 1, itemEnd));
         }
+        pos = itemEnd + 1;
+    }
+}
 
-        if (tag == 0) // fileslist
-        {
-            GetFileList(dataDir_ + "/" + userInfo_ + "/", reqRes);
-            reqType_ = GET_INFO;
-            reqRes_ = reqRes.dump();
-            return;
-        }
-        else if (tag == 2 && queryRes_.count("file")) // download?file=${fileName}
+void HttpRequest::CheckCookie_()
+{
+    const StrSpan *sidStr = FindSpan_(cookies_, "session_id", false);
+    if (sidStr != nullptr)
+    {
+        const string sid = sidStr->str();
+        if (!SessionToken::Instance()->IsOpen() && !RandomID::IsValid(sid))
         {
-            reqType_ = GET_FILE;
-            reqRes_ = dataDir_ + "/" + userInfo_ + "/" + queryRes_["file"];
+            authState_ = AUTH_FAIL; // 不是本服务生成的session_id，无需查询
             return;
         }
-        else if (tag == 6) // userinfo
+        STORE_RESULT res = STORE_FAIL;
+        if (sessionReady_) // 异步查询已返回
         {
-            reqType_ = GET_INFO;
-            reqRes["username"] = userInfo_;
-            reqRes_ = reqRes.dump();
-            return;
+            sessionReady_ = false;
+            res = sessionRes_;
+            userInfo_ = sessionUser_;
         }
-        else if (tag == 7) // logout
+        else
         {
-            if (UserQuit(cookies_["session_id"]))
+            SessionCache::RESULT cached = SessionCache::Instance()->Lookup(sid, userInfo_);
+            if (cached == SessionCache::VALID)
             {
-                path_ = "/user.html";
-                authState_ = AUTH_SET;
-                authInfo_ = "session_id=" + cookies_["session_id"] + "; expires=Thu, 01 Jan 1970 00:00:00 GMT; path=/; HttpOnly";
+                authState_ = AUTH_PASS;
+                return;
             }
-            else
+            else if (cached == SessionCache::INVALID)
             {
-                path_ = "/error.html";
+                authState_ = AUTH_FAIL;
+                return;
             }
-            reqType_ = GET_HTML;
-            reqRes_ = resDir_ + path_;
-            return;
-        }
-    }
-    else if (DEFAULT_HTML_TAG.count(path_))
-    {
-        int tag = DEFAULT_HTML_TAG.find(path_)->second;
-        LOG_DEBUG("Tag:%d", tag);
 
-        CheckCookie_();
-        if (authState_ != AUTH_PASS)
-        {
-            if (tag == 1) // user.html
+            if (SuspendSession_(sid))
             {
-                authState_ = AUTH_ANON; // user页面不存在鉴权失败的情况
-                reqType_ = GET_HTML;
-                reqRes_ = resDir_ + path_;
+                authState_ = AUTH_WAIT; // 挂起请求，不占用工作线程等待Redis
+                return;
             }
-            return;
+            UpstreamTimer timer(upstreamUs_);
+            res = UserVerify(sid, userInfo_);
         }
-
-        if (tag == 1) // user.html
+        if (res == STORE_UNAVAILABLE)
         {
-            path_ = "/welcome.html";
-            reqType_ = GET_HTML;
-            reqRes_ = resDir_ + path_;
+            authState_ = AUTH_BUSY; // 不缓存，存储恢复后立即生效
             return;
         }
+        SessionCache::Instance()->Insert(sid, res == STORE_OK, userInfo_);
+        authState_ = (res == STORE_OK) ? AUTH_PASS : AUTH_FAIL;
+    }
+    else
+    {
+        authState_ = AUTH_NEED;
     }
-
-    // 默认GET请求处理
-    reqType_ = GET_HTML;
-    reqRes_ = resDir_ + path_;
 }
 
-void HttpRequest::ParsePost_()
+// 异步客户端可用时生成待发送的查询命令，返回false则走同步查询
+bool HttpRequest::SuspendSession_(const string &sid)
 {
-    // application/x-www-form-urlencoded
-    if (header_["Content-Type"] == "application/x-www-form-urlencoded")
+    if (!RedisAsync::Instance()->IsOpen() || !SessionStore::Instance()->IsRedis() || sid.empty())
     {
-        ParseUrlencodedData_(body_, bodyRes_);
-        if (SPECIAL_PATH_TAG.count(path_))
+        return false;
+    }
+    SessionToken *token = SessionToken::Instance();
+    if (token->IsOpen())
+    {
+        string tokenId;
+        if (!token->Revocation() || !token->CheckSignature(sid, sessionUser_, tokenId))
         {
-            int tag = SPECIAL_PATH_TAG.find(path_)->second;
-            LOG_DEBUG("Tag:%d", tag);
-            if (tag == 4 || tag == 5) // register or login
-            {
-                bool isLogin = (tag == 5);
-                if (UserVerify(bodyRes_["username"], bodyRes_["password"], isLogin))
-                {
-                    string cookie;
-                    if (UserEnroll(bodyRes_["username"], cookie))
-                    {
-                        authState_ = AUTH_SET;
-                        authInfo_ = cookie;
-                    }
-                    path_ = "/welcome.html";
-                }
-                else
-                {
-                    path_ = "/error.html";
-                }
-            }
-            reqType_ = GET_HTML;
-            reqRes_ = resDir_ + path_;
-            return;
+            return false; // 无需访问Redis
         }
-    } // multipart/form-data
-    else if (header_["Content-Type"].find("multipart/form-data") != string::npos)
+        sessionCmd_ = {"GET", SessionToken::RevokedKey(tokenId)};
+    }
+    else
     {
-        string boundary = GetBoundaryFromContentType_(header_["Content-Type"]);
-        if (!boundary.empty())
+        sessionCmd_ = {"GET", SessionStore::SessionKey(sid)};
+    }
+    suspendAt_ = chrono::steady_clock::now();
+    return true;
+}
+
+// 在事件循环线程中调用，此时请求已挂起，不会被其他线程访问
+void HttpRequest::OnSessionReply(const RedisReply *reply)
+{
+    assert(authState_ == AUTH_WAIT);
+    upstreamUs_ += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - suspendAt_).count();
+    sessionRes_ = STORE_UNAVAILABLE;
+    const bool found = reply && reply->type == REDIS_REPLY_STRING;
+    bool missing = reply && reply->type == REDIS_REPLY_NIL;
+    if (reply && reply->type == REDIS_REPLY_ERROR)
+    {
+        LOG_ERROR("Redis command error: %s", reply->str.c_str());
+        missing = SessionStore::IsWrongType(reply->str); // 与同步查询一致，按key不存在处理
+    }
+    if (SessionToken::Instance()->IsOpen()) // GET revoked:<id>，存在即已吊销
+    {
+        if (found)
         {
-            ParseMultipartFormData_(body_, boundary);
-            return;
+            sessionRes_ = STORE_FAIL;
+        }
+        else if (missing)
+        {
+            sessionRes_ = STORE_OK;
         }
-    } // application/json
-    else if (header_["Content-Type"] == "application/json")
+    }
+    else if (found)
+    {
+        sessionUser_ = reply->str;
+        sessionRes_ = STORE_OK;
+    }
+    else if (missing)
     {
-        nlohmann::json jsonRes;
-        ParseJsonData_(body_, jsonRes);
-        if (SPECIAL_PATH_TAG.count(path_))
+        sessionRes_ = STORE_FAIL;
+    }
+    sessionReady_ = true;
+}
+
+// 路由已在头部结束时确定，异步session查询返回后Resume会再次进入
+void HttpRequest::ParseRequest_()
+{
+    if (route_ == nullptr)
+    {
+        ServeStatic_(); // BeginBody_已拒绝GET/HEAD以外的方法
+    }
+    else if ((route_->flags & ROUTE_STREAM) || onDisk_ || Authorize_(route_->flags)) // 流式路由已在BeginStream_中鉴权
+    {
+        if (!DeferDisk_())
         {
-            int tag = SPECIAL_PATH_TAG.find(path_)->second;
-            LOG_DEBUG("Tag:%d", tag);
+            (this->*route_->handler)();
+        }
+    }
+    if (authState_ != AUTH_WAIT && !diskWait_)
+    {
+        state_ = FINISH;
+    }
+}
 
-            CheckCookie_();
-            if (authState_ != AUTH_PASS)
-            {
-                return;
-            }
+// 工作线程只负责解析与鉴权，访问数据目录的处理函数与响应的生成、发送交给文件I/O线程
+bool HttpRequest::DeferDisk_()
+{
+    if (deferDisk && !onDisk_ && (route_->flags & ROUTE_DISK))
+    {
+        diskWait_ = true;
+        return true;
+    }
+    return false;
+}
 
-            if (tag == 3) // delete
-            {
-                int err = 0;
-                nlohmann::json reqRes;
-                string Filename = jsonRes["file"];
-                if (!DeleteFile(dataDir_ + "/" + userInfo_ + "/" + Filename))
-                {
-                    err = 403;
-                }
-                reqRes["err"] = err;
-                reqType_ = GET_INFO;
-                reqRes_ = reqRes.dump();
-                return;
-            }
-        }
+// 按路由要求检查session，返回false表示请求已挂起或鉴权未通过
+bool HttpRequest::Authorize_(unsigned flags)
+{
+    if (!(flags & (ROUTE_AUTH | ROUTE_AUTH_OPTIONAL)))
+    {
+        return true;
     }
+    CheckCookie_();
+    if (authState_ == AUTH_WAIT)
+    {
+        return false;
+    }
+    return authState_ == AUTH_PASS || (flags & ROUTE_AUTH_OPTIONAL);
+}
 
-    // 默认POST请求处理
+bool HttpRequest::IsBlocking() const
+{
+    return route_ != nullptr && (route_->flags & (ROUTE_BLOCKING | ROUTE_DISK));
+}
+
+void HttpRequest::ServeStatic_()
+{
     reqType_ = GET_HTML;
-    reqRes_ = resDir_ + path_;
+    SetResource_(path_);
 }
 
-void HttpRequest::ParseUrlencodedData_(string &data, unordered_map<string, string> &paramMap)
+void HttpRequest::HandleUserPage_()
 {
-    string decodedData;
-    string::const_iterator it = data.begin();
-    while (it != data.end())
+    if (authState_ == AUTH_PASS)
     {
-        if (*it == '+')
-        {
-            decodedData += ' ';
-        }
-        else if (*it == '%')
-        {
-            ++it;
-            char decodedChar = static_cast<char>(stoi(string(it, it + 2), nullptr, 16));
-            decodedData += decodedChar;
-            it += 1;
-        }
-        else
-        {
-            decodedData += *it;
-        }
-        ++it;
+        path_ = "/welcome.html";
     }
-
-    size_t pos = 0;
-    while (pos < decodedData.size())
+    else
     {
-        size_t eqPos = decodedData.find('=', pos);
-        size_t ampPos = decodedData.find('&', pos);
-
-        string key = decodedData.substr(pos, eqPos - pos);
-        string value = decodedData.substr(eqPos + 1, ampPos - eqPos - 1);
-
-        paramMap[key] = value;
-
-        if (ampPos == string::npos)
-        {
-            break;
-        }
-        pos = ampPos + 1;
+        authState_ = AUTH_ANON; // user页面不存在鉴权失败的情况
     }
+    ServeStatic_();
 }
 
-// Helper function to extract boundary from Content-Type
-string HttpRequest::GetBoundaryFromContentType_(const string &contentType)
+// 优先发送缓存的列表，未缓存时在发送响应时逐段生成
+void HttpRequest::HandleFileList_()
 {
-    size_t pos = contentType.find("boundary=");
-    if (pos != string::npos)
+    reqType_ = GET_INFO;
+    reqRes_.clear();
+    string dir = dataDir_ + "/" + userInfo_ + "/";
+    ListCache::Listing listing = ListCache::Instance()->Get(dir);
+    if (listing)
     {
-        return contentType.substr(pos + 9); // 9 is the length of "boundary="
+        bodyWriter_.reset(new SharedBodyWriter(move(listing)));
+    }
+    else
+    {
+        bodyWriter_.reset(new DirListWriter(dir));
     }
-    return "";
 }
 
-// Helper function to parse multipart/form-data
-void HttpRequest::ParseMultipartFormData_(const string &data, const string &boundary)
+// download?file=${fileName}
+void HttpRequest::HandleDownload_()
 {
-    // Split data into parts using boundary
-    vector<string> parts = SplitString_(data, "--" + boundary);
-    for (const string &part : parts)
+    const StrSpan *file = FindSpan_(queryRes_, "file", false);
+    if (file == nullptr)
     {
-        if (!part.empty())
-        {
-            size_t headerEnd = part.find("\r\n\r\n");
-            if (headerEnd != string::npos)
-            {
-                string headers = part.substr(0, headerEnd);
-                string content = part.substr(headerEnd + 4); // 4 is the length of "\r\n\r\n"
+        ServeStatic_();
+        return;
+    }
+    reqType_ = GET_FILE;
+    reqRes_.assign(dataDir_).append("/").append(userInfo_).append("/").append(file->data, file->len);
+}
 
-                // Extract filename, name, content type, etc. from headers
-                // Process content (e.g., save to a file or handle form fields)
-                // Example code:
-                map<string, string> partHeaders;
-                ParsePartHeaders_(headers, partHeaders);
+void HttpRequest::HandleUserInfo_()
+{
+    nlohmann::json reqRes;
+    reqType_ = GET_INFO;
+    reqRes["username"] = userInfo_;
+    reqRes_ = reqRes.dump();
+}
 
-                if (partHeaders.count("Content-Disposition"))
-                {
-                    string disposition = partHeaders["Content-Disposition"];
-                    string contentType = partHeaders["Content-Type"];
-                    map<string, string> dispositionParams;
-                    ParseHeaderValueParams_(disposition, dispositionParams);
-
-                    if (dispositionParams.count("name"))
-                    {
-                        string paramName = dispositionParams["name"];
-
-                        if (dispositionParams.count("filename")) // 文件类型
-                        {
-                            if (SPECIAL_PATH_TAG.count(path_))
-                            {
-                                int tag = SPECIAL_PATH_TAG.find(path_)->second;
-                                LOG_DEBUG("Tag:%d", tag);
-
-                                CheckCookie_();
-                                if (authState_ != AUTH_PASS)
-                                {
-                                    return;
-                                }
-
-                                if (tag == 1) // upload
-                                {
-                                    // This part contains a file upload, process it accordingly
-                                    string filename = dispositionParams["filename"];
-                                    SaveFileUpload_(filename, content);
-                                    return;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            // This part contains a form field, process it accordingly
-                            ProcessFormField_(paramName, content);
-                        }
-                    }
-                }
-            }
-        }
+void HttpRequest::HandleLogout_()
+{
+    const string sid = FindSpan_(cookies_, "session_id", false)->str(); // CheckCookie_已确认存在
+    STORE_RESULT quit = STORE_FAIL;
+    {
+        UpstreamTimer timer(upstreamUs_);
+        quit = UserQuit(sid);
+    }
+    if (quit == STORE_UNAVAILABLE)
+    {
+        authState_ = AUTH_BUSY;
+        return;
+    }
+    if (quit == STORE_OK)
+    {
+        path_ = "/user.html";
+        authState_ = AUTH_SET;
+        authInfo_ = "session_id=" + sid + "; expires=Thu, 01 Jan 1970 00:00:00 GMT; path=/; HttpOnly";
     }
+    else
+    {
+        path_ = "/error.html";
+    }
+    ServeStatic_();
+}
+
+void HttpRequest::HandleRegister_()
+{
+    Enroll_(false);
+}
+
+void HttpRequest::HandleLogin_()
+{
+    Enroll_(true);
 }
 
-// Helper function to parse headers of multipart/form-data part
-void HttpRequest::ParsePartHeaders_(const string &headers, map<string, string> &headerMap)
+// application/x-www-form-urlencoded
+void HttpRequest::Enroll_(bool isLogin)
 {
-    vector<string> lines = SplitString_(headers, "\r\n");
-    for (const string &line : lines)
+    if (!knownHeader_[HDR_CONTENT_TYPE].Equals("application/x-www-form-urlencoded"))
     {
-        size_t colonPos = line.find(":");
-        if (colonPos != string::npos)
-        {
-            string key = TrimString_(line.substr(0, colonPos));
-            string value = TrimString_(line.substr(colonPos + 1));
-            headerMap[key] = value;
-        }
+        ServeStatic_();
+        return;
+    }
+    ParseUrlencodedData_(StrSpan(body_.data(), body_.size()), bodyRes_);
+    UpstreamTimer timer(upstreamUs_);
+    // 用户名即数据目录下的目录名，'.'开头的名称留给对象存储等内部目录
+    STORE_RESULT res = (isLogin || UploadSink::ValidFileName(GetBody("username")))
+                           ? UserVerify(GetBody("username"), GetBody("password"), isLogin)
+                           : STORE_FAIL;
+    string cookie;
+    if (res == STORE_OK)
+    {
+        res = UserEnroll(GetBody("username"), cookie);
+    }
+    if (res == STORE_UNAVAILABLE)
+    {
+        authState_ = AUTH_BUSY;
+        return;
+    }
+    if (res == STORE_OK)
+    {
+        authState_ = AUTH_SET;
+        authInfo_ = cookie;
+        path_ = "/welcome.html";
+    }
+    else
+    {
+        path_ = "/error.html";
     }
+    ServeStatic_();
 }
 
-// Helper function to parse header value parameters
-void HttpRequest::ParseHeaderValueParams_(const string &value, map<string, string> &paramMap)
+// multipart/form-data或原始消息体，文件内容已在接收时写入
+void HttpRequest::HandleUpload_()
 {
-    vector<string> parts = SplitString_(value, ";");
-    for (size_t i = 1; i < parts.size(); ++i)
+    if (!streaming_)
+    {
+        ServeStatic_();
+        return;
+    }
+    streaming_ = false;
+    nlohmann::json reqRes;
+    if (rawUpload_)
+    {
+        upload_.Commit();
+    }
+    if (!rawUpload_ && !multipart_.Finished())
+    {
+        LOG_ERROR("Malformed multipart body");
+        upload_.Abort();
+        reqRes["err"] = 400;
+    }
+    else
     {
-        size_t equalsPos = parts[i].find("=");
-        if (equalsPos != string::npos)
+        reqRes["err"] = upload_.Error();
+        if (upload_.Saved())
         {
-            string key = TrimString_(parts[i].substr(0, equalsPos));
-            string value = TrimString_(parts[i].substr(equalsPos + 1));
-            if (!value.empty() && value.front() == '"' && value.back() == '"')
-            {
-                value = value.substr(1, value.length() - 2);
-            }
-            paramMap[key] = value;
+            reqRes["fileName"] = upload_.FileName();
+            reqRes["fileSize"] = upload_.FileSize();
+            reqRes["uploadDate"] = static_cast<unsigned long long>(upload_.UploadDate());
         }
     }
+    reqType_ = GET_INFO;
+    reqRes_ = reqRes.dump();
 }
 
-// Helper function to process form field
-void HttpRequest::ProcessFormField_(const string &paramName, const string &fieldValue)
+// application/json: {"file":${fileName},"size":${size},"chunkSize":${chunkSize}}，chunkSize可省略
+void HttpRequest::HandleUploadCreate_()
 {
-    // Process form field data as needed
-    LOG_DEBUG("Form field: %s = %s", paramName.c_str(), fieldValue.c_str());
+    if (!knownHeader_[HDR_CONTENT_TYPE].Equals("application/json"))
+    {
+        ServeStatic_();
+        return;
+    }
+    nlohmann::json jsonRes;
+    ParseJsonData_(body_, jsonRes);
+    nlohmann::json reqRes;
+    int err = 400;
+    if (jsonRes.is_object() && jsonRes.value("file", nlohmann::json()).is_string() &&
+        jsonRes.value("size", nlohmann::json()).is_number_unsigned() &&
+        jsonRes.value("chunkSize", nlohmann::json(0U)).is_number_unsigned())
+    {
+        UploadSessions::SessionPtr session = UploadSessions::Instance()->Create(
+            userInfo_, dataDir_ + "/" + userInfo_ + "/", jsonRes["file"].get<string>(),
+            jsonRes["size"].get<size_t>(), jsonRes.value("chunkSize", static_cast<size_t>(0)), err);
+        if (session)
+        {
+            reqRes["id"] = session->Id();
+            reqRes["chunkSize"] = session->ChunkSize();
+            reqRes["chunks"] = session->Chunks();
+        }
+    }
+    reqRes["err"] = err;
+    reqType_ = GET_INFO;
+    reqRes_ = reqRes.dump();
 }
 
-// Helper function to save file upload
-void HttpRequest::SaveFileUpload_(const string &filename, const string &content)
+// upload/session?id=${id}，返回尚未完成的块
+void HttpRequest::HandleUploadStatus_()
 {
     nlohmann::json reqRes;
-    // Check if the filename is valid
-    if (filename.empty())
+    UploadSessions::SessionPtr session = FindUploadSession_();
+    if (session)
     {
-        LOG_ERROR("Invalid filename for uploaded file.");
-        return;
+        reqRes["err"] = 0;
+        reqRes["id"] = session->Id();
+        reqRes["fileName"] = session->FileName();
+        reqRes["fileSize"] = session->Size();
+        reqRes["chunkSize"] = session->ChunkSize();
+        reqRes["chunks"] = session->Chunks();
+        reqRes["missing"] = session->Missing();
     }
-
-    // Define the directory where uploaded files will be stored
-    string uploadDirectory = dataDir_ + "/" + userInfo_ + "/";
-
-    // Create the full path for the uploaded file
-    string fullPath = uploadDirectory + filename;
-    size_t fileSize = content.size();
-    if (fileSize > 0)
+    else
     {
-        LOG_DEBUG("File upload: %s, size: %lu", fullPath.c_str(), fileSize);
+        reqRes["err"] = 404;
     }
-    else // 禁止空文件上传
+    reqType_ = GET_INFO;
+    reqRes_ = reqRes.dump();
+}
+
+// 块内容已在接收时写入
+void HttpRequest::HandleUploadChunk_()
+{
+    if (!streaming_ || !chunkSession_)
     {
-        LOG_ERROR("Empty file upload: %s", fullPath.c_str());
-        reqRes["err"] = 400;
-        reqType_ = GET_INFO;
-        reqRes_ = reqRes.dump();
+        ServeStatic_();
         return;
     }
+    streaming_ = false;
+    nlohmann::json reqRes;
+    reqRes["err"] = chunkOk_ ? 0 : 500;
+    reqRes["index"] = chunkIndex_;
+    EndChunk_(chunkOk_);
+    reqType_ = GET_INFO;
+    reqRes_ = reqRes.dump();
+}
 
-    // Save the uploaded file content to the specified location
-    ofstream file(fullPath, ios::out | ios::app | ios::binary);
-    if (file.is_open())
+// upload/commit?id=${id}，所有块到齐后改名为目标文件，返回与上传接口相同
+void HttpRequest::HandleUploadCommit_()
+{
+    nlohmann::json reqRes;
+    UploadSessions::SessionPtr session = FindUploadSession_();
+    int err = 404;
+    if (session)
     {
-        file.write(content.c_str(), fileSize);
-        file.close();
-        LOG_DEBUG("Uploaded file saved: %s", fullPath.c_str());
-        struct stat fileStat;
-        if (stat(fullPath.c_str(), &fileStat) == 0)
+        size_t fileSize = 0;
+        time_t uploadDate = 0;
+        err = session->Commit(fileSize, uploadDate);
+        if (err != 409)
         {
-            reqRes["err"] = 0;
-            reqRes["fileName"] = filename;
-            reqRes["fileSize"] = fileSize;
-            reqRes["uploadDate"] = static_cast<unsigned long long>(fileStat.st_mtime);
+            UploadSessions::Instance()->Remove(session->Id());
         }
-        else
+        if (err == 0)
         {
-            reqRes["err"] = 500;
+            reqRes["fileName"] = session->FileName();
+            reqRes["fileSize"] = fileSize;
+            reqRes["uploadDate"] = static_cast<unsigned long long>(uploadDate);
         }
     }
-    else
+    reqRes["err"] = err;
+    reqType_ = GET_INFO;
+    reqRes_ = reqRes.dump();
+}
+
+// application/json
+void HttpRequest::HandleDelete_()
+{
+    if (!knownHeader_[HDR_CONTENT_TYPE].Equals("application/json"))
+    {
+        ServeStatic_();
+        return;
+    }
+    nlohmann::json jsonRes;
+    ParseJsonData_(body_, jsonRes);
+    int err = 400;
+    nlohmann::json reqRes;
+    if (jsonRes.is_object() && jsonRes.value("file", nlohmann::json()).is_string())
     {
-        LOG_ERROR("Failed to save uploaded file: %s", fullPath.c_str());
-        reqRes["err"] = 403;
+        err = DeleteFile(dataDir_ + "/" + userInfo_ + "/" + jsonRes["file"].get<string>()) ? 0 : 403;
     }
+    reqRes["err"] = err;
     reqType_ = GET_INFO;
     reqRes_ = reqRes.dump();
 }
 
-// Helper function to split string by a delimiter
-vector<string> HttpRequest::SplitString_(const string &str, const string &delimiter)
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// 先按'&'与'='切分再逐段解码，解码结果写入arena_；非法的%转义原样保留
+StrSpan HttpRequest::DecodeUrl_(const char *begin, const char *end)
 {
-    vector<string> parts;
-    size_t start = 0;
-    size_t end = 0;
-    while ((end = str.find(delimiter, start)) != string::npos)
+    char *out = arena_.Alloc(end - begin);
+    size_t len = 0;
+    for (const char *it = begin; it < end; ++it)
     {
-        parts.push_back(str.substr(start, end - start));
-        start = end + delimiter.length();
+        int hi, lo;
+        if (*it == '+')
+        {
+            out[len++] = ' ';
+        }
+        else if (*it == '%' && end - it > 2 && (hi = HexValue(it[1])) >= 0 && (lo = HexValue(it[2])) >= 0)
+        {
+            out[len++] = static_cast<char>(hi * 16 + lo);
+            it += 2;
+        }
+        else
+        {
+            out[len++] = *it;
+        }
     }
-    parts.push_back(str.substr(start));
-    return parts;
+    return StrSpan(out, len);
 }
 
-// Helper function to trim leading and trailing whitespace from a string
-string HttpRequest::TrimString_(const string &str)
+void HttpRequest::ParseUrlencodedData_(const StrSpan &data, SpanPairs &params)
 {
-    size_t firstNotSpace = str.find_first_not_of(" \t\r\n");
-    if (firstNotSpace == string::npos)
+    const char *pos = data.data, *end = data.data + data.len;
+    while (pos < end)
     {
-        return "";
+        const char *amp = static_cast<const char *>(memchr(pos, '&', end - pos));
+        const char *itemEnd = amp ? amp : end;
+        const char *eq = static_cast<const char *>(memchr(pos, '=', itemEnd - pos));
+        if (eq != nullptr)
+        {
+            params.emplace_back(DecodeUrl_(pos, eq), DecodeUrl_(eq + 1, itemEnd));
+        }
+        else if (itemEnd != pos)
+        {
+            params.emplace_back(DecodeUrl_(pos, itemEnd), StrSpan());
+        }
+        pos = itemEnd + 1;
     }
-    size_t lastNotSpace = str.find_last_not_of(" \t\r\n");
-    return str.substr(firstNotSpace, lastNotSpace - firstNotSpace + 1);
+}
+
+void HttpRequest::SetResource_(const string &path)
+{
+    reqRes_.assign(resDir_).append(path);
 }
 
 // Helper function to parse application/json data
@@ -773,10 +1233,11 @@ void HttpRequest::ParseJsonData_(const string &jsonData, nlohmann::json &jsonObj
 
 bool HttpRequest::DeleteFile(const string &path)
 {
-    int result = remove(path.c_str());
-    if (result == 0)
+    if (ObjectStore::Instance()->Remove(path))
     {
         LOG_DEBUG("File deleted successfully: %s", path.c_str());
+        size_t slash = path.rfind('/');
+        ListCache::Instance()->Remove(path.substr(0, slash + 1), path.substr(slash + 1));
         return true;
     }
     else
@@ -786,240 +1247,86 @@ bool HttpRequest::DeleteFile(const string &path)
     }
 }
 
-void HttpRequest::GetFileList(const string &path, nlohmann::json &jsonObject)
+STORE_RESULT HttpRequest::UserVerify(const string &name, const string &pwd, bool isLogin)
 {
-    // Check if the directory exists, and create it if not
-    DIR *dir = opendir(path.c_str());
-    if (dir == nullptr)
+    if (name == "" || pwd == "")
     {
-        LOG_DEBUG("Try to create directory: %s", path.c_str());
-        if (mkdir(path.c_str(), 0777) != 0)
-        {
-            LOG_ERROR("Failed to create directory: %s", path.c_str());
-            return;
-        }
-        dir = opendir(path.c_str());
+        return STORE_FAIL;
     }
+    LOG_INFO("Verify name:%s", name.c_str());
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != nullptr)
+    // 登录时只有缓存的摘要一致才跳过用户存储；密码不一致时可能已在外部修改，仍以数据库为准
+    CredentialCache *cred = CredentialCache::Instance();
+    CredentialCache::RESULT cached = cred->Lookup(name, pwd);
+    if (isLogin && cached == CredentialCache::MATCH)
     {
-        string entryName = entry->d_name;
-        if (entryName == "." || entryName == "..")
-        {
-            continue;
-        }
-
-        string entryPath = path + "/" + entryName;
-
-        struct stat fileStat;
-        if (stat(entryPath.c_str(), &fileStat) != 0)
-        {
-            LOG_ERROR("Failed to get file stat for: %s", entryPath);
-            continue;
-        }
-
-        if (S_ISREG(fileStat.st_mode))
-        {
-            nlohmann::json fileInfo;
-            fileInfo["fileName"] = entryName;
-            fileInfo["fileSize"] = static_cast<unsigned long long>(fileStat.st_size);
-            fileInfo["uploadDate"] = static_cast<unsigned long long>(fileStat.st_mtime);
-            jsonObject.push_back(fileInfo);
-        }
+        return STORE_OK;
     }
-
-    closedir(dir);
-}
-
-bool HttpRequest::UserVerify(const string &name, const string &pwd, bool isLogin)
-{
-    if (name == "" || pwd == "")
+    if (!isLogin && cached != CredentialCache::MISS)
     {
-        return false;
+        LOG_DEBUG("user used!");
+        return STORE_FAIL;
     }
-    LOG_INFO("Verify name:%s pwd:%s", name.c_str(), pwd.c_str());
-    MYSQL *sql;
-    ConnRAII<MYSQL> sqlRAII(&sql, MySQLConnPool::Instance());
-    assert(sql);
-
-    bool flag = false;
-    bool used = false;
-    char order[256] = {0};
-    MYSQL_RES *res = nullptr;
-
-    // 查询用户及密码
-    snprintf(order, 256, "SELECT username, password FROM user WHERE username='%s' LIMIT 1", name.c_str());
-    LOG_DEBUG("%s", order);
 
-    if (mysql_query(sql, order))
+    STORE_RESULT res;
+    if (isLogin)
     {
-        mysql_free_result(res);
-        return false;
+        res = UserStore::Instance()->Verify(name, pwd);
     }
-    res = mysql_store_result(sql);
-
-    while (MYSQL_ROW row = mysql_fetch_row(res))
+    else
     {
-        LOG_DEBUG("MYSQL ROW: %s %s", row[0], row[1]);
-        string password(row[1]);
-        // 登录行为
-        if (isLogin)
-        {
-            if (pwd == password)
-            {
-                // 登录成功
-                flag = true;
-            }
-            else
-            {
-                flag = false;
-                LOG_DEBUG("pwd error!");
-            }
-        }
-        else
-        {
-            used = true;
-            LOG_DEBUG("user used!");
-        }
+        cred->Invalidate(name); // 注册成功前不保留该用户名的任何凭据
+        res = UserStore::Instance()->Register(name, pwd);
     }
-    mysql_free_result(res);
-
-    // 注册行为 且 用户名未被使用
-    if (!isLogin && !used)
+    if (res == STORE_OK)
     {
-        LOG_DEBUG("regirster!");
-        bzero(order, 256);
-        snprintf(order, 256, "INSERT INTO user(username, password) VALUES('%s','%s')", name.c_str(), pwd.c_str());
-        LOG_DEBUG("%s", order);
-        if (mysql_query(sql, order))
-        {
-            LOG_DEBUG("Insert error!");
-            flag = false;
-        }
-        // 注册成功
-        flag = true;
+        cred->Insert(name, pwd); // 覆盖旧密码的摘要
+        LOG_DEBUG("UserVerify success!");
     }
-
-    LOG_DEBUG("UserVerify success!");
-    return flag;
+    return res;
 }
 
-bool HttpRequest::UserVerify(const string &uid, string &userInfo)
+STORE_RESULT HttpRequest::UserVerify(const string &uid, string &userInfo)
 {
     if (uid == "")
     {
-        return false;
+        return STORE_FAIL;
     }
     LOG_DEBUG("Verify uid:%s", uid.c_str());
-    redisContext *redis;
-    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
-    assert(redis);
-
-    bool flag = false;
-    char order[256] = {0};
-    redisReply *reply = nullptr;
-
-    // 检查cookie是否存在并获取username
-    snprintf(order, 256, "HGET %s username", uid.c_str());
-    LOG_DEBUG("%s", order);
-    reply = (redisReply *)redisCommand(redis, order);
-    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
-    {
-        // Handle error
-        if (reply != nullptr)
-            LOG_ERROR("Redis command error: %s", reply->str);
-        return false;
-    }
-    else if (reply->type == REDIS_REPLY_STRING)
+    if (SessionToken::Instance()->IsOpen())
     {
-        // 获取到了用户信息
-        string username = reply->str;
-        userInfo = username; // 将用户名存储到 userInfo
-        flag = true;         // 用户验证成功
+        return SessionToken::Instance()->Verify(uid, userInfo);
     }
-    else if (reply->type == REDIS_REPLY_NIL)
+    STORE_RESULT res = SessionStore::Instance()->Get(SessionStore::SessionKey(uid), userInfo);
+    if (res == STORE_FAIL)
     {
-        // 用户信息不存在
-        LOG_DEBUG("User information not found in Redis");
-        flag = false; // 用户验证失败
+        LOG_DEBUG("User information not found in session store");
     }
-
-    freeReplyObject(reply);
-    return flag;
+    return res;
 }
 
-bool HttpRequest::UserEnroll(const string &userInfo, string &cookie)
+STORE_RESULT HttpRequest::UserEnroll(const string &userInfo, string &cookie)
 {
     if (userInfo == "")
     {
-        return false;
+        return STORE_FAIL;
     }
     LOG_DEBUG("User enroll:%s", userInfo.c_str());
-    redisContext *redis;
-    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
-    assert(redis);
-
-    bool used = false;
     string uid;
     int timeout = 60 * 60 * 24 * 1; // 1 day
-    char order[256] = {0};
-    redisReply *reply = nullptr;
-
-    do
-    {
-        // 检查uid是否存在
-        uid = GenerateRandomID();
-        snprintf(order, 256, "EXISTS %s", uid.c_str());
-        LOG_DEBUG("%s", order);
-        reply = (redisReply *)redisCommand(redis, order);
-        if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
-        {
-            // Handle error
-            if (reply != nullptr)
-                LOG_ERROR("Redis command error: %s", reply->str);
-            return false;
-        }
-        else if (reply->type == REDIS_REPLY_INTEGER)
-        {
-            if (reply->integer == 1)
-            {
-                LOG_DEBUG("uid exists!");
-                used = true;
-            }
-            else
-            {
-                used = false;
-            }
-        }
-    } while (used == true);
-
-    // 设置uid
-    snprintf(order, 256, "HSET %s username %s", uid.c_str(), userInfo.c_str());
-    LOG_DEBUG("%s", order);
-    reply = (redisReply *)redisCommand(redis, order);
-    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
+    if (SessionToken::Instance()->IsOpen())
     {
-        // Handle error
-        if (reply != nullptr)
-            LOG_ERROR("Redis command error: %s", reply->str);
-        return false;
+        uid = SessionToken::Instance()->Issue(userInfo, timeout); // 无需访问session存储
     }
-
-    // 设置过期时间
-    snprintf(order, 256, "EXPIRE %s %d", uid.c_str(), timeout);
-    LOG_DEBUG("%s", order);
-    reply = (redisReply *)redisCommand(redis, order);
-    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
+    else
     {
-        // Handle error
-        if (reply != nullptr)
-            LOG_ERROR("Redis command error: %s", reply->str);
-        return false;
+        STORE_RESULT res = CreateSession_(userInfo, timeout, uid);
+        if (res != STORE_OK)
+        {
+            return res;
+        }
     }
-
-    freeReplyObject(reply);
-
+    SessionCache::Instance()->Insert(uid, true, userInfo); // 新session的后续请求直接命中缓存
     // Get the current time
     chrono::system_clock::time_point now = chrono::system_clock::now();
 
@@ -1039,61 +1346,44 @@ bool HttpRequest::UserEnroll(const string &userInfo, string &cookie)
     string expires_param = expires_str;
 
     cookie = "session_id=" + uid + "; expires=" + expires_param + "; path=/; HttpOnly";
-    return true;
+    return STORE_OK;
 }
 
-bool HttpRequest::UserQuit(const string &uid)
+// 在session存储中创建session，uid为新的session_id
+STORE_RESULT HttpRequest::CreateSession_(const string &userInfo, int timeout, string &uid)
+{
+    const int maxRetry = 3; // uid冲突时重新生成
+    for (int i = 0; i < maxRetry; i++)
+    {
+        uid = GenerateRandomID();
+        STORE_RESULT res = SessionStore::Instance()->Create(SessionStore::SessionKey(uid), userInfo, timeout);
+        if (res != STORE_FAIL)
+        {
+            return res;
+        }
+        LOG_DEBUG("uid exists!");
+    }
+    return STORE_FAIL;
+}
+
+STORE_RESULT HttpRequest::UserQuit(const string &uid)
 {
     if (uid == "")
     {
-        return false;
+        return STORE_FAIL;
     }
     LOG_DEBUG("Verify uid:%s", uid.c_str());
-    redisContext *redis;
-    ConnRAII<redisContext> redisRAII(&redis, RedisConnPool::Instance());
-    assert(redis);
-
-    char order[256] = {0};
-    redisReply *reply = nullptr;
-
-    // 删除uid
-    snprintf(order, 256, "DEL %s", uid.c_str());
-    LOG_DEBUG("%s", order);
-    reply = (redisReply *)redisCommand(redis, order);
-    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR)
-    {
-        // Handle error
-        if (reply != nullptr)
-            LOG_ERROR("Redis command error: %s", reply->str);
-        return false;
+    SessionCache::Instance()->Invalidate(uid);
+    if (SessionToken::Instance()->IsOpen())
+    {
+        return SessionToken::Instance()->Revoke(uid);
     }
-    freeReplyObject(reply);
-    return true;
+    return SessionStore::Instance()->Remove(SessionStore::SessionKey(uid));
 }
 
 string HttpRequest::GenerateRandomID()
 {
-    // Seed for the random number generator
-    random_device rd;
-
-    // Use the Mersenne Twister engine with a random seed
-    mt19937 gen(rd());
-
-    // Define the characters allowed in the uid
-    const string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-
-    // uid length
-    const int uid_length = 16;
-
-    // Generate the uid
-    uniform_int_distribution<> dis(0, characters.size() - 1);
-    string uid;
-    for (int i = 0; i < uid_length; ++i)
-    {
-        uid += characters[dis(gen)];
-    }
-
-    return uid;
+    return RandomID::Generate();
 }
 
 HttpRequest::PARSE_STATE HttpRequest::State() const
@@ -1106,34 +1396,66 @@ string HttpRequest::path() const
     return path_;
 }
 
+string HttpRequest::url() const
+{
+    return url_.str();
+}
+
 HttpRequest::HTTP_METHOD HttpRequest::method() const
 {
     return method_;
 }
 
+string HttpRequest::methodStr() const
+{
+    for (auto &item : HTTP_METHOD_MAP)
+    {
+        if (item.second == method_)
+        {
+            return item.first;
+        }
+    }
+    return "-";
+}
+
 string HttpRequest::version() const
 {
-    return version_;
+    return version_.str();
 }
 
-string HttpRequest::GetBody(const string &key) const
+string HttpRequest::GetHeader(const string &key) const
 {
     assert(key != "");
-    if (bodyRes_.count(key) == 1)
+    HEADER_ID id;
+    if (FindHeaderId_(key.data(), key.size(), id))
     {
-        return bodyRes_.find(key)->second;
+        return GetHeader(id);
     }
-    return "";
+    const StrSpan *value = FindSpan_(header_, key.c_str(), true);
+    return value ? value->str() : "";
+}
+
+string HttpRequest::GetHeader(HEADER_ID id) const
+{
+    assert(id < HDR_COUNT);
+    return knownHeader_[id].str();
+}
+
+string HttpRequest::GetBody(const string &key) const
+{
+    return GetBody(key.c_str());
 }
 
 string HttpRequest::GetBody(const char *key) const
 {
     assert(key != nullptr);
-    if (bodyRes_.count(key) == 1)
-    {
-        return bodyRes_.find(key)->second;
-    }
-    return "";
+    const StrSpan *value = FindSpan_(bodyRes_, key, false);
+    return value ? value->str() : "";
+}
+
+unique_ptr<BodyWriter> HttpRequest::TakeBodyWriter()
+{
+    return move(bodyWriter_);
 }
 
 HttpRequest::REQ_TYPE HttpRequest::reqType() const
@@ -1141,7 +1463,7 @@ HttpRequest::REQ_TYPE HttpRequest::reqType() const
     return reqType_;
 }
 
-string HttpRequest::reqRes() const
+const string &HttpRequest::reqRes() const
 {
     return reqRes_;
 }
@@ -1156,7 +1478,7 @@ HttpRequest::AUTH_STATE HttpRequest::authState() const
     return authState_;
 }
 
-string HttpRequest::authInfo() const
+const string &HttpRequest::authInfo() const
 {
     return authInfo_;
 }
@@ -1165,3 +1487,13 @@ string &HttpRequest::authInfo()
 {
     return authInfo_;
 }
+
+string HttpRequest::userInfo() const
+{
+    return userInfo_;
+}
+
+long long HttpRequest::upstreamUs() const
+{
+    return upstreamUs_;
+}
\ No newline at end of file
@@ -6,13 +6,24 @@
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
-#include <map>
 #include <unordered_map>
-#include <unordered_set>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
 
 #include "json/json.hpp"
-#include "buffer/buffer.h"
+#include "buffer/chainbuffer.h"
+#include "buffer/arena.h"
+#include "http/router.h"
+#include "http/chunked.h"
+#include "http/multipart.h"
+#include "http/uploadsink.h"
+#include "http/uploadsession.h"
+#include "http/bodywriter.h"
+#include "auth/storeresult.h"
+
+struct RedisReply;
 
 class HttpRequest
 {
@@ -53,7 +64,10 @@ public:
         BAD_REQUEST,        // 400
         UNAUTH_REQUEST,     // 401
         FORBIDDENT_REQUEST, // 403
+        METHOD_NOT_ALLOWED, // 405
         INTERNAL_ERROR,     // 500
+        SERVICE_UNAVAILABLE, // 503
+        PENDING_REQUEST,     // 等待异步session查询或文件I/O线程
     };
 
     enum REQ_TYPE
@@ -70,75 +84,192 @@ public:
         AUTH_SET,
         AUTH_PASS,
         AUTH_FAIL,
+        AUTH_BUSY, // 用户/session存储暂不可用
+        AUTH_WAIT, // 已挂起，等待异步session查询返回
+    };
+
+    // 解析时识别的常用头部，按下标直接存取
+    enum HEADER_ID
+    {
+        HDR_HOST,
+        HDR_CONTENT_LENGTH,
+        HDR_CONTENT_TYPE,
+        HDR_CONNECTION,
+        HDR_COOKIE,
+        HDR_RANGE,
+        HDR_IF_NONE_MATCH,
+        HDR_ACCEPT_ENCODING,
+        HDR_TRANSFER_ENCODING,
+        HDR_USER_AGENT,
+        HDR_REFERER,
+        HDR_COUNT,
+    };
+
+    // 路由属性
+    enum ROUTE_FLAG
+    {
+        ROUTE_AUTH = 1,          // 需要有效的session
+        ROUTE_AUTH_OPTIONAL = 2, // 查询session，未登录也交给处理函数
+        ROUTE_BLOCKING = 4,      // 处理函数访问用户/session存储，或响应需要读取文件(页面、下载)
+        ROUTE_STREAM = 8,        // 消息体边接收边处理，读取消息体前鉴权
+        ROUTE_DISK = 16,         // 读写数据目录，鉴权后转交文件I/O线程池
     };
 
     HttpRequest();
     ~HttpRequest() = default;
 
     void Init(const std::string &resDir, const std::string &dataDir);
-    HTTP_CODE parse(Buffer &buff);
+    void Release(); // 连接关闭时归还arena_占用的内存块
+    HTTP_CODE parse(ChainBuffer &buff);
+    HTTP_CODE Resume(ChainBuffer &buff); // 异步session查询返回或转到文件I/O线程后继续处理挂起的请求
     PARSE_STATE State() const;
 
     std::string path() const;
+    std::string url() const;
     HTTP_METHOD method() const;
+    std::string methodStr() const;
     std::string version() const;
+    std::string GetHeader(const std::string &key) const; // 名称不区分大小写
+    std::string GetHeader(HEADER_ID id) const;
     std::string GetBody(const std::string &key) const;
     std::string GetBody(const char *key) const;
     REQ_TYPE reqType() const;
-    std::string reqRes() const;
+    std::unique_ptr<BodyWriter> TakeBodyWriter(); // 分段生成的响应体，为空时内容在reqRes中
+    const std::string &reqRes() const;
     std::string &reqRes();
     AUTH_STATE authState() const;
-    std::string authInfo() const;
+    const std::string &authInfo() const;
     std::string &authInfo();
+    std::string userInfo() const;
+    long long upstreamUs() const;
 
     bool IsKeepAlive() const;
+    bool IsBlocking() const; // 所在路由是否会阻塞于存储或磁盘
+
+    // 原始上传的消息体由连接直接从socket splice到文件，读缓冲区为空时才可使用
+    bool CanSplice() const;
+    ssize_t SpliceBody(int fd, int *saveErrno);
+
+    // 挂起期间待发送的Redis命令，应答由OnSessionReply交回
+    bool IsSuspended() const { return authState_ == AUTH_WAIT; }
+    const std::vector<std::string> &SessionCommand() const { return sessionCmd_; }
+    void OnSessionReply(const RedisReply *reply);
+
+    // 磁盘路由鉴权通过后挂起，由文件I/O线程Resume；之后该请求的读写直到响应发送完毕都在文件I/O线程进行
+    bool IsDiskWait() const { return diskWait_; }
+    bool IsDiskBound() const { return onDisk_; }
+
+    static bool deferDisk; // 是否启用文件I/O线程池
 
 private:
-    LINE_STATE ParseLine_(Buffer &buff, std::string &line);
-    bool ParseRequestLine_(const std::string &line);
-    void ParseHeader_(const std::string &line);
+    // 按出现顺序保存的键值对，指向arena_中的数据；数量少时线性查找快于哈希表
+    typedef std::vector<std::pair<StrSpan, StrSpan>> SpanPairs;
+    typedef void (HttpRequest::*Handler)();
+    typedef Router<Handler> RouteTable;
+
+    LINE_STATE ParseLine_(ChainBuffer &buff, StrSpan &line);
+    static bool ParseLength_(const StrSpan &str, size_t maxLen, size_t &len);
+    HTTP_CODE BeginBody_();
+    HTTP_CODE BeginStream_();
+    HTTP_CODE BeginChunk_();
+    void EndChunk_(bool ok);
+    UploadSessions::SessionPtr FindUploadSession_();
+    LINE_STATE ReadBody_(ChainBuffer &buff);
+    bool OnBody_(const char *data, size_t len);
+    bool ParseRequestLine_(const StrSpan &line);
+    void ParseHeader_(const StrSpan &line);
+    static bool FindHeaderId_(const char *name, size_t len, HEADER_ID &id);
     void ParsePath_();
     void ParseMethod_(const std::string &methodStr);
     void ParseQuery_();
-    void ParseCookies_(const std::string &cookieStr);
+    void ParseCookies_(const StrSpan &cookieStr);
     void CheckCookie_();
-    void ParseRequest_(const std::string &line);
-    void ParseGet_();
-    void ParsePost_();
-    void ParseUrlencodedData_(std::string &data, std::unordered_map<std::string, std::string> &paramMap);
-    void ParseMultipartFormData_(const std::string &data, const std::string &boundary);
-    std::string GetBoundaryFromContentType_(const std::string &contentType);
-    void ParsePartHeaders_(const std::string &headers, std::map<std::string, std::string> &headerMap);
-    void ParseHeaderValueParams_(const std::string &value, std::map<std::string, std::string> &paramMap);
-    void ProcessFormField_(const std::string &paramName, const std::string &fieldValue);
-    void SaveFileUpload_(const std::string &filename, const std::string &content);
-    std::vector<std::string> SplitString_(const std::string &str, const std::string &delimiter);
-    std::string TrimString_(const std::string &str);
+    bool SuspendSession_(const std::string &sid);
+    HTTP_CODE RequestCode_() const;
+    void ParseRequest_();
+    bool Authorize_(unsigned flags);
+    bool DeferDisk_(); // 需要转交文件I/O线程时置diskWait_并返回true
+    void ServeStatic_();
+    void HandleUserPage_();
+    void HandleFileList_();
+    void HandleDownload_();
+    void HandleUserInfo_();
+    void HandleLogout_();
+    void HandleRegister_();
+    void HandleLogin_();
+    void Enroll_(bool isLogin);
+    void HandleUpload_();
+    void HandleUploadCreate_();
+    void HandleUploadStatus_();
+    void HandleUploadChunk_();
+    void HandleUploadCommit_();
+    void HandleDelete_();
+    void ParseUrlencodedData_(const StrSpan &data, SpanPairs &params);
+    StrSpan DecodeUrl_(const char *begin, const char *end);
+    void SetResource_(const std::string &path); // reqRes_ = resDir_ + path，复用已有容量
     void ParseJsonData_(const std::string &jsonData, nlohmann::json &jsonObject);
 
-    static void GetFileList(const std::string &path, nlohmann::json &jsonObject);
     static bool DeleteFile(const std::string &path);
-    static bool UserVerify(const std::string &name, const std::string &pwd, bool isLogin);
-    static bool UserVerify(const std::string &uid, std::string &userInfo);
-    static bool UserEnroll(const std::string &userInfo, std::string &cookie);
-    static bool UserQuit(const std::string &uid);
+    static STORE_RESULT UserVerify(const std::string &name, const std::string &pwd, bool isLogin);
+    static STORE_RESULT UserVerify(const std::string &uid, std::string &userInfo);
+    static STORE_RESULT UserEnroll(const std::string &userInfo, std::string &cookie);
+    static STORE_RESULT CreateSession_(const std::string &userInfo, int timeout, std::string &uid);
+    static STORE_RESULT UserQuit(const std::string &uid);
     static std::string GenerateRandomID();
+    static const StrSpan *FindSpan_(const SpanPairs &pairs, const char *key, bool noCase);
 
     std::string resDir_, dataDir_;
     PARSE_STATE state_;
     HTTP_METHOD method_;
-    std::string url_, path_, query_, version_, body_;
-    std::unordered_map<std::string, std::string> header_, cookies_, queryRes_, bodyRes_;
+    Arena arena_; // 请求行、头部及解析出的参数，每个请求整体重置
+    std::string path_, body_;
+    StrSpan url_, query_, version_;
+    StrSpan knownHeader_[HDR_COUNT]; // 常用头部，未出现时data为nullptr
+    SpanPairs header_, cookies_, queryRes_, bodyRes_; // header_只保存其他头部
+    const RouteTable::Route *route_;
+
+    // 消息体
+    bool chunked_;
+    ChunkedDecoder decoder_;
+    size_t bodyLeft_; // Content-Length分帧时剩余的字节
+    bool bodyOpen_;   // 消息体尚未读完
+    bool streaming_;  // 消息体交给multipart_/upload_
+    bool rawUpload_;  // 消息体即文件内容，不经multipart_
+    MultipartParser multipart_;
+    UploadSink upload_;
+    UploadSessions::SessionPtr chunkSession_; // 正在接收的分块所属的上传会话
+    size_t chunkIndex_;
+    size_t chunkWritten_;
+    bool chunkOk_;
 
     REQ_TYPE reqType_;
     std::string reqRes_;
+    std::unique_ptr<BodyWriter> bodyWriter_;
     AUTH_STATE authState_;
     std::string authInfo_;
     std::string userInfo_; // 此处简化用户信息为username
+    long long upstreamUs_; // 本次请求访问Redis/MySQL的累计耗时(微秒)
+
+    // 异步session查询
+    std::vector<std::string> sessionCmd_;
+    bool sessionReady_; // 应答已返回，等待Resume
+    STORE_RESULT sessionRes_;
+    std::string sessionUser_;
+    std::chrono::steady_clock::time_point suspendAt_;
+
+    bool diskWait_; // 等待转交文件I/O线程
+    bool onDisk_;   // 已在文件I/O线程继续处理
+
+    static const size_t MAX_KEEP_CAPACITY = 256; // Init时保留的body_/reqRes_容量上限，空闲连接只保留几百字节
+    static const size_t MAX_HEADER_NAME = 32;          // 常用头部名称的长度上限
+    static const size_t MAX_BODY_SIZE = 1024 * 1024 * 1024; // 1GB
+    static const size_t MAX_CHUNK_SIZE = 16 * 1024 * 1024;  // chunked单个块的上限
+    static const size_t MAX_BUFFERED_BODY = 1024 * 1024;    // 非流式路由缓存的消息体上限
 
     static const std::unordered_map<std::string, HTTP_METHOD> HTTP_METHOD_MAP;
-    static const std::unordered_set<std::string> DEFAULT_HTML;
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG, SPECIAL_PATH_TAG;
+    static const Router<HEADER_ID> HEADER_IDS;
+    static const Router<const char *> PAGE_ALIAS;
+    static const RouteTable ROUTES;
 };
 
 /*HTTP Status Code
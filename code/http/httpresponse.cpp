@@ -5,6 +5,8 @@
  */
 #include "httpresponse.h"
 
+#include <assert.h>
+#include <stdio.h>    // snprintf
 #include <fcntl.h>    // open
 #include <unistd.h>   // close
 #include <sys/mman.h> // mmap, munmap
@@ -41,7 +43,9 @@ const unordered_map<int, string> HttpResponse::CODE_STATUS = {
     {401, "Unauthorized"},
     {403, "Forbidden"},
     {404, "Not Found"},
+    {405, "Method Not Allowed"},
     {500, "Internal Server Error"},
+    {503, "Service Unavailable"},
 };
 
 const unordered_map<int, string> HttpResponse::CODE_PATH = {
@@ -50,6 +54,7 @@ const unordered_map<int, string> HttpResponse::CODE_PATH = {
     {403, "/403.html"},
     {404, "/404.html"},
     {500, "/500.html"},
+    {503, "/503.html"},
 };
 
 HttpResponse::HttpResponse()
@@ -60,6 +65,7 @@ HttpResponse::HttpResponse()
     reqRes_ = "";
     authState_ = HttpRequest::AUTH_ANON;
     authInfo_ = "";
+    chunked_ = false;
     transMethod_ = NONE;
     FileFd_ = -1;
     FilePtr_ = nullptr;
@@ -76,11 +82,19 @@ void HttpResponse::Init(HttpRequest::REQ_TYPE reqType, string &reqRes, HttpReque
 {
     UnmapFile();
     CloseFile();
+    CloseWriter();
     code_ = code;
     isKeepAlive_ = isKeepAlive;
     resDir_ = resDir;
     reqType_ = reqType;
-    reqRes_ = reqRes;
+    if (reqType == HttpRequest::GET_INFO)
+    {
+        reqRes_.swap(reqRes); // JSON内容直接接管，不再复制
+    }
+    else
+    {
+        reqRes_ = reqRes;
+    }
     authState_ = authState;
     authInfo_ = authInfo;
     transMethod_ = NONE;
@@ -89,8 +103,18 @@ void HttpResponse::Init(HttpRequest::REQ_TYPE reqType, string &reqRes, HttpReque
     FileStat_ = {0};
 }
 
-void HttpResponse::MakeResponse(Buffer &buff)
+void HttpResponse::SetBodyWriter(unique_ptr<BodyWriter> writer, bool chunked)
+{
+    writer_ = move(writer);
+    chunked_ = chunked;
+}
+
+void HttpResponse::MakeResponse(ChainBuffer &buff)
 {
+    if (code_ != 200 || reqType_ != HttpRequest::GET_INFO)
+    {
+        CloseWriter(); // 错误页面等不使用生成的响应体
+    }
     if (code_ == 200)
     {
         // 判断请求的资源类型
@@ -112,6 +136,10 @@ void HttpResponse::MakeResponse(Buffer &buff)
     AddStateLine_(buff);
     AddHeader_(buff);
     AddContent_(buff);
+    if (reqType_ == HttpRequest::GET_INFO)
+    {
+        string().swap(reqRes_); // JSON内容已写入缓冲区，不随连接保留
+    }
 }
 
 HttpResponse::TransMethod HttpResponse::FileTransMethod() const
@@ -143,7 +171,7 @@ void HttpResponse::ErrorHtml_()
     }
 }
 
-void HttpResponse::AddStateLine_(Buffer &buff)
+void HttpResponse::AddStateLine_(ChainBuffer &buff)
 {
     string status;
     if (CODE_STATUS.count(code_))
@@ -158,7 +186,7 @@ void HttpResponse::AddStateLine_(Buffer &buff)
     buff.Append("HTTP/1.1 " + to_string(code_) + " " + status + "\r\n");
 }
 
-void HttpResponse::AddHeader_(Buffer &buff)
+void HttpResponse::AddHeader_(ChainBuffer &buff)
 {
     buff.Append("Connection: ");
     if (isKeepAlive_)
@@ -193,7 +221,7 @@ void HttpResponse::AddHeader_(Buffer &buff)
     }
 }
 
-void HttpResponse::AddContent_(Buffer &buff)
+void HttpResponse::AddContent_(ChainBuffer &buff)
 {
     if (reqType_ == HttpRequest::GET_HTML)
     {
@@ -234,8 +262,47 @@ void HttpResponse::AddContent_(Buffer &buff)
     else if (reqType_ == HttpRequest::GET_INFO)
     {
         transMethod_ = NONE;
-        buff.Append("Content-Length: " + to_string(reqRes_.size()) + "\r\n\r\n");
-        buff.Append(reqRes_);
+        if (writer_ && chunked_)
+        {
+            buff.Append("Transfer-Encoding: chunked\r\n\r\n");
+            ProduceBody(buff);
+        }
+        else if (writer_)
+        {
+            ChainBuffer body;
+            while (writer_->Next(body))
+            {
+            }
+            writer_.reset();
+            buff.Append("Content-Length: " + to_string(body.ReadableBytes()) + "\r\n\r\n");
+            buff.Append(body);
+        }
+        else
+        {
+            buff.Append("Content-Length: " + to_string(reqRes_.size()) + "\r\n\r\n");
+            buff.Append(reqRes_);
+        }
+    }
+}
+
+// 每段编码为一个chunk，数据块整体移入buff而不复制；生成结束时追加终止块
+void HttpResponse::ProduceBody(ChainBuffer &buff)
+{
+    assert(writer_ && chunked_);
+    ChainBuffer chunk;
+    bool more = writer_->Next(chunk);
+    if (chunk.ReadableBytes() > 0)
+    {
+        char head[20];
+        int len = snprintf(head, sizeof(head), "%zx\r\n", chunk.ReadableBytes());
+        buff.Append(head, len);
+        buff.Append(chunk);
+        buff.Append("\r\n", 2);
+    }
+    if (!more)
+    {
+        buff.Append("0\r\n\r\n", 5);
+        writer_.reset();
     }
 }
 
@@ -248,6 +315,11 @@ void HttpResponse::UnmapFile()
     }
 }
 
+void HttpResponse::CloseWriter()
+{
+    writer_.reset();
+}
+
 void HttpResponse::CloseFile()
 {
     if (FileFd_ != -1)
@@ -274,7 +346,7 @@ string HttpResponse::GetFileType_()
     return "application/octet-stream";
 }
 
-void HttpResponse::ErrorContent(Buffer &buff, string message)
+void HttpResponse::ErrorContent(ChainBuffer &buff, string message)
 {
     string body;
     string status;
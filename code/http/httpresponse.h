@@ -8,9 +8,10 @@
 
 #include <unordered_map>
 #include <string>
+#include <memory>
 #include <sys/stat.h> // stat
 
-#include "buffer/buffer.h"
+#include "buffer/chainbuffer.h"
 #include "http/httprequest.h"
 
 class HttpResponse
@@ -27,21 +28,28 @@ public:
     };
 
     void Init(HttpRequest::REQ_TYPE reqType, std::string &reqRes, HttpRequest::AUTH_STATE authState, std::string &authInfo, std::string &resDir, bool isKeepAlive = false, int code = -1);
-    void MakeResponse(Buffer &buff);
+    // 响应体由writer分段生成；chunked为false(HTTP/1.0)时一次生成完毕以得到Content-Length
+    void SetBodyWriter(std::unique_ptr<BodyWriter> writer, bool chunked);
+    void MakeResponse(ChainBuffer &buff);
     void UnmapFile();
     void CloseFile();
+    void CloseWriter();
+
+    // 响应体尚未生成完毕，连接可写时调用ProduceBody追加下一段
+    bool Streaming() const { return writer_ != nullptr; }
+    void ProduceBody(ChainBuffer &buff);
 
     char *FilePtr();
     int FileFd();
     TransMethod FileTransMethod() const;
     size_t FileLen() const;
-    void ErrorContent(Buffer &buff, std::string message);
+    void ErrorContent(ChainBuffer &buff, std::string message);
     int Code() const { return code_; }
 
 private:
-    void AddStateLine_(Buffer &buff);
-    void AddHeader_(Buffer &buff);
-    void AddContent_(Buffer &buff);
+    void AddStateLine_(ChainBuffer &buff);
+    void AddHeader_(ChainBuffer &buff);
+    void AddContent_(ChainBuffer &buff);
 
     void ErrorHtml_();
     std::string GetFileType_();
@@ -54,6 +62,8 @@ private:
     std::string reqRes_;
     HttpRequest::AUTH_STATE authState_;
     std::string authInfo_;
+    std::unique_ptr<BodyWriter> writer_;
+    bool chunked_;
 
     TransMethod transMethod_;
     char *FilePtr_; // mmap
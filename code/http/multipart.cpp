@@ -0,0 +1,225 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "multipart.h"
+
+#include <string.h> // memmem strcasecmp
+#include <algorithm> // min max
+
+using namespace std;
+
+const size_t MultipartParser::MAX_PART_HEADERS;
+
+MultipartParser::MultipartParser() : state_(ERROR), listener_(nullptr) {}
+
+// 首个分隔符前没有CRLF，预置一个使所有分隔符形式相同
+void MultipartParser::Reset(const string &boundary, Listener *listener)
+{
+    state_ = boundary.empty() ? ERROR : PREAMBLE;
+    delim_ = "\r\n--" + boundary;
+    pending_ = "\r\n";
+    part_ = Part();
+    listener_ = listener;
+}
+
+// 只把上次的尾部与本次开头的少量数据拼接，尾部确定后其余数据直接在原缓冲区上解析
+bool MultipartParser::Feed(const char *data, size_t len)
+{
+    if (state_ == ERROR || state_ == EPILOGUE)
+    {
+        return state_ != ERROR;
+    }
+    while (!pending_.empty() && len > 0)
+    {
+        size_t tail = pending_.size();
+        size_t take = min(len, max(tail, delim_.size())); // 部分头部较长时按倍数增长，避免反复扫描
+        pending_.append(data, take);
+        size_t used = Process_(pending_.data(), pending_.size());
+        if (used >= tail)
+        {
+            // 尾部已处理完，本次数据从未处理的位置开始
+            pending_.clear();
+            data += used - tail;
+            len -= used - tail;
+            break;
+        }
+        pending_.erase(0, used);
+        data += take;
+        len -= take;
+    }
+    if (pending_.empty())
+    {
+        size_t used = Process_(data, len);
+        pending_.assign(data + used, len - used);
+    }
+    return state_ != ERROR;
+}
+
+size_t MultipartParser::Process_(const char *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        const char *cur = data + pos;
+        size_t left = len - pos;
+        switch (state_)
+        {
+        case PREAMBLE:
+        case BODY:
+        {
+            const char *hit = static_cast<const char *>(memmem(cur, left, delim_.data(), delim_.size()));
+            // 未找到时保留可能是分隔符前缀的尾部
+            size_t safe = hit ? hit - cur : (left >= delim_.size() ? left - delim_.size() + 1 : 0);
+            if (state_ == BODY && safe > 0)
+            {
+                listener_->OnPartData(cur, safe);
+            }
+            if (hit == nullptr)
+            {
+                return pos + safe;
+            }
+            if (state_ == BODY)
+            {
+                listener_->OnPartEnd();
+            }
+            pos += safe + delim_.size();
+            state_ = DELIMITER;
+            break;
+        }
+        case DELIMITER:
+            if (left < 2)
+            {
+                return pos;
+            }
+            if (cur[0] == '-' && cur[1] == '-')
+            {
+                state_ = EPILOGUE;
+                return len;
+            }
+            if (cur[0] != '\r' || cur[1] != '\n')
+            {
+                state_ = ERROR;
+                return len;
+            }
+            state_ = HEADERS; // CRLF留作头部块的开头，空头部时即为"\r\n\r\n"
+            break;
+        case HEADERS:
+        {
+            const char *end = static_cast<const char *>(memmem(cur, left, "\r\n\r\n", 4));
+            if (end == nullptr)
+            {
+                if (left > MAX_PART_HEADERS)
+                {
+                    state_ = ERROR;
+                    return len;
+                }
+                return pos;
+            }
+            // end == cur 时没有头部
+            if (!ParseHeaders_(cur + 2, end > cur ? end - cur - 2 : 0))
+            {
+                state_ = ERROR;
+                return len;
+            }
+            listener_->OnPartBegin(part_);
+            pos += end - cur + 4;
+            state_ = BODY;
+            break;
+        }
+        case EPILOGUE:
+        case ERROR:
+            return len;
+        }
+    }
+    return pos;
+}
+
+bool MultipartParser::ParseHeaders_(const char *data, size_t len)
+{
+    part_ = Part();
+    size_t pos = 0;
+    while (pos < len)
+    {
+        const char *eol = static_cast<const char *>(memmem(data + pos, len - pos, "\r\n", 2));
+        size_t lineEnd = eol ? eol - data : len;
+        string line(data + pos, lineEnd - pos);
+        pos = lineEnd + 2;
+
+        size_t colon = line.find(':');
+        if (colon == string::npos)
+        {
+            return false;
+        }
+        string name = Trim_(line.substr(0, colon));
+        string value = Trim_(line.substr(colon + 1));
+        if (strcasecmp(name.c_str(), "Content-Disposition") == 0)
+        {
+            ParseParams_(value, part_);
+        }
+        else if (strcasecmp(name.c_str(), "Content-Type") == 0)
+        {
+            part_.contentType = value;
+        }
+    }
+    return true;
+}
+
+// form-data; name="file"; filename="a.txt"
+void MultipartParser::ParseParams_(const string &value, Part &part)
+{
+    size_t pos = value.find(';');
+    while (pos != string::npos)
+    {
+        size_t next = value.find(';', pos + 1);
+        string item = value.substr(pos + 1, next == string::npos ? string::npos : next - pos - 1);
+        pos = next;
+        size_t eq = item.find('=');
+        if (eq == string::npos)
+        {
+            continue;
+        }
+        string key = Trim_(item.substr(0, eq));
+        string val = Trim_(item.substr(eq + 1));
+        if (val.size() >= 2 && val.front() == '"' && val.back() == '"')
+        {
+            val = val.substr(1, val.size() - 2);
+        }
+        if (key == "name")
+        {
+            part.name = val;
+        }
+        else if (key == "filename")
+        {
+            part.filename = val;
+        }
+    }
+}
+
+string MultipartParser::GetBoundary(const string &contentType)
+{
+    size_t pos = contentType.find("boundary=");
+    if (pos == string::npos)
+    {
+        return "";
+    }
+    string boundary = contentType.substr(pos + 9); // 9 is the length of "boundary="
+    boundary = boundary.substr(0, boundary.find(';'));
+    if (boundary.size() >= 2 && boundary.front() == '"' && boundary.back() == '"')
+    {
+        boundary = boundary.substr(1, boundary.size() - 2);
+    }
+    return boundary;
+}
+
+string MultipartParser::Trim_(const string &str)
+{
+    size_t first = str.find_first_not_of(" \t");
+    if (first == string::npos)
+    {
+        return "";
+    }
+    size_t last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
+}
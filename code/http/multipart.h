@@ -0,0 +1,66 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <string>
+
+// multipart/form-data 的增量解析器：数据可分任意多次送入，
+// 各部分的内容边解析边交给Listener，只保留可能构成分隔符的尾部
+class MultipartParser
+{
+public:
+    struct Part
+    {
+        std::string name;
+        std::string filename; // 非空表示文件
+        std::string contentType;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        virtual void OnPartBegin(const Part &part) = 0;
+        virtual void OnPartData(const char *data, size_t len) = 0;
+        virtual void OnPartEnd() = 0;
+    };
+
+    MultipartParser();
+
+    void Reset(const std::string &boundary, Listener *listener);
+    bool Feed(const char *data, size_t len); // 格式错误返回false，之后的数据被忽略
+    bool Finished() const { return state_ == EPILOGUE; }
+
+    // 从Content-Type中取出boundary参数，不存在返回空串
+    static std::string GetBoundary(const std::string &contentType);
+
+    static const size_t MAX_PART_HEADERS = 8 * 1024;
+
+private:
+    enum STATE
+    {
+        PREAMBLE,
+        DELIMITER, // 已匹配分隔符，等待其后的"--"或CRLF
+        HEADERS,
+        BODY,
+        EPILOGUE,
+        ERROR,
+    };
+
+    size_t Process_(const char *data, size_t len); // 返回已处理的字节数
+    bool ParseHeaders_(const char *data, size_t len);
+    static void ParseParams_(const std::string &value, Part &part);
+    static std::string Trim_(const std::string &str);
+
+    STATE state_;
+    std::string delim_;   // CRLF "--" boundary
+    std::string pending_; // 上次未能确定的尾部数据
+    Part part_;
+    Listener *listener_;
+};
+
+#endif // MULTIPART_H
@@ -0,0 +1,235 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "objectstore.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <openssl/evp.h>
+
+#include "log/log.h"
+
+using namespace std;
+
+const char ObjectStore::XATTR_NAME[] = "user.sha256";
+const int ObjectStore::LOCK_NUM;
+
+Sha256::Sha256()
+{
+    ctx_ = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx_, EVP_sha256(), nullptr);
+}
+
+Sha256::~Sha256()
+{
+    EVP_MD_CTX_free(ctx_);
+}
+
+void Sha256::Update(const void *data, size_t len)
+{
+    EVP_DigestUpdate(ctx_, data, len);
+}
+
+string Sha256::HexDigest()
+{
+    static const char HEX[] = "0123456789abcdef";
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_DigestFinal_ex(ctx_, md, &len);
+    string hex(len * 2, '0');
+    for (unsigned int i = 0; i < len; i++)
+    {
+        hex[i * 2] = HEX[md[i] >> 4];
+        hex[i * 2 + 1] = HEX[md[i] & 0xf];
+    }
+    return hex;
+}
+
+bool Sha256::HashFile(int fd, string &hexDigest)
+{
+    Sha256 hash;
+    char buf[64 * 1024];
+    off_t pos = 0;
+    while (true)
+    {
+        ssize_t n = pread(fd, buf, sizeof(buf), pos);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        hash.Update(buf, n);
+        pos += n;
+    }
+    hexDigest = hash.HexDigest();
+    return true;
+}
+
+ObjectStore::ObjectStore() : isOpen_(false) {}
+
+ObjectStore *ObjectStore::Instance()
+{
+    static ObjectStore inst;
+    return &inst;
+}
+
+void ObjectStore::Init(const string &dataDir, bool enable)
+{
+    isOpen_ = false;
+    if (!enable)
+    {
+        return;
+    }
+    objDir_ = dataDir + "/.objects/";
+    mkdir(dataDir.c_str(), 0777);
+    if (mkdir(objDir_.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+        LOG_ERROR("Failed to create object directory: %s", objDir_.c_str());
+        return;
+    }
+    isOpen_ = true;
+    size_t n = Collect(); // 上次运行中断或文件系统不支持扩展属性时留下的对象
+    LOG_INFO("ObjectStore: %s, collected: %zu", objDir_.c_str(), n);
+}
+
+mutex &ObjectStore::Lock_(const string &hexDigest)
+{
+    return locks_[hash<string>()(hexDigest) % LOCK_NUM];
+}
+
+bool ObjectStore::GetDigest_(const string &path, string &hexDigest)
+{
+    char buf[128];
+    ssize_t len = getxattr(path.c_str(), XATTR_NAME, buf, sizeof(buf));
+    if (len != 64)
+    {
+        return false;
+    }
+    hexDigest.assign(buf, len);
+    return hexDigest.find_first_not_of("0123456789abcdef") == string::npos;
+}
+
+void ObjectStore::Release_(const string &hexDigest)
+{
+    string objPath = objDir_ + hexDigest;
+    struct stat objStat;
+    if (stat(objPath.c_str(), &objStat) == 0 && objStat.st_nlink == 1)
+    {
+        unlink(objPath.c_str());
+        LOG_DEBUG("Object released: %s", hexDigest.c_str());
+    }
+}
+
+// 先在目标目录建立临时链接再改名，覆盖同名文件时保持原子
+bool ObjectStore::Commit(const string &tmpPath, const string &hexDigest, const string &target)
+{
+    if (!isOpen_)
+    {
+        return rename(tmpPath.c_str(), target.c_str()) == 0;
+    }
+    string oldDigest;
+    bool replaced = GetDigest_(target, oldDigest);
+
+    string objPath = objDir_ + hexDigest;
+    string linkPath = tmpPath + ".link";
+    bool ok;
+    {
+        lock_guard<mutex> locker(Lock_(hexDigest));
+        if (link(objPath.c_str(), linkPath.c_str()) == 0)
+        {
+            LOG_DEBUG("Duplicate upload: %s -> %s", target.c_str(), hexDigest.c_str());
+            unlink(tmpPath.c_str());
+        }
+        else if (rename(tmpPath.c_str(), objPath.c_str()) != 0)
+        {
+            LOG_ERROR("Failed to store object: %s, errno:%d", objPath.c_str(), errno);
+            return rename(tmpPath.c_str(), target.c_str()) == 0; // 退化为普通文件
+        }
+        else
+        {
+            // 摘要在建立用户链接之前写入，所有链接共享同一inode
+            if (setxattr(objPath.c_str(), XATTR_NAME, hexDigest.data(), hexDigest.size(), 0) != 0)
+            {
+                LOG_WARN("Failed to set object digest: %s, errno:%d", objPath.c_str(), errno);
+            }
+            if (link(objPath.c_str(), linkPath.c_str()) != 0)
+            {
+                LOG_ERROR("Failed to link object: %s, errno:%d", objPath.c_str(), errno);
+                return rename(objPath.c_str(), target.c_str()) == 0;
+            }
+        }
+        // 重复上传同一内容时target与临时链接是同一inode，rename不做任何事，临时链接需另行删除
+        ok = rename(linkPath.c_str(), target.c_str()) == 0;
+        unlink(linkPath.c_str());
+        if (!ok)
+        {
+            Release_(hexDigest);
+        }
+    }
+    if (ok && replaced && oldDigest != hexDigest)
+    {
+        lock_guard<mutex> locker(Lock_(oldDigest));
+        Release_(oldDigest);
+    }
+    return ok;
+}
+
+bool ObjectStore::Remove(const string &path)
+{
+    string hexDigest;
+    if (!isOpen_ || !GetDigest_(path, hexDigest))
+    {
+        return remove(path.c_str()) == 0;
+    }
+    lock_guard<mutex> locker(Lock_(hexDigest));
+    if (remove(path.c_str()) != 0)
+    {
+        return false;
+    }
+    Release_(hexDigest);
+    return true;
+}
+
+size_t ObjectStore::Collect()
+{
+    if (!isOpen_)
+    {
+        return 0;
+    }
+    DIR *dir = opendir(objDir_.c_str());
+    if (dir == nullptr)
+    {
+        return 0;
+    }
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        lock_guard<mutex> locker(Lock_(entry->d_name));
+        string objPath = objDir_ + entry->d_name;
+        struct stat objStat;
+        if (stat(objPath.c_str(), &objStat) == 0 && S_ISREG(objStat.st_mode) && objStat.st_nlink == 1)
+        {
+            unlink(objPath.c_str());
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
@@ -0,0 +1,66 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef OBJECT_STORE_H
+#define OBJECT_STORE_H
+
+#include <mutex>
+#include <string>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+// 流式计算SHA-256，由OpenSSL按CPU选择SHA-NI/AVX2实现
+class Sha256
+{
+public:
+    Sha256();
+    ~Sha256();
+    Sha256(const Sha256 &) = delete;
+    Sha256 &operator=(const Sha256 &) = delete;
+
+    void Update(const void *data, size_t len);
+    std::string HexDigest(); // 结束计算，返回64位小写十六进制串
+
+    static bool HashFile(int fd, std::string &hexDigest); // 从头读取整个文件
+
+private:
+    EVP_MD_CTX *ctx_;
+};
+
+// 内容寻址的去重存储：上传的文件按SHA-256保存在dataDir/.objects/下，用户文件是指向对象的硬链接，
+// 对象的链接数即引用计数；摘要记在对象inode的扩展属性中，删除用户文件时据此找到对象，
+// 只剩对象自身一个链接时删除对象。未开启时所有操作退化为普通的改名与删除
+class ObjectStore
+{
+public:
+    static ObjectStore *Instance();
+
+    void Init(const std::string &dataDir, bool enable); // 开启时清理没有用户文件引用的对象
+    bool IsOpen() const { return isOpen_; }
+
+    // 把已写完的临时文件保存为target，内容已存在时链接到已有对象并删除临时文件
+    bool Commit(const std::string &tmpPath, const std::string &hexDigest, const std::string &target);
+    bool Remove(const std::string &path);
+
+    size_t Collect(); // 删除链接数为1的对象，返回删除的个数
+
+    static const char XATTR_NAME[];
+
+private:
+    ObjectStore();
+    ~ObjectStore() = default;
+
+    std::mutex &Lock_(const std::string &hexDigest);
+    void Release_(const std::string &hexDigest); // 持有对应的锁时调用
+    static bool GetDigest_(const std::string &path, std::string &hexDigest);
+
+    static const int LOCK_NUM = 16;
+
+    bool isOpen_;
+    std::string objDir_;
+    std::mutex locks_[LOCK_NUM]; // 按摘要分段，同一对象的链接与删除互斥
+};
+
+#endif // OBJECT_STORE_H
@@ -0,0 +1,122 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <initializer_list>
+#include <vector>
+
+// 由(method, path)到处理对象的路由表，启动时构造为完美哈希：
+// 选取使所有路由互不冲突的哈希种子，查找时只需一次哈希与一次比较
+template <typename T>
+class Router
+{
+public:
+    struct Route
+    {
+        int method; // 不区分方法的表统一使用同一个值
+        const char *path;
+        T handler;
+        unsigned flags;
+    };
+
+    explicit Router(std::initializer_list<Route> routes);
+
+    const Route *Find(int method, const char *path, size_t len) const;
+    size_t Size() const { return routes_.size(); }
+
+private:
+    static uint32_t Hash_(uint32_t seed, int method, const char *path, size_t len);
+    bool Build_(size_t size);
+
+    static const uint32_t MAX_SEED = 1024; // 超过后扩大槽位再试
+
+    std::vector<Route> routes_;
+    std::vector<size_t> lens_;
+    std::vector<int> slots_; // 槽位->routes_下标，-1为空
+    uint32_t seed_;
+    uint32_t mask_;
+};
+
+template <typename T>
+Router<T>::Router(std::initializer_list<Route> routes) : routes_(routes), seed_(0), mask_(0)
+{
+    for (size_t i = 0; i < routes_.size(); ++i)
+    {
+        lens_.push_back(strlen(routes_[i].path));
+        for (size_t j = 0; j < i; ++j) // 重复的路由无法构造完美哈希
+        {
+            assert(routes_[i].method != routes_[j].method || strcmp(routes_[i].path, routes_[j].path) != 0);
+        }
+    }
+    size_t size = 1;
+    while (size < routes_.size() * 2)
+    {
+        size <<= 1;
+    }
+    while (true)
+    {
+        for (seed_ = 1; seed_ <= MAX_SEED; ++seed_)
+        {
+            if (Build_(size))
+            {
+                return;
+            }
+        }
+        size <<= 1;
+    }
+}
+
+template <typename T>
+const typename Router<T>::Route *Router<T>::Find(int method, const char *path, size_t len) const
+{
+    int idx = slots_[Hash_(seed_, method, path, len) & mask_];
+    if (idx < 0)
+    {
+        return nullptr;
+    }
+    const Route &route = routes_[idx];
+    if (route.method != method || lens_[idx] != len || memcmp(route.path, path, len) != 0)
+    {
+        return nullptr;
+    }
+    return &route;
+}
+
+// FNV-1a，方法作为首字节参与哈希
+template <typename T>
+uint32_t Router<T>::Hash_(uint32_t seed, int method, const char *path, size_t len)
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    h = (h ^ static_cast<uint8_t>(method)) * 16777619u;
+    for (size_t i = 0; i < len; ++i)
+    {
+        h = (h ^ static_cast<uint8_t>(path[i])) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+template <typename T>
+bool Router<T>::Build_(size_t size)
+{
+    slots_.assign(size, -1);
+    mask_ = static_cast<uint32_t>(size - 1);
+    for (size_t i = 0; i < routes_.size(); ++i)
+    {
+        int &slot = slots_[Hash_(seed_, routes_[i].method, routes_[i].path, lens_[i]) & mask_];
+        if (slot != -1)
+        {
+            return false;
+        }
+        slot = static_cast<int>(i);
+    }
+    return true;
+}
+
+#endif // ROUTER_H
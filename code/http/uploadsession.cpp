@@ -0,0 +1,398 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "uploadsession.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "json/json.hpp"
+#include "log/log.h"
+#include "auth/randomid.h"
+#include "auth/sessionstore.h"
+#include "cache/listcache.h"
+#include "uploadsink.h"
+#include "objectstore.h"
+
+using namespace std;
+
+const size_t UploadSessions::MAX_FILE_SIZE;
+const size_t UploadSessions::MIN_CHUNK_SIZE;
+const size_t UploadSessions::MAX_CHUNK_SIZE;
+const size_t UploadSessions::DEFAULT_CHUNK_SIZE;
+
+UploadSession::UploadSession(const string &id, const string &user, const string &dir,
+                             const string &fileName, size_t size, size_t chunkSize)
+    : id_(id), user_(user), dir_(dir), fileName_(fileName), size_(size), chunkSize_(chunkSize),
+      chunks_((size + chunkSize - 1) / chunkSize), fd_(-1), persistTtl_(0),
+      state_(chunks_, CHUNK_MISSING), done_(0), writing_(0), committed_(false),
+      lastActive_(chrono::steady_clock::now())
+{
+    tmpPath_ = dir_ + "." + id_ + ".part";
+}
+
+UploadSession::~UploadSession()
+{
+    if (fd_ != -1)
+    {
+        close(fd_);
+    }
+}
+
+// 创建时按文件大小预分配，空间不足在上传之前就失败
+bool UploadSession::Open(bool create)
+{
+    if (create)
+    {
+        mkdir(dir_.c_str(), 0777); // 用户目录可能尚未创建
+        fd_ = open(tmpPath_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    }
+    else
+    {
+        fd_ = open(tmpPath_.c_str(), O_RDWR | O_CLOEXEC); // 提交时可能需要读出计算摘要
+    }
+    if (fd_ == -1)
+    {
+        LOG_ERROR("Failed to open upload session file: %s", tmpPath_.c_str());
+        return false;
+    }
+    if (create && fallocate(fd_, 0, 0, size_) != 0 && errno != EOPNOTSUPP)
+    {
+        LOG_ERROR("No space for upload session: %s, size: %zu", tmpPath_.c_str(), size_);
+        close(fd_);
+        fd_ = -1;
+        unlink(tmpPath_.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t UploadSession::ChunkLen(size_t index) const
+{
+    return index + 1 < chunks_ ? chunkSize_ : size_ - chunkSize_ * (chunks_ - 1);
+}
+
+// 已完成的块允许重传，内容按偏移覆盖
+int UploadSession::BeginChunk(size_t index, size_t len)
+{
+    lock_guard<mutex> locker(mtx_);
+    lastActive_ = chrono::steady_clock::now();
+    if (committed_)
+    {
+        return 410;
+    }
+    if (index >= chunks_ || len != ChunkLen(index))
+    {
+        return 400;
+    }
+    if (state_[index] == CHUNK_WRITING)
+    {
+        return 409;
+    }
+    if (state_[index] == CHUNK_DONE)
+    {
+        done_--;
+    }
+    state_[index] = CHUNK_WRITING;
+    writing_++;
+    return 0;
+}
+
+// 不同块的偏移互不重叠，pwrite无需加锁
+bool UploadSession::Write(size_t index, size_t offset, const char *data, size_t len)
+{
+    off_t pos = static_cast<off_t>(index * chunkSize_ + offset);
+    while (len > 0)
+    {
+        ssize_t n = pwrite(fd_, data, len, pos);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("Failed to write upload session: %s, errno:%d", tmpPath_.c_str(), errno);
+            return false;
+        }
+        data += n;
+        len -= n;
+        pos += n;
+    }
+    return true;
+}
+
+void UploadSession::EndChunk(size_t index, bool ok)
+{
+    lock_guard<mutex> locker(mtx_);
+    assert(index < chunks_ && state_[index] == CHUNK_WRITING);
+    lastActive_ = chrono::steady_clock::now();
+    writing_--;
+    state_[index] = ok ? CHUNK_DONE : CHUNK_MISSING;
+    if (ok)
+    {
+        done_++;
+        Persist_();
+    }
+}
+
+int UploadSession::Commit(size_t &fileSize, time_t &uploadDate)
+{
+    lock_guard<mutex> locker(mtx_);
+    if (committed_)
+    {
+        return 410;
+    }
+    if (done_ != chunks_ || writing_ > 0)
+    {
+        return 409;
+    }
+    // 各块乱序到达，去重存储的摘要只能在提交时读出整个文件计算
+    string hexDigest;
+    ObjectStore *objects = ObjectStore::Instance();
+    bool hashed = objects->IsOpen() && Sha256::HashFile(fd_, hexDigest);
+    close(fd_);
+    fd_ = -1;
+    string fullPath = dir_ + fileName_;
+    struct stat fileStat;
+    bool saved = hashed ? objects->Commit(tmpPath_, hexDigest, fullPath) : rename(tmpPath_.c_str(), fullPath.c_str()) == 0;
+    if (!saved || stat(fullPath.c_str(), &fileStat) != 0)
+    {
+        LOG_ERROR("Failed to save uploaded file: %s", fullPath.c_str());
+        unlink(tmpPath_.c_str());
+        committed_ = true; // 临时文件已不可用
+        return 500;
+    }
+    LOG_DEBUG("Upload session %s committed: %s, size: %zu", id_.c_str(), fullPath.c_str(), size_);
+    committed_ = true;
+    fileSize = fileStat.st_size;
+    uploadDate = fileStat.st_mtime;
+    ListCache::Instance()->Update(dir_, fileName_, fileSize, uploadDate);
+    return 0;
+}
+
+void UploadSession::Discard()
+{
+    lock_guard<mutex> locker(mtx_);
+    committed_ = true; // 之后的请求返回410
+    if (fd_ != -1)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+    unlink(tmpPath_.c_str());
+}
+
+vector<size_t> UploadSession::Missing()
+{
+    lock_guard<mutex> locker(mtx_);
+    lastActive_ = chrono::steady_clock::now();
+    vector<size_t> missing;
+    for (size_t i = 0; i < chunks_; i++)
+    {
+        if (state_[i] != CHUNK_DONE)
+        {
+            missing.push_back(i);
+        }
+    }
+    return missing;
+}
+
+bool UploadSession::Expired(int ttlSec)
+{
+    lock_guard<mutex> locker(mtx_);
+    return writing_ == 0 && chrono::steady_clock::now() - lastActive_ > chrono::seconds(ttlSec);
+}
+
+string UploadSession::Serialize()
+{
+    lock_guard<mutex> locker(mtx_);
+    return Serialize_();
+}
+
+// 已完成的块记为位图的十六进制串，每字符4块
+string UploadSession::Serialize_() const
+{
+    static const char HEX[] = "0123456789abcdef";
+    string bitmap((chunks_ + 3) / 4, '0');
+    for (size_t i = 0; i < chunks_; i++)
+    {
+        if (state_[i] == CHUNK_DONE)
+        {
+            int bits = bitmap[i / 4] <= '9' ? bitmap[i / 4] - '0' : bitmap[i / 4] - 'a' + 10;
+            bitmap[i / 4] = HEX[bits | (1 << (i % 4))];
+        }
+    }
+    nlohmann::json data;
+    data["user"] = user_;
+    data["dir"] = dir_;
+    data["file"] = fileName_;
+    data["size"] = static_cast<unsigned long long>(size_);
+    data["chunkSize"] = static_cast<unsigned long long>(chunkSize_);
+    data["done"] = bitmap;
+    return data.dump();
+}
+
+// 持有mtx_时调用，保证写入存储的顺序与状态变化一致
+void UploadSession::Persist_() const
+{
+    if (persistTtl_ > 0 && SessionStore::Instance()->Set(UploadSessions::Key_(id_), Serialize_(), persistTtl_) != STORE_OK)
+    {
+        LOG_WARN("Failed to persist upload session: %s", id_.c_str());
+    }
+}
+
+shared_ptr<UploadSession> UploadSession::Restore(const string &id, const string &data)
+{
+    try
+    {
+        nlohmann::json json = nlohmann::json::parse(data);
+        size_t size = json["size"].get<size_t>();
+        size_t chunkSize = json["chunkSize"].get<size_t>();
+        string bitmap = json["done"].get<string>();
+        if (size == 0 || chunkSize == 0 || bitmap.size() != ((size + chunkSize - 1) / chunkSize + 3) / 4)
+        {
+            return nullptr;
+        }
+        shared_ptr<UploadSession> session = make_shared<UploadSession>(
+            id, json["user"].get<string>(), json["dir"].get<string>(), json["file"].get<string>(), size, chunkSize);
+        for (size_t i = 0; i < session->chunks_; i++)
+        {
+            char c = bitmap[i / 4];
+            int bits = c <= '9' ? c - '0' : c - 'a' + 10;
+            if (bits & (1 << (i % 4)))
+            {
+                session->state_[i] = CHUNK_DONE;
+                session->done_++;
+            }
+        }
+        return session;
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        LOG_ERROR("Invalid upload session %s: %s", id.c_str(), e.what());
+        return nullptr;
+    }
+}
+
+UploadSessions::UploadSessions() : ttlSec_(24 * 3600), persist_(false) {}
+
+UploadSessions *UploadSessions::Instance()
+{
+    static UploadSessions inst;
+    return &inst;
+}
+
+void UploadSessions::Init(int ttlSec, bool persist)
+{
+    ttlSec_ = ttlSec;
+    persist_ = persist;
+}
+
+UploadSessions::SessionPtr UploadSessions::Create(const string &user, const string &dir, const string &fileName,
+                                                  size_t size, size_t chunkSize, int &err)
+{
+    if (chunkSize == 0)
+    {
+        chunkSize = DEFAULT_CHUNK_SIZE;
+    }
+    if (!UploadSink::ValidFileName(fileName) || size == 0 || size > MAX_FILE_SIZE ||
+        chunkSize < MIN_CHUNK_SIZE || chunkSize > MAX_CHUNK_SIZE)
+    {
+        err = 400;
+        return nullptr;
+    }
+    SessionPtr session = make_shared<UploadSession>(RandomID::Generate(), user, dir, fileName, size, chunkSize);
+    if (!session->Open(true))
+    {
+        err = 500;
+        return nullptr;
+    }
+    if (persist_)
+    {
+        session->SetPersist(ttlSec_);
+        if (SessionStore::Instance()->Set(Key_(session->Id()), session->Serialize(), ttlSec_) != STORE_OK)
+        {
+            LOG_WARN("Failed to persist upload session: %s", session->Id().c_str());
+        }
+    }
+    lock_guard<mutex> locker(mtx_);
+    Sweep_();
+    sessions_[session->Id()] = session;
+    err = 0;
+    return session;
+}
+
+UploadSessions::SessionPtr UploadSessions::Find(const string &id, const string &user)
+{
+    SessionPtr session;
+    {
+        lock_guard<mutex> locker(mtx_);
+        auto it = sessions_.find(id);
+        if (it != sessions_.end())
+        {
+            session = it->second;
+        }
+    }
+    // 重启后从存储中恢复，临时文件仍在原处
+    string data;
+    if (!session && persist_ && SessionStore::Instance()->Get(Key_(id), data) == STORE_OK)
+    {
+        session = UploadSession::Restore(id, data);
+        if (session && session->Open(false))
+        {
+            session->SetPersist(ttlSec_);
+            lock_guard<mutex> locker(mtx_);
+            session = sessions_.emplace(id, session).first->second; // 并发恢复时以先插入的为准
+        }
+        else
+        {
+            session.reset();
+        }
+    }
+    if (session && session->User() != user)
+    {
+        return nullptr;
+    }
+    return session;
+}
+
+void UploadSessions::Remove(const string &id)
+{
+    {
+        lock_guard<mutex> locker(mtx_);
+        sessions_.erase(id);
+    }
+    if (persist_)
+    {
+        SessionStore::Instance()->Remove(Key_(id));
+    }
+}
+
+size_t UploadSessions::Size()
+{
+    lock_guard<mutex> locker(mtx_);
+    return sessions_.size();
+}
+
+// 在创建新会话时清理长期未活动的会话；存储中的记录由其过期时间清理
+void UploadSessions::Sweep_()
+{
+    for (auto it = sessions_.begin(); it != sessions_.end();)
+    {
+        if (it->second->Expired(ttlSec_))
+        {
+            LOG_INFO("Upload session expired: %s", it->first.c_str());
+            it->second->Discard();
+            it = sessions_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
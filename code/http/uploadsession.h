@@ -0,0 +1,115 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef UPLOAD_SESSION_H
+#define UPLOAD_SESSION_H
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <time.h>
+
+// 可续传的分块上传：创建时按文件大小预分配隐藏的临时文件，各块按偏移pwrite写入，
+// 可在多个连接上并发上传，全部到齐后提交，改名为目标文件
+class UploadSession
+{
+public:
+    UploadSession(const std::string &id, const std::string &user, const std::string &dir,
+                  const std::string &fileName, size_t size, size_t chunkSize);
+    ~UploadSession(); // 只关闭文件，临时文件由Discard删除，重启后可继续上传
+    UploadSession(const UploadSession &) = delete;
+    UploadSession &operator=(const UploadSession &) = delete;
+
+    bool Open(bool create); // create为false时打开已有的临时文件
+
+    // 与上传接口一致的错误码：0成功，400参数错误，409该块正在上传或未到齐，410已提交，500写入失败
+    int BeginChunk(size_t index, size_t len);
+    bool Write(size_t index, size_t offset, const char *data, size_t len); // offset为块内偏移
+    void EndChunk(size_t index, bool ok);
+    int Commit(size_t &fileSize, time_t &uploadDate);
+    void Discard(); // 删除临时文件
+
+    std::vector<size_t> Missing();
+    bool Expired(int ttlSec); // 超过ttl未活动且没有正在上传的块
+
+    const std::string &Id() const { return id_; }
+    const std::string &User() const { return user_; }
+    const std::string &FileName() const { return fileName_; }
+    size_t Size() const { return size_; }
+    size_t ChunkSize() const { return chunkSize_; }
+    size_t Chunks() const { return chunks_; }
+    size_t ChunkLen(size_t index) const;
+
+    // 持久化的内容：用户、目录、文件名、大小、块大小及已完成块的位图
+    std::string Serialize();
+    static std::shared_ptr<UploadSession> Restore(const std::string &id, const std::string &data);
+
+    void SetPersist(int ttlSec) { persistTtl_ = ttlSec; }
+
+private:
+    enum CHUNK_STATE : char
+    {
+        CHUNK_MISSING,
+        CHUNK_WRITING,
+        CHUNK_DONE,
+    };
+
+    std::string Serialize_() const;
+    void Persist_() const;
+
+    const std::string id_, user_, dir_, fileName_;
+    const size_t size_, chunkSize_, chunks_;
+    std::string tmpPath_;
+    int fd_;
+    int persistTtl_; // 大于0时每块完成后写入SessionStore
+
+    std::mutex mtx_;
+    std::vector<char> state_;
+    size_t done_;    // 已完成的块数
+    size_t writing_; // 正在上传的块数
+    bool committed_;
+    std::chrono::steady_clock::time_point lastActive_;
+};
+
+// 进程内的上传会话表；开启持久化时会话同时写入SessionStore(Redis)，重启后按id恢复
+class UploadSessions
+{
+public:
+    typedef std::shared_ptr<UploadSession> SessionPtr;
+
+    static UploadSessions *Instance();
+
+    void Init(int ttlSec, bool persist);
+
+    // chunkSize为0时使用默认值；失败时返回空指针，err为上传接口的错误码
+    SessionPtr Create(const std::string &user, const std::string &dir, const std::string &fileName,
+                      size_t size, size_t chunkSize, int &err);
+    SessionPtr Find(const std::string &id, const std::string &user); // 不属于该用户时返回空指针
+    void Remove(const std::string &id);                               // 提交后移除
+    size_t Size();
+
+    static const size_t MAX_FILE_SIZE = 64ULL * 1024 * 1024 * 1024;
+    static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+    static const size_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+    static const size_t DEFAULT_CHUNK_SIZE = 8 * 1024 * 1024;
+
+private:
+    UploadSessions();
+    ~UploadSessions() = default;
+
+    void Sweep_(); // 调用方持有mtx_
+    static std::string Key_(const std::string &id) { return "upload:" + id; }
+    friend class UploadSession; // Persist_使用Key_
+
+    int ttlSec_;
+    bool persist_;
+    std::mutex mtx_;
+    std::unordered_map<std::string, SessionPtr> sessions_;
+};
+
+#endif // UPLOAD_SESSION_H
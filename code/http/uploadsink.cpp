@@ -0,0 +1,292 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "uploadsink.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h> // NAME_MAX
+#include <unistd.h>
+#include <assert.h>
+#include <sys/stat.h>
+
+#include "log/log.h"
+#include "auth/randomid.h"
+#include "cache/listcache.h"
+
+using namespace std;
+
+const size_t UploadSink::MAX_FIELD;
+const int UploadSink::PIPE_SIZE;
+
+UploadSink::UploadSink() : state_(IDLE), sizeHint_(0), fd_(-1), spliceFile_(true), err_(400), saved_(false), fileSize_(0), uploadDate_(0)
+{
+    pipe_[0] = pipe_[1] = -1;
+}
+
+UploadSink::~UploadSink()
+{
+    Abort();
+}
+
+void UploadSink::Open(const string &dir, size_t sizeHint)
+{
+    Abort();
+    dir_ = dir;
+    sizeHint_ = sizeHint;
+    err_ = 400; // 未收到文件部分
+    saved_ = false;
+    fileName_.clear();
+    fileSize_ = 0;
+    uploadDate_ = 0;
+}
+
+void UploadSink::Abort()
+{
+    if (fd_ != -1)
+    {
+        close(fd_);
+        fd_ = -1;
+        unlink(tmpPath_.c_str());
+        LOG_WARN("Upload aborted: %s%s", dir_.c_str(), fileName_.c_str());
+    }
+    ClosePipe_();
+    state_ = IDLE;
+}
+
+void UploadSink::ClosePipe_()
+{
+    if (pipe_[0] != -1)
+    {
+        close(pipe_[0]);
+        close(pipe_[1]);
+        pipe_[0] = pipe_[1] = -1;
+    }
+}
+
+// 文件名作为用户目录下的单层名称使用，'.'开头的名称留给临时文件
+bool UploadSink::ValidFileName(const string &name)
+{
+    return !name.empty() && name.size() <= NAME_MAX && name[0] != '.' && name.find('/') == string::npos;
+}
+
+void UploadSink::OnPartBegin(const MultipartParser::Part &part)
+{
+    if (part.filename.empty())
+    {
+        state_ = FIELD_PART;
+        fieldName_ = part.name;
+        fieldValue_.clear();
+        return;
+    }
+    if (!fileName_.empty())
+    {
+        state_ = SKIP_PART; // 只处理第一个文件
+        return;
+    }
+    fileName_ = part.filename;
+    CreateFile_();
+}
+
+bool UploadSink::OpenFile(const string &name)
+{
+    fileName_ = name;
+    if (!CreateFile_())
+    {
+        return false;
+    }
+    // 管道创建失败时不影响上传，只是不再splice
+    if (pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) == 0)
+    {
+        fcntl(pipe_[1], F_SETPIPE_SZ, PIPE_SIZE);
+    }
+    spliceFile_ = true;
+    return true;
+}
+
+// 按消息体长度预分配，空间不足时在接收数据之前就失败；多出的部分在完成时截掉
+bool UploadSink::CreateFile_()
+{
+    state_ = SKIP_PART;
+    if (!ValidFileName(fileName_))
+    {
+        LOG_ERROR("Invalid filename for uploaded file.");
+        return false;
+    }
+    mkdir(dir_.c_str(), 0777); // 用户目录可能尚未创建
+    tmpPath_ = dir_ + "." + RandomID::Generate() + ".part";
+    fd_ = open(tmpPath_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ == -1)
+    {
+        LOG_ERROR("Failed to save uploaded file: %s%s", dir_.c_str(), fileName_.c_str());
+        err_ = 403;
+        return false;
+    }
+    if (sizeHint_ > 0 && fallocate(fd_, 0, 0, sizeHint_) != 0 && (errno == ENOSPC || errno == EFBIG))
+    {
+        LOG_ERROR("No space for uploaded file: %s%s, size: %zu", dir_.c_str(), fileName_.c_str(), sizeHint_);
+        err_ = 500;
+        close(fd_);
+        fd_ = -1;
+        unlink(tmpPath_.c_str());
+        return false;
+    }
+    hash_.reset(ObjectStore::Instance()->IsOpen() ? new Sha256() : nullptr);
+    state_ = FILE_PART;
+    return true;
+}
+
+void UploadSink::OnPartData(const char *data, size_t len)
+{
+    if (state_ == FIELD_PART)
+    {
+        fieldValue_.append(data, min(len, MAX_FIELD - min(MAX_FIELD, fieldValue_.size())));
+        return;
+    }
+    Write(data, len);
+}
+
+void UploadSink::Write(const char *data, size_t len)
+{
+    if (state_ != FILE_PART)
+    {
+        return;
+    }
+    while (len > 0)
+    {
+        ssize_t n = write(fd_, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            WriteFailed_();
+            return;
+        }
+        if (hash_)
+        {
+            hash_->Update(data, n);
+        }
+        data += n;
+        len -= n;
+        fileSize_ += n;
+    }
+}
+
+void UploadSink::WriteFailed_()
+{
+    LOG_ERROR("Failed to write uploaded file: %s, errno:%d", tmpPath_.c_str(), errno);
+    err_ = 500;
+    state_ = SKIP_PART;
+    close(fd_);
+    fd_ = -1;
+    unlink(tmpPath_.c_str());
+}
+
+// socket -> 管道 -> 临时文件，数据不进入用户空间；文件系统不支持splice时从管道读出后写入
+ssize_t UploadSink::Splice(int sockFd, size_t len, int *saveErrno)
+{
+    assert(CanSplice());
+    ssize_t n = splice(sockFd, nullptr, pipe_[1], nullptr, min(len, static_cast<size_t>(PIPE_SIZE)),
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n <= 0)
+    {
+        *saveErrno = n < 0 ? errno : 0;
+        return n;
+    }
+    size_t left = n;
+    while (left > 0 && spliceFile_ && state_ == FILE_PART)
+    {
+        ssize_t m = splice(pipe_[0], nullptr, fd_, nullptr, left, SPLICE_F_MOVE);
+        if (m > 0)
+        {
+            left -= m;
+            fileSize_ += m;
+        }
+        else if (m == 0 || errno == EINVAL)
+        {
+            spliceFile_ = false;
+        }
+        else if (errno != EINTR)
+        {
+            WriteFailed_();
+        }
+    }
+    // 管道中剩余的数据必须取出，写入失败后丢弃
+    char buf[16 * 1024];
+    while (left > 0)
+    {
+        ssize_t m = read(pipe_[0], buf, min(left, sizeof(buf)));
+        if (m <= 0)
+        {
+            if (m < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        left -= m;
+        Write(buf, m);
+    }
+    return n;
+}
+
+void UploadSink::Commit()
+{
+    if (state_ == FILE_PART)
+    {
+        Finish_();
+    }
+    ClosePipe_();
+    state_ = IDLE;
+}
+
+void UploadSink::OnPartEnd()
+{
+    if (state_ == FIELD_PART)
+    {
+        LOG_DEBUG("Form field: %s = %s", fieldName_.c_str(), fieldValue_.c_str());
+    }
+    else if (state_ == FILE_PART)
+    {
+        Finish_();
+    }
+    state_ = IDLE;
+}
+
+// 文件部分完整接收后改名为目标文件，同名文件被覆盖；开启去重存储时存为对象的链接
+void UploadSink::Finish_()
+{
+    if (sizeHint_ > fileSize_ && ftruncate(fd_, fileSize_) != 0)
+    {
+        LOG_WARN("Failed to truncate uploaded file: %s", tmpPath_.c_str());
+    }
+    close(fd_);
+    fd_ = -1;
+    string fullPath = dir_ + fileName_;
+    if (fileSize_ == 0) // 禁止空文件上传
+    {
+        LOG_ERROR("Empty file upload: %s", fullPath.c_str());
+        unlink(tmpPath_.c_str());
+        err_ = 400;
+        return;
+    }
+    struct stat fileStat;
+    if (!ObjectStore::Instance()->Commit(tmpPath_, hash_ ? hash_->HexDigest() : "", fullPath) ||
+        stat(fullPath.c_str(), &fileStat) != 0)
+    {
+        LOG_ERROR("Failed to save uploaded file: %s", fullPath.c_str());
+        unlink(tmpPath_.c_str());
+        err_ = 500;
+        return;
+    }
+    LOG_DEBUG("Uploaded file saved: %s, size: %lu", fullPath.c_str(), fileSize_);
+    err_ = 0;
+    saved_ = true;
+    uploadDate_ = fileStat.st_mtime;
+    ListCache::Instance()->Update(dir_, fileName_, fileSize_, uploadDate_);
+}
@@ -0,0 +1,84 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef UPLOAD_SINK_H
+#define UPLOAD_SINK_H
+
+#include <string>
+#include <memory>
+#include <time.h>
+#include <sys/types.h>
+
+#include "multipart.h"
+#include "objectstore.h"
+
+// 上传请求的文件部分边接收边写入用户目录：先写入隐藏的临时文件，
+// 该部分结束后再改名为目标文件名，请求中断时删除临时文件
+// 每个请求只保存第一个文件部分；原始上传时整个消息体即文件内容，可经管道splice直接写入
+class UploadSink : public MultipartParser::Listener
+{
+public:
+    UploadSink();
+    ~UploadSink();
+    UploadSink(const UploadSink &) = delete;
+    UploadSink &operator=(const UploadSink &) = delete;
+
+    void Open(const std::string &dir, size_t sizeHint = 0); // dir以'/'结尾，sizeHint为消息体长度，用于预分配
+    void Abort();                                           // 丢弃未完成的临时文件
+
+    // 原始上传：OpenFile后消息体经Write或Splice写入，接收完毕时Commit
+    bool OpenFile(const std::string &name);
+    void Write(const char *data, size_t len);
+    ssize_t Splice(int sockFd, size_t len, int *saveErrno); // 返回值与read相同
+    void Commit();
+    bool CanSplice() const { return state_ == FILE_PART && pipe_[0] != -1 && !hash_; } // 去重存储需在写入时计算摘要
+
+    void OnPartBegin(const MultipartParser::Part &part) override;
+    void OnPartData(const char *data, size_t len) override;
+    void OnPartEnd() override;
+
+    // 与原有上传接口一致：0成功，400文件名非法或空文件，403无法创建，500写入失败
+    int Error() const { return err_; }
+    bool Saved() const { return saved_; }
+    const std::string &FileName() const { return fileName_; }
+    size_t FileSize() const { return fileSize_; }
+    time_t UploadDate() const { return uploadDate_; }
+
+    static bool ValidFileName(const std::string &name);
+
+    static const size_t MAX_FIELD = 1024; // 普通表单字段只保留前若干字节用于日志
+    static const int PIPE_SIZE = 1024 * 1024; // splice所用管道的容量，设置失败时为系统默认值
+
+private:
+    enum STATE
+    {
+        IDLE,
+        FILE_PART,
+        FIELD_PART,
+        SKIP_PART,
+    };
+
+    bool CreateFile_();
+    void WriteFailed_();
+    void ClosePipe_();
+    void Finish_();
+
+    STATE state_;
+    std::string dir_;
+    std::string tmpPath_;
+    size_t sizeHint_;
+    int fd_;
+    int pipe_[2];
+    bool spliceFile_; // 管道到文件的splice可用，否则从管道读出后写入
+    std::unique_ptr<Sha256> hash_; // 开启去重存储时边写入边计算
+    int err_;
+    bool saved_;
+    std::string fileName_;
+    size_t fileSize_;
+    time_t uploadDate_;
+    std::string fieldName_, fieldValue_;
+};
+
+#endif // UPLOAD_SINK_H
@@ -0,0 +1,301 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "accesslog.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <fcntl.h>    // open
+#include <unistd.h>   // write, close
+#include <sys/stat.h> // mkdir
+
+using namespace std;
+
+AccessLog::AccessLog()
+{
+    fd_ = -1;
+    format_ = COMBINED;
+    flushBytes_ = 64 * 1024;
+    flushIntervalMS_ = 1000;
+    isOpen_ = false;
+    dropped_ = 0;
+    isClose_ = false;
+    writeThread_ = nullptr;
+}
+
+AccessLog::~AccessLog()
+{
+    Close();
+}
+
+AccessLog *AccessLog::Instance()
+{
+    static AccessLog inst;
+    return &inst;
+}
+
+bool AccessLog::Init(const char *path, const char *fileName, int format, size_t flushBytes, int flushIntervalMS)
+{
+    Close();
+
+    char fullName[LOG_NAME_LEN] = {0};
+    snprintf(fullName, LOG_NAME_LEN - 1, "%s/%s", path, fileName);
+    fd_ = open(fullName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        mkdir(path, 0777);
+        fd_ = open(fullName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+    }
+
+    format_ = (format >= COMMON && format <= JSON) ? format : COMBINED;
+    flushBytes_ = flushBytes > 0 ? flushBytes : 64 * 1024;
+    flushIntervalMS_ = flushIntervalMS > 0 ? flushIntervalMS : 1000;
+    frontBuff_.reserve(flushBytes_ * 2);
+    backBuff_.reserve(flushBytes_ * 2);
+    isClose_ = false;
+    dropped_ = 0;
+    writeThread_.reset(new thread(&AccessLog::WriteLoop_, this));
+    isOpen_ = true;
+    return true;
+}
+
+void AccessLog::Close()
+{
+    isOpen_ = false;
+    if (writeThread_ && writeThread_->joinable())
+    {
+        {
+            lock_guard<mutex> locker(mtx_);
+            isClose_ = true;
+        }
+        cond_.notify_one();
+        writeThread_->join(); // 退出前写完剩余日志
+    }
+    writeThread_ = nullptr;
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void AccessLog::Append(const AccessRecord &rec)
+{
+    if (!isOpen_)
+    {
+        return;
+    }
+
+    // 锁外格式化，临界区只做一次内存拷贝
+    char line[LINE_MAX_LEN];
+    size_t n = (format_ == JSON) ? FormatJson_(rec, line, sizeof(line)) : FormatCommon_(rec, line, sizeof(line));
+
+    bool needFlush = false;
+    {
+        lock_guard<mutex> locker(mtx_);
+        if (frontBuff_.size() + n > MAX_PENDING_BYTES)
+        {
+            dropped_++;
+            return;
+        }
+        frontBuff_.append(line, n);
+        needFlush = frontBuff_.size() >= flushBytes_;
+    }
+    if (needFlush)
+    {
+        cond_.notify_one();
+    }
+}
+
+void AccessLog::WriteLoop_()
+{
+    unique_lock<mutex> locker(mtx_);
+    while (true)
+    {
+        cond_.wait_for(locker, chrono::milliseconds(flushIntervalMS_), [this]
+                       { return isClose_ || frontBuff_.size() >= flushBytes_; });
+        bool closing = isClose_;
+        if (!frontBuff_.empty())
+        {
+            frontBuff_.swap(backBuff_);
+            locker.unlock();
+
+            // 一次系统调用写出整个批次
+            const char *data = backBuff_.data();
+            size_t left = backBuff_.size();
+            while (left > 0)
+            {
+                ssize_t len = ::write(fd_, data, left);
+                if (len < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    break;
+                }
+                data += len;
+                left -= len;
+            }
+            backBuff_.clear();
+
+            locker.lock();
+        }
+        if (closing && frontBuff_.empty())
+        {
+            break;
+        }
+    }
+}
+
+const char *AccessLog::TimeStr_(bool iso8601)
+{
+    // 同一秒内的请求复用格式化结果
+    thread_local time_t lastSec = 0;
+    thread_local bool lastIso = false;
+    thread_local char timeStr[64] = {0};
+
+    time_t now = time(nullptr);
+    if (now != lastSec || iso8601 != lastIso)
+    {
+        struct tm t;
+        localtime_r(&now, &t);
+        strftime(timeStr, sizeof(timeStr), iso8601 ? "%Y-%m-%dT%H:%M:%S%z" : "%d/%b/%Y:%H:%M:%S %z", &t);
+        lastSec = now;
+        lastIso = iso8601;
+    }
+    return timeStr;
+}
+
+size_t AccessLog::FormatCommon_(const AccessRecord &rec, char *buf, size_t len)
+{
+    // 来自客户端的字段需转义，避免伪造引号内的内容或插入新行
+    char path[1024], user[128], version[64];
+    path[EscapeClf_(rec.path, path, sizeof(path))] = '\0';
+    user[EscapeClf_(rec.user, user, sizeof(user))] = '\0';
+    version[EscapeClf_(rec.version, version, sizeof(version))] = '\0';
+
+    // host ident authuser [date] "request" status bytes ["referer" "user-agent"] rt urt
+    int n = snprintf(buf, len, "%s - %s [%s] \"%s %s HTTP/%s\" %d %zu",
+                     rec.clientIP.empty() ? "-" : rec.clientIP.c_str(),
+                     rec.user.empty() ? "-" : user,
+                     TimeStr_(false),
+                     rec.method.c_str(), path, version,
+                     rec.status, rec.bytesSent);
+    if (n < 0 || static_cast<size_t>(n) >= len)
+    {
+        n = len - 1;
+    }
+    size_t pos = n;
+
+    if (format_ == COMBINED && pos < len)
+    {
+        char referer[1024], ua[1024];
+        referer[EscapeClf_(rec.referer, referer, sizeof(referer))] = '\0';
+        ua[EscapeClf_(rec.userAgent, ua, sizeof(ua))] = '\0';
+        n = snprintf(buf + pos, len - pos, " \"%s\" \"%s\"",
+                     rec.referer.empty() ? "-" : referer,
+                     rec.userAgent.empty() ? "-" : ua);
+        pos = (n < 0 || static_cast<size_t>(n) >= len - pos) ? len - 1 : pos + n;
+    }
+
+    if (pos < len)
+    {
+        n = snprintf(buf + pos, len - pos, " rt=%lld.%06lld urt=%lld.%06lld",
+                     rec.latencyUs / 1000000, rec.latencyUs % 1000000,
+                     rec.upstreamUs / 1000000, rec.upstreamUs % 1000000);
+        pos = (n < 0 || static_cast<size_t>(n) >= len - pos) ? len - 1 : pos + n;
+    }
+
+    // 保证以换行结尾
+    if (pos >= len - 1)
+    {
+        pos = len - 2;
+    }
+    buf[pos++] = '\n';
+    return pos;
+}
+
+size_t AccessLog::EscapeJson_(const string &str, char *buf, size_t len)
+{
+    size_t pos = 0;
+    for (unsigned char c : str)
+    {
+        if (pos + 6 >= len)
+        {
+            break;
+        }
+        if (c == '"' || c == '\\')
+        {
+            buf[pos++] = '\\';
+            buf[pos++] = c;
+        }
+        else if (c < 0x20)
+        {
+            pos += snprintf(buf + pos, len - pos, "\\u%04x", c);
+        }
+        else
+        {
+            buf[pos++] = c;
+        }
+    }
+    return pos;
+}
+
+// 与nginx一致：引号、反斜杠、控制字符及非ASCII字节写为\xHH
+size_t AccessLog::EscapeClf_(const string &str, char *buf, size_t len)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+    size_t pos = 0;
+    for (unsigned char c : str)
+    {
+        if (pos + 5 >= len)
+        {
+            break;
+        }
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x7f)
+        {
+            buf[pos++] = '\\';
+            buf[pos++] = 'x';
+            buf[pos++] = HEX[c >> 4];
+            buf[pos++] = HEX[c & 0xf];
+        }
+        else
+        {
+            buf[pos++] = c;
+        }
+    }
+    return pos;
+}
+
+size_t AccessLog::FormatJson_(const AccessRecord &rec, char *buf, size_t len)
+{
+    // 可能包含特殊字符的字段需转义，version只校验了前缀
+    char path[1024], user[128], referer[1024], ua[1024], version[64];
+    version[EscapeJson_(rec.version, version, sizeof(version))] = '\0';
+    path[EscapeJson_(rec.path, path, sizeof(path))] = '\0';
+    user[EscapeJson_(rec.user, user, sizeof(user))] = '\0';
+    referer[EscapeJson_(rec.referer, referer, sizeof(referer))] = '\0';
+    ua[EscapeJson_(rec.userAgent, ua, sizeof(ua))] = '\0';
+
+    int n = snprintf(buf, len,
+                     "{\"time\":\"%s\",\"ip\":\"%s\",\"user\":\"%s\",\"method\":\"%s\",\"path\":\"%s\","
+                     "\"version\":\"%s\",\"status\":%d,\"bytes\":%zu,\"latency_us\":%lld,\"upstream_us\":%lld,"
+                     "\"referer\":\"%s\",\"user_agent\":\"%s\"}\n",
+                     TimeStr_(true), rec.clientIP.c_str(), user, rec.method.c_str(), path,
+                     version, rec.status, rec.bytesSent, rec.latencyUs, rec.upstreamUs,
+                     referer, ua);
+    if (n < 0 || static_cast<size_t>(n) >= len)
+    {
+        // 超长记录截断时仍需保证一行一条
+        n = len - 1;
+        buf[n - 1] = '\n';
+    }
+    return n;
+}
@@ -0,0 +1,83 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+
+// 访问日志记录：每个完成的请求一条
+struct AccessRecord
+{
+    std::string clientIP;
+    std::string user;      // 已鉴权用户名，匿名为空
+    std::string method;
+    std::string path;
+    std::string version;
+    std::string referer;
+    std::string userAgent;
+    int status;
+    size_t bytesSent;
+    long long latencyUs;   // 请求耗时(微秒)：开始解析请求 -> 响应发送完毕
+    long long upstreamUs;  // 其中访问Redis/MySQL的耗时(微秒)
+};
+
+// 独立于Log的访问日志：工作线程格式化后追加到前台缓冲区，后台线程交换缓冲区并批量写入文件
+class AccessLog
+{
+public:
+    enum FORMAT
+    {
+        COMMON = 0, // Common Log Format + rt/urt
+        COMBINED,   // Combined Log Format + rt/urt
+        JSON,       // JSON lines
+    };
+
+    static AccessLog *Instance();
+
+    bool Init(const char *path = "./log", const char *fileName = "access.log",
+              int format = COMBINED, size_t flushBytes = 64 * 1024, int flushIntervalMS = 1000);
+    void Close();
+
+    void Append(const AccessRecord &rec);
+    bool IsOpen() const { return isOpen_; }
+    size_t DroppedCount() const { return dropped_; }
+
+private:
+    AccessLog();
+    ~AccessLog();
+
+    size_t FormatCommon_(const AccessRecord &rec, char *buf, size_t len);
+    size_t FormatJson_(const AccessRecord &rec, char *buf, size_t len);
+    static size_t EscapeJson_(const std::string &str, char *buf, size_t len);
+    static size_t EscapeClf_(const std::string &str, char *buf, size_t len);
+    static const char *TimeStr_(bool iso8601);
+    void WriteLoop_();
+
+    static const int LOG_NAME_LEN = 256;
+    static const size_t LINE_MAX_LEN = 4096;
+    static const size_t MAX_PENDING_BYTES = 16 * 1024 * 1024; // 写入跟不上时丢弃，避免无限占用内存
+
+    int fd_;
+    int format_;
+    size_t flushBytes_;
+    int flushIntervalMS_;
+    std::atomic<bool> isOpen_;
+    std::atomic<size_t> dropped_;
+
+    std::string frontBuff_; // 工作线程写入
+    std::string backBuff_;  // 后台线程写出
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool isClose_;
+    std::unique_ptr<std::thread> writeThread_;
+};
+
+#endif // ACCESS_LOG_H
@@ -7,22 +7,161 @@
 
 #include <mutex>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
 #include <stdarg.h>   // vastart va_end
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>   // unlink
+#include <fcntl.h>
+#include <dirent.h>
+#include <zlib.h>     // gzdopen gzwrite
 #include <sys/time.h>
 #include <sys/stat.h> // mkdir
 
 using namespace std;
 
+// 将日志文件压缩为.gz并删除原文件，在后台线程中执行；已有同名压缩文件时保留原文件，不覆盖历史
+static void GzipFile(const string &src)
+{
+    FILE *in = fopen(src.c_str(), "rb");
+    if (in == nullptr)
+    {
+        return;
+    }
+    string dst = src + ".gz";
+    int fd = open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    gzFile out = fd == -1 ? nullptr : gzdopen(fd, "wb6");
+    if (out == nullptr)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+            unlink(dst.c_str());
+        }
+        fclose(in);
+        return;
+    }
+
+    char buf[64 * 1024];
+    size_t n = 0;
+    bool ok = true;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        if (gzwrite(out, buf, static_cast<unsigned>(n)) != static_cast<int>(n))
+        {
+            ok = false;
+            break;
+        }
+    }
+    fclose(in);
+    if (gzclose(out) != Z_OK || !ok)
+    {
+        unlink(dst.c_str());
+        return;
+    }
+    unlink(src.c_str());
+}
+
+// 解析日志文件名 YYYY_MM_DD[-N]<suffix>[.gz]，得到日期与序号
+static bool ParseLogName(const char *name, const string &suffix, string &day, int &idx)
+{
+    static const size_t DAY_LEN = 10;
+    string str(name);
+    if (str.size() > 3 && str.compare(str.size() - 3, 3, ".gz") == 0)
+    {
+        str.resize(str.size() - 3);
+    }
+    if (str.size() < DAY_LEN + suffix.size() || str.compare(str.size() - suffix.size(), suffix.size(), suffix) != 0)
+    {
+        return false;
+    }
+    str.resize(str.size() - suffix.size());
+    for (size_t i = 0; i < DAY_LEN; i++)
+    {
+        if ((i == 4 || i == 7) ? str[i] != '_' : !isdigit(static_cast<unsigned char>(str[i])))
+        {
+            return false;
+        }
+    }
+    day = str.substr(0, DAY_LEN);
+    idx = 0;
+    if (str.size() == DAY_LEN)
+    {
+        return true;
+    }
+    if (str[DAY_LEN] != '-' || str.size() == DAY_LEN + 1 || str.size() > DAY_LEN + 10)
+    {
+        return false;
+    }
+    for (size_t i = DAY_LEN + 1; i < str.size(); i++)
+    {
+        if (!isdigit(static_cast<unsigned char>(str[i])))
+        {
+            return false;
+        }
+        idx = idx * 10 + (str[i] - '0');
+    }
+    return true;
+}
+
+// 跨天统计历史文件，按(日期,序号)只保留最新的keep个，同一序号的.log与.gz算作一个
+static void PruneFiles(const string &dir, const string &suffix, const string &curDay, int curIdx, int keep)
+{
+    DIR *dp = opendir(dir.c_str());
+    if (dp == nullptr)
+    {
+        return;
+    }
+    vector<pair<string, int>> files;
+    struct dirent *ent;
+    string day;
+    int idx;
+    while ((ent = readdir(dp)) != nullptr)
+    {
+        if (ParseLogName(ent->d_name, suffix, day, idx) && !(day == curDay && idx == curIdx))
+        {
+            files.emplace_back(day, idx);
+        }
+    }
+    closedir(dp);
+    sort(files.begin(), files.end());
+    files.erase(unique(files.begin(), files.end()), files.end());
+    for (size_t i = 0; i + keep < files.size(); i++)
+    {
+        char name[512];
+        if (files[i].second == 0)
+        {
+            snprintf(name, sizeof(name), "%s/%s%s", dir.c_str(), files[i].first.c_str(), suffix.c_str());
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%s/%s-%d%s", dir.c_str(), files[i].first.c_str(), files[i].second, suffix.c_str());
+        }
+        unlink(name);
+        unlink((string(name) + ".gz").c_str());
+    }
+}
+
 Log::Log()
 {
-    lineCount_ = 0;
+    isOpen_ = false;
+    level_ = 1;
     isAsync_ = false;
     writeThread_ = nullptr;
     deque_ = nullptr;
-    toDay_ = 0;
+    houseKeepThread_ = nullptr;
+    houseKeepDeque_ = nullptr;
     fp_ = nullptr;
+    maxFileBytes_ = 0;
+    maxFiles_ = 0;
+    compress_ = false;
+    fileBytes_ = 0;
+    fileIdx_ = 0;
+    nextDay_ = 0;
+    day_[0] = '\0';
 }
 
 Log::~Log()
@@ -36,10 +175,19 @@ Log::~Log()
         deque_->Close();
         writeThread_->join();
     }
+    if (houseKeepThread_ && houseKeepThread_->joinable())
+    {
+        while (!houseKeepDeque_->empty())
+        {
+            houseKeepDeque_->flush();
+        };
+        houseKeepDeque_->Close();
+        houseKeepThread_->join();
+    }
     if (fp_)
     {
-        lock_guard<mutex> locker(mtx_);
-        flush();
+        lock_guard<mutex> locker(fileMtx_);
+        fflush(fp_);
         fclose(fp_);
     }
 }
@@ -57,7 +205,7 @@ void Log::SetLevel(int level)
 }
 
 void Log::Init(int level = 1, const char *path, const char *suffix,
-               int maxQueueSize)
+               int maxQueueSize, size_t maxFileBytes, int maxFiles, bool compress)
 {
     isOpen_ = true;
     level_ = level;
@@ -78,77 +226,172 @@ void Log::Init(int level = 1, const char *path, const char *suffix,
         isAsync_ = false;
     }
 
-    lineCount_ = 0;
+    // 历史文件的压缩与删除放到单独线程，切分时只做fclose/fopen
+    if (!houseKeepDeque_)
+    {
+        houseKeepDeque_.reset(new BlockDeque<std::function<void()>>());
+        houseKeepThread_.reset(new thread(HouseKeepThread));
+    }
 
-    time_t timer = time(nullptr);
-    struct tm *sysTime = localtime(&timer);
-    struct tm t = *sysTime;
     path_ = path;
     suffix_ = suffix;
-    char fileName[LOG_NAME_LEN] = {0};
-    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s",
-             path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, suffix_);
-    toDay_ = t.tm_mday;
 
     {
         lock_guard<mutex> locker(mtx_);
         buff_.RetrieveAll();
+        lock_guard<mutex> fileLocker(fileMtx_);
+        maxFileBytes_ = maxFileBytes;
+        maxFiles_ = maxFiles;
+        compress_ = compress;
         if (fp_)
         {
-            flush();
+            fflush(fp_);
             fclose(fp_);
+            fp_ = nullptr;
         }
-
-        fp_ = fopen(fileName, "a");
-        if (fp_ == nullptr)
-        {
-            mkdir(path_, 0777);
-            fp_ = fopen(fileName, "a");
-        }
+        OpenFile_(time(nullptr));
         assert(fp_ != nullptr);
     }
 }
 
-void Log::write(int level, const char *format, ...)
+void Log::FileName_(char *fileName, int idx) const
 {
-    struct timeval now = {0, 0};
-    gettimeofday(&now, nullptr);
-    time_t tSec = now.tv_sec;
-    struct tm *sysTime = localtime(&tSec);
-    struct tm t = *sysTime;
-    va_list vaList;
-
-    /* 日志日期 日志行数 */
-    if (toDay_ != t.tm_mday || (lineCount_ && (lineCount_ % MAX_LINES == 0)))
+    if (idx == 0)
     {
-        unique_lock<mutex> locker(mtx_);
-        locker.unlock();
-
-        char newFile[LOG_NAME_LEN];
-        char tail[36] = {0};
-        snprintf(tail, 36, "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%s%s", path_, day_, suffix_);
+    }
+    else
+    {
+        snprintf(fileName, LOG_NAME_LEN - 1, "%s/%s-%d%s", path_, day_, idx, suffix_);
+    }
+}
 
-        if (toDay_ != t.tm_mday)
-        {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s%s", path_, tail, suffix_);
-            toDay_ = t.tm_mday;
-            lineCount_ = 0;
-        }
-        else
+// 当天已有的最大序号，重启后从该序号继续，已压缩的序号不再写入
+int Log::LastIndex_() const
+{
+    DIR *dp = opendir(path_);
+    if (dp == nullptr)
+    {
+        return 0;
+    }
+    int last = 0;
+    bool archived = false;
+    struct dirent *ent;
+    string day;
+    int idx;
+    while ((ent = readdir(dp)) != nullptr)
+    {
+        if (!ParseLogName(ent->d_name, suffix_, day, idx) || day != day_ || idx < last)
         {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s-%d%s", path_, tail, (lineCount_ / MAX_LINES), suffix_);
+            continue;
         }
+        bool gz = strlen(ent->d_name) > 3 && strcmp(ent->d_name + strlen(ent->d_name) - 3, ".gz") == 0;
+        archived = (idx == last ? archived : false) || gz;
+        last = idx;
+    }
+    closedir(dp);
+    return archived ? last + 1 : last;
+}
+
+// 打开当天的日志文件，需持有fileMtx_
+void Log::OpenFile_(time_t now)
+{
+    struct tm t;
+    localtime_r(&now, &t);
+    snprintf(day_, sizeof(day_), "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
 
-        locker.lock();
-        flush();
+    struct tm next = t;
+    next.tm_mday += 1;
+    next.tm_hour = next.tm_min = next.tm_sec = 0;
+    next.tm_isdst = -1;
+    nextDay_ = mktime(&next);
+
+    fileIdx_ = LastIndex_();
+    char fileName[LOG_NAME_LEN] = {0};
+    FileName_(fileName, fileIdx_);
+    fp_ = fopen(fileName, "a");
+    if (fp_ == nullptr)
+    {
+        mkdir(path_, 0777);
+        fp_ = fopen(fileName, "a");
+    }
+    fileBytes_ = fp_ ? ftell(fp_) : 0; // 重启后继续追加时计入已有大小
+}
+
+// 按天或按大小切分，需持有fileMtx_；异步模式下只在写线程中调用
+void Log::RotateFile_(time_t now, bool newDay)
+{
+    char oldFile[LOG_NAME_LEN] = {0};
+    FileName_(oldFile, fileIdx_);
+    if (fp_)
+    {
+        fflush(fp_);
         fclose(fp_);
+        fp_ = nullptr;
+    }
+
+    if (newDay)
+    {
+        OpenFile_(now);
+    }
+    else
+    {
+        fileIdx_++;
+        char newFile[LOG_NAME_LEN] = {0};
+        FileName_(newFile, fileIdx_);
         fp_ = fopen(newFile, "a");
-        assert(fp_ != nullptr);
+        fileBytes_ = fp_ ? ftell(fp_) : 0;
+    }
+    assert(fp_ != nullptr);
+
+    if (compress_)
+    {
+        string name(oldFile);
+        houseKeepDeque_->push_back([name]
+                                   { GzipFile(name); });
     }
 
+    // 在压缩之后执行，按目录中实际存在的文件保留最近maxFiles_个，包括之前几天及重启前的文件
+    if (maxFiles_ > 0)
+    {
+        string dir(path_), suffix(suffix_), day(day_);
+        int idx = fileIdx_, keep = maxFiles_;
+        houseKeepDeque_->push_back([dir, suffix, day, idx, keep]
+                                   { PruneFiles(dir, suffix, day, idx, keep); });
+    }
+}
+
+// 写入当前文件并在需要时切分，需持有fileMtx_
+void Log::WriteFile_(const char *str, size_t len)
+{
+    time_t now = time(nullptr);
+    if (now >= nextDay_)
+    {
+        RotateFile_(now, true);
+    }
+    else if (maxFileBytes_ > 0 && fileBytes_ > 0 && fileBytes_ + len > maxFileBytes_)
+    {
+        RotateFile_(now, false);
+    }
+    if (fp_)
+    {
+        fwrite(str, 1, len, fp_);
+        fileBytes_ += len;
+    }
+}
+
+void Log::write(int level, const char *format, ...)
+{
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    time_t tSec = now.tv_sec;
+    struct tm t;
+    localtime_r(&tSec, &t);
+    va_list vaList;
+
     {
         unique_lock<mutex> locker(mtx_);
-        lineCount_++;
+        buff_.EnsureWriteable(128);
         int n = snprintf(buff_.BeginWrite(), 128, "%d-%02d-%02d %02d:%02d:%02d.%06ld ",
                          t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
                          t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec);
@@ -159,9 +402,20 @@ void Log::write(int level, const char *format, ...)
         va_start(vaList, format);
         int m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList);
         va_end(vaList);
+        if (m >= 0 && static_cast<size_t>(m) >= buff_.WritableBytes())
+        {
+            // 空间不足时扩容后重新格式化，避免截断
+            buff_.EnsureWriteable(m + 1);
+            va_start(vaList, format);
+            m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList);
+            va_end(vaList);
+        }
 
-        buff_.HasWritten(m);
-        buff_.Append("\n\0", 2);
+        if (m > 0)
+        {
+            buff_.HasWritten(m);
+        }
+        buff_.Append("\n", 1);
 
         if (isAsync_ && deque_ && !deque_->full())
         {
@@ -169,7 +423,8 @@ void Log::write(int level, const char *format, ...)
         }
         else
         {
-            fputs(buff_.Peek(), fp_);
+            lock_guard<mutex> fileLocker(fileMtx_);
+            WriteFile_(buff_.Peek(), buff_.ReadableBytes());
         }
         buff_.RetrieveAll();
     }
@@ -201,9 +456,15 @@ void Log::flush()
 {
     if (isAsync_)
     {
+        // 异步模式下文件由写线程负责刷新
         deque_->flush();
+        return;
+    }
+    lock_guard<mutex> locker(fileMtx_);
+    if (fp_)
+    {
+        fflush(fp_);
     }
-    fflush(fp_);
 }
 
 void Log::AsyncWrite_()
@@ -211,8 +472,21 @@ void Log::AsyncWrite_()
     string str = "";
     while (deque_->pop(str))
     {
-        lock_guard<mutex> locker(mtx_);
-        fputs(str.c_str(), fp_);
+        lock_guard<mutex> locker(fileMtx_);
+        WriteFile_(str.data(), str.size());
+        if (deque_->empty() && fp_)
+        {
+            fflush(fp_);
+        }
+    }
+}
+
+void Log::HouseKeep_()
+{
+    function<void()> task;
+    while (houseKeepDeque_->pop(task))
+    {
+        task();
     }
 }
 
@@ -225,4 +499,9 @@ Log *Log::Instance()
 void Log::FlushLogThread()
 {
     Log::Instance()->AsyncWrite_();
-}
\ No newline at end of file
+}
+
+void Log::HouseKeepThread()
+{
+    Log::Instance()->HouseKeep_();
+}
@@ -7,6 +7,7 @@
 #define LOG_H
 
 #include <thread>
+#include <functional>
 
 #include "blockqueue.h"
 #include "buffer/buffer.h"
@@ -16,10 +17,14 @@ class Log
 public:
     void Init(int level, const char *path = "./log",
               const char *suffix = ".log",
-              int maxQueueCapacity = 1024);
+              int maxQueueCapacity = 1024,
+              size_t maxFileBytes = 64 * 1024 * 1024,
+              int maxFiles = 10,
+              bool compress = false);
 
     static Log *Instance();
     static void FlushLogThread();
+    static void HouseKeepThread();
 
     void write(int level, const char *format, ...);
     void flush();
@@ -33,19 +38,28 @@ private:
     void AppendLogLevelTitle_(int level);
     virtual ~Log();
     void AsyncWrite_();
+    void HouseKeep_();
+    void WriteFile_(const char *str, size_t len);
+    void OpenFile_(time_t now);
+    void RotateFile_(time_t now, bool newDay);
+    void FileName_(char *fileName, int idx) const;
+    int LastIndex_() const;
 
 private:
     static const int LOG_PATH_LEN = 256;
     static const int LOG_NAME_LEN = 256;
-    static const int MAX_LINES = 50000;
 
     const char *path_;
     const char *suffix_;
 
-    int MAX_LINES_;
-
-    int lineCount_;
-    int toDay_;
+    // 以下文件状态仅由写线程(异步)或持有fileMtx_的调用线程(同步)访问
+    size_t maxFileBytes_; // 单个日志文件大小上限，0为不按大小切分
+    int maxFiles_;        // 保留的历史日志文件数(跨天统计)
+    bool compress_;       // 切分后是否后台压缩
+    size_t fileBytes_;    // 当前文件已写入字节数
+    int fileIdx_;         // 当前文件序号，0为当天首个文件，重启后接着已有的最大序号
+    time_t nextDay_;      // 下一次按天切分的时间点
+    char day_[32];        // 当前文件日期 YYYY_MM_DD
 
     bool isOpen_;
 
@@ -56,7 +70,10 @@ private:
     FILE *fp_;
     std::unique_ptr<BlockDeque<std::string>> deque_;
     std::unique_ptr<std::thread> writeThread_;
-    std::mutex mtx_;
+    std::unique_ptr<BlockDeque<std::function<void()>>> houseKeepDeque_; // 压缩/删除历史文件
+    std::unique_ptr<std::thread> houseKeepThread_;
+    std::mutex mtx_;     // 格式化缓冲区与日志等级
+    std::mutex fileMtx_; // 日志文件
 };
 
 #define LOG_BASE(level, format, ...)                   \
@@ -91,4 +108,4 @@ private:
         LOG_BASE(3, format, ##__VA_ARGS__) \
     } while (0);
 
-#endif // LOG_H
\ No newline at end of file
+#endif // LOG_H
@@ -39,6 +39,11 @@ int main(int argc, char *argv[])
         config.sr_port, config.sr_trigMode, config.sr_timeoutMS, config.sr_optLinger, config.sr_optIPv6,            /* 端口 ET模式 超时时间 优雅退出 双栈支持 */
         mysql_addr, mysql_port, mysql_user, mysql_pwd, mysql_dbName,                                                /* Mysql配置 */
         redis_addr, redis_port, redis_user, redis_pwd, redis_dbName,                                                /* Redis配置 */
-        config.sr_connPoolNum, config.sr_threadNum, config.sr_enableLog, config.sr_logLevel, config.sr_logQueSize); /* 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 */
+        config.sr_connPoolNum, config.sr_threadNum, config.sr_enableLog, config.sr_logLevel, config.sr_logQueSize,   /* 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 */
+        config.sr_logFileMB, config.sr_logFileNum, config.sr_logCompress,                                           /* 日志文件大小 历史日志数量 历史日志压缩 */
+        config.sr_enableAccessLog, config.sr_accessLogFormat,                                                       /* 访问日志开关 访问日志格式 */
+        config.sr_sessionCacheSec, config.sr_sessionMode, config.sr_sessionKey,                                     /* session缓存时间 session模式 token密钥 */
+        config.sr_connPoolTimeoutMS, config.sr_redisAsyncNum, config.sr_credCacheSec, config.sr_connPoolMinReady,   /* 获取连接等待上限 异步Redis连接数 凭据缓存时间 启动就绪连接数 */
+        config.sr_storeBackend, config.sr_dedupStore, config.sr_fileIoThreadNum);                                   /* 用户与session存储后端 去重存储 文件I/O线程数 */
     server.Start();
 }
@@ -8,58 +8,298 @@
 
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
 #include <semaphore.h>
 #include <mysql/mysql.h>
 #include <hiredis/hiredis.h>
 
 #include "log/log.h"
 
+// sem_clockwait自glibc 2.30起提供
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+#define CONNPOOL_CLOCKWAIT
+#endif
+
 template <typename T>
 class ConnPool
 {
 public:
-    ConnPool() : MAX_CONN_(0), useCount_(0), freeCount_(0)
+    // 获取连接等待时间分布的桶数，超时单独计数
+    static const int WAIT_BUCKETS = 8;
+
+    ConnPool() : MAX_CONN_(0), useCount_(0), freeCount_(0), deadCount_(0), toStart_(0), pending_(0), minReady_(0),
+                 hasUser_(false), hasPwd_(false), hasDBName_(false), port_(0),
+                 acquireTimeoutMS_(500), healthIntervalMS_(30000), isClose_(true), ready_(false), timeouts_(0), unavailable_(0)
     {
         sem_init(&semId_, 0, 0);
+        for (int i = 0; i < WAIT_BUCKETS; i++)
+        {
+            waitHist_[i] = 0;
+        }
     }
 
     virtual ~ConnPool() { sem_destroy(&semId_); }
-    virtual bool InitPool(const char *host, int port, const char *user, const char *pwd, const char *dbName, int connSize) = 0;
-    virtual void ClosePool() = 0;
 
-    T *GetConn();
+    // 并行建立连接，minReady个连接就绪后即返回，其余在后台补齐；minReady<=0时等待全部连接
+    bool InitPool(const char *host, int port, const char *user, const char *pwd, const char *dbName, int connSize,
+                  int acquireTimeoutMS = 500, int healthIntervalMS = 30000, int minReady = 0);
+    void ClosePool();
+
+    T *GetConn(int timeoutMS = -1);
     void FreeConn(T *conn);
     int GetFreeConnCount();
+    std::string Stats();
 
 protected:
+    virtual T *Connect_() = 0;         // 新建一个已完成鉴权的连接，失败返回nullptr
+    virtual bool Ping_(T *conn) = 0;   // 检查连接是否可用
+    virtual bool IsBroken_(T *conn) = 0; // 使用后连接是否已损坏
+    virtual void Close_(T *conn) = 0;
+
+    void WarmUp_();
+    void HealthCheck_();
+    void RecordWait_(long long waitUs, bool acquired);
+
     int MAX_CONN_;
     int useCount_;
     int freeCount_;
+    int deadCount_; // 已断开、等待后台重连的连接数
+    int toStart_;   // 预热中尚未开始建立的连接数
+    int pending_;   // 预热中尚未完成(含正在建立)的连接数
+    int minReady_;  // 就绪连接数达到该值后才对外提供连接
+
+    // 连接参数，重连时使用
+    std::string host_, user_, pwd_, dbName_;
+    bool hasUser_, hasPwd_, hasDBName_;
+    int port_;
+
+    int acquireTimeoutMS_;
+    int healthIntervalMS_;
+    bool isClose_;
+    bool ready_; // 预热已达到minReady_
 
     std::queue<T *> connQue_;
     std::mutex mtx_;
-    sem_t semId_;
+    sem_t semId_; // 空闲连接数
+
+    std::condition_variable healthCond_;
+    std::thread healthThread_;
+    std::condition_variable warmCond_;
+    std::vector<std::thread> warmThreads_;
+    static const int WARM_THREADS = 8; // 预热并发数上限
+
+    std::atomic<unsigned long long> waitHist_[WAIT_BUCKETS];
+    std::atomic<unsigned long long> timeouts_;
+    std::atomic<unsigned long long> unavailable_;
+    static const long long WAIT_BOUNDS_US[WAIT_BUCKETS - 1];
 };
 
 template <typename T>
-T *ConnPool<T>::GetConn()
+const long long ConnPool<T>::WAIT_BOUNDS_US[ConnPool<T>::WAIT_BUCKETS - 1] = {100, 1000, 5000, 10000, 50000, 100000, 500000};
+
+template <typename T>
+bool ConnPool<T>::InitPool(const char *host, int port, const char *user, const char *pwd, const char *dbName, int connSize,
+                           int acquireTimeoutMS, int healthIntervalMS, int minReady)
+{
+    assert(connSize > 0);
+    host_ = host ? host : "";
+    hasUser_ = (user != nullptr);
+    user_ = user ? user : "";
+    hasPwd_ = (pwd != nullptr);
+    pwd_ = pwd ? pwd : "";
+    hasDBName_ = (dbName != nullptr);
+    dbName_ = dbName ? dbName : "";
+    port_ = port;
+    acquireTimeoutMS_ = acquireTimeoutMS;
+    healthIntervalMS_ = healthIntervalMS;
+    MAX_CONN_ = connSize;
+    if (minReady <= 0 || minReady > connSize)
+    {
+        minReady = connSize;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        isClose_ = false;
+        ready_ = false;
+        minReady_ = minReady;
+        toStart_ = pending_ = connSize;
+    }
+    int workers = connSize;
+    if (workers > WARM_THREADS)
+    {
+        workers = WARM_THREADS;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        warmThreads_.emplace_back(&ConnPool<T>::WarmUp_, this);
+    }
+
+    bool ready = false;
+    {
+        std::unique_lock<std::mutex> locker(mtx_);
+        warmCond_.wait(locker, [this, minReady]
+                       { return freeCount_ >= minReady || pending_ == 0; });
+        ready = (freeCount_ >= minReady);
+    }
+
+    // 预热失败的连接由健康检查线程重连
+    if (healthIntervalMS_ > 0)
+    {
+        healthThread_ = std::thread(&ConnPool<T>::HealthCheck_, this);
+    }
+    return ready;
+}
+
+// 预热线程：逐个领取待建立的连接，建立后立即可用
+template <typename T>
+void ConnPool<T>::WarmUp_()
 {
-    T *coon = nullptr;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            if (toStart_ == 0 || isClose_)
+            {
+                pending_ -= toStart_; // 关闭时放弃未开始的连接
+                toStart_ = 0;
+                break;
+            }
+            toStart_--;
+        }
+        T *conn = Connect_();
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            pending_--;
+            if (conn)
+            {
+                connQue_.push(conn);
+                freeCount_++;
+                sem_post(&semId_);
+                if (freeCount_ >= minReady_)
+                {
+                    ready_ = true;
+                }
+            }
+            else
+            {
+                deadCount_++;
+            }
+        }
+        warmCond_.notify_all();
+        if (!conn)
+        {
+            healthCond_.notify_one();
+        }
+    }
+    warmCond_.notify_all();
+}
+
+template <typename T>
+void ConnPool<T>::ClosePool()
+{
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        isClose_ = true;
+        ready_ = false;
+    }
+    healthCond_.notify_all();
+    if (healthThread_.joinable())
+    {
+        healthThread_.join();
+    }
+    for (auto &t : warmThreads_)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+    warmThreads_.clear();
+
     std::lock_guard<std::mutex> locker(mtx_);
-    if (!connQue_.empty())
+    while (!connQue_.empty())
     {
-        sem_wait(&semId_);
-        coon = connQue_.front();
+        auto item = connQue_.front();
         connQue_.pop();
-        freeCount_--;
-        useCount_++;
+        Close_(item);
     }
-    else
+    freeCount_ = 0;
+    useCount_ = 0;
+    deadCount_ = 0;
+}
+
+// 等待空闲连接，超过timeoutMS仍未获取到则返回nullptr，由调用方返回503
+template <typename T>
+T *ConnPool<T>::GetConn(int timeoutMS)
+{
+    if (timeoutMS < 0)
+    {
+        timeoutMS = acquireTimeoutMS_;
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (!ready_ || freeCount_ + useCount_ + pending_ == 0)
+        {
+            // 未初始化、预热尚未就绪或连接全部断开，无需等待
+            unavailable_++;
+            LOG_WARN("ConnPool unavailable!");
+            return nullptr;
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int ret = sem_trywait(&semId_);
+    if (ret != 0 && timeoutMS > 0)
+    {
+        // 截止时间基于单调时钟，不受系统时间调整影响；
+        // glibc 2.30之前没有sem_clockwait，只能基于CLOCK_REALTIME，时间跳变会拉长或缩短等待
+#ifdef CONNPOOL_CLOCKWAIT
+        const clockid_t clock = CLOCK_MONOTONIC;
+#else
+        const clockid_t clock = CLOCK_REALTIME;
+#endif
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        ts.tv_sec += timeoutMS / 1000;
+        ts.tv_nsec += (timeoutMS % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+#ifdef CONNPOOL_CLOCKWAIT
+        while ((ret = sem_clockwait(&semId_, clock, &ts)) != 0 && errno == EINTR)
+#else
+        while ((ret = sem_timedwait(&semId_, &ts)) != 0 && errno == EINTR)
+#endif
+        {
+        }
+    }
+    RecordWait_(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), ret == 0);
+    if (ret != 0)
     {
         LOG_WARN("ConnPool busy!");
         return nullptr;
     }
-    return coon;
+
+    std::lock_guard<std::mutex> locker(mtx_);
+    assert(!connQue_.empty());
+    T *conn = connQue_.front();
+    connQue_.pop();
+    freeCount_--;
+    useCount_++;
+    return conn;
 }
 
 template <typename T>
@@ -69,19 +309,142 @@ void ConnPool<T>::FreeConn(T *conn)
     {
         return;
     }
-    std::lock_guard<std::mutex> locker(mtx_);
-    connQue_.push(conn);
-    freeCount_++;
-    useCount_--;
+    if (IsBroken_(conn))
+    {
+        // 损坏的连接交给后台线程重连，不阻塞当前请求
+        Close_(conn);
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            useCount_--;
+            deadCount_++;
+        }
+        LOG_WARN("ConnPool drop broken connection");
+        healthCond_.notify_one();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        connQue_.push(conn);
+        freeCount_++;
+        useCount_--;
+    }
     sem_post(&semId_);
 }
 
 template <typename T>
 int ConnPool<T>::GetFreeConnCount()
 {
+    std::lock_guard<std::mutex> locker(mtx_);
     return freeCount_;
 }
 
+// 后台检查空闲连接并重连已断开的连接
+template <typename T>
+void ConnPool<T>::HealthCheck_()
+{
+    const int retryMS = 1000; // 有断开连接时的重试间隔
+    std::unique_lock<std::mutex> locker(mtx_);
+    while (!isClose_)
+    {
+        healthCond_.wait_for(locker, std::chrono::milliseconds(deadCount_ > 0 ? retryMS : healthIntervalMS_));
+        if (isClose_)
+        {
+            break;
+        }
+
+        // 逐个取出空闲连接检查，其余连接仍可被请求使用
+        int idle = freeCount_;
+        for (int i = 0; i < idle && !isClose_; i++)
+        {
+            if (sem_trywait(&semId_) != 0)
+            {
+                break;
+            }
+            T *conn = connQue_.front();
+            connQue_.pop();
+            freeCount_--;
+            locker.unlock();
+
+            bool alive = Ping_(conn);
+            if (!alive)
+            {
+                LOG_WARN("ConnPool ping failed, reconnect");
+                Close_(conn);
+                conn = Connect_();
+            }
+
+            locker.lock();
+            if (conn)
+            {
+                connQue_.push(conn);
+                freeCount_++;
+                sem_post(&semId_);
+            }
+            else
+            {
+                deadCount_++;
+            }
+        }
+
+        // 重建断开的连接
+        while (deadCount_ > 0 && !isClose_)
+        {
+            locker.unlock();
+            T *conn = Connect_();
+            locker.lock();
+            if (!conn)
+            {
+                LOG_ERROR("ConnPool reconnect error, %d connections down", deadCount_);
+                break;
+            }
+            deadCount_--;
+            connQue_.push(conn);
+            freeCount_++;
+            sem_post(&semId_);
+            if (freeCount_ >= minReady_)
+            {
+                ready_ = true; // 预热失败的连接补齐后同样可以就绪
+            }
+            LOG_INFO("ConnPool reconnected");
+        }
+    }
+}
+
+template <typename T>
+void ConnPool<T>::RecordWait_(long long waitUs, bool acquired)
+{
+    if (!acquired)
+    {
+        timeouts_++;
+        return;
+    }
+    int i = 0;
+    while (i < WAIT_BUCKETS - 1 && waitUs >= WAIT_BOUNDS_US[i])
+    {
+        i++;
+    }
+    waitHist_[i]++;
+}
+
+// 连接数与获取连接的等待时间分布
+template <typename T>
+std::string ConnPool<T>::Stats()
+{
+    std::string res;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        res = "free:" + std::to_string(freeCount_) + " use:" + std::to_string(useCount_) +
+              " dead:" + std::to_string(deadCount_) + " warming:" + std::to_string(pending_) + " wait";
+    }
+    for (int i = 0; i < WAIT_BUCKETS - 1; i++)
+    {
+        res += " <" + std::to_string(WAIT_BOUNDS_US[i]) + "us:" + std::to_string(waitHist_[i]);
+    }
+    res += " >=" + std::to_string(WAIT_BOUNDS_US[WAIT_BUCKETS - 2]) + "us:" + std::to_string(waitHist_[WAIT_BUCKETS - 1]);
+    res += " timeout:" + std::to_string(timeouts_) + " unavailable:" + std::to_string(unavailable_);
+    return res;
+}
+
 class MySQLConnPool : public ConnPool<MYSQL>
 {
 public:
@@ -94,47 +457,92 @@ public:
     ~MySQLConnPool() override
     {
         ClosePool();
-        sem_destroy(&semId_);
+        mysql_library_end();
     }
 
-    bool InitPool(const char *host, int port, const char *user, const char *pwd, const char *dbName, int connSize) override
+    // 取conn上缓存的预处理语句，首次使用时prepare；连接关闭或重连时一并释放
+    // 调用方须持有conn(经由GetConn获取)，同一语句不会被并发使用
+    MYSQL_STMT *GetStmt(MYSQL *conn, const std::string &query)
     {
-        MAX_CONN_ = connSize;
-        for (int i = 0; i < MAX_CONN_; i++)
         {
-            MYSQL *sql = nullptr;
-            sql = mysql_init(sql);
-            if (!sql)
-            {
-                LOG_ERROR("MySql Init error!");
-                return false;
-            }
-            sql = mysql_real_connect(sql, host, user, pwd, dbName, port, nullptr, 0);
-            if (!sql)
+            std::lock_guard<std::mutex> locker(stmtMtx_);
+            auto &stmts = stmts_[conn];
+            auto it = stmts.find(query);
+            if (it != stmts.end())
             {
-                LOG_ERROR("MySql Connect error!");
-                return false;
+                return it->second;
             }
-            connQue_.push(sql);
-            freeCount_++;
         }
-        sem_init(&semId_, 0, MAX_CONN_);
-        return true;
+        MYSQL_STMT *stmt = mysql_stmt_init(conn);
+        if (stmt == nullptr)
+        {
+            LOG_ERROR("MySql stmt init error: %s", mysql_error(conn));
+            return nullptr;
+        }
+        if (mysql_stmt_prepare(stmt, query.c_str(), query.size()))
+        {
+            LOG_ERROR("MySql prepare error: %s", mysql_stmt_error(stmt));
+            mysql_stmt_close(stmt);
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> locker(stmtMtx_);
+        stmts_[conn][query] = stmt;
+        return stmt;
     }
 
-    void ClosePool() override
+protected:
+    MYSQL *Connect_() override
     {
-        std::lock_guard<std::mutex> locker(mtx_);
-        while (!connQue_.empty())
+        MYSQL *sql = nullptr;
+        sql = mysql_init(sql);
+        if (!sql)
         {
-            auto item = connQue_.front();
-            connQue_.pop();
-            mysql_close(item);
+            LOG_ERROR("MySql Init error!");
+            return nullptr;
         }
-        mysql_library_end();
-        freeCount_ = 0;
-        useCount_ = 0;
+        unsigned int timeout = 3;
+        mysql_options(sql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+        if (!mysql_real_connect(sql, host_.c_str(), hasUser_ ? user_.c_str() : nullptr, hasPwd_ ? pwd_.c_str() : nullptr,
+                                hasDBName_ ? dbName_.c_str() : nullptr, port_, nullptr, 0))
+        {
+            LOG_ERROR("MySql Connect error: %s", mysql_error(sql));
+            mysql_close(sql);
+            return nullptr;
+        }
+        return sql;
+    }
+
+    bool Ping_(MYSQL *conn) override
+    {
+        return mysql_ping(conn) == 0;
     }
+
+    bool IsBroken_(MYSQL *conn) override
+    {
+        unsigned int err = mysql_errno(conn);
+        return err == 2006 || err == 2013; // CR_SERVER_GONE_ERROR, CR_SERVER_LOST
+    }
+
+    void Close_(MYSQL *conn) override
+    {
+        {
+            std::lock_guard<std::mutex> locker(stmtMtx_);
+            auto it = stmts_.find(conn);
+            if (it != stmts_.end())
+            {
+                for (auto &item : it->second)
+                {
+                    mysql_stmt_close(item.second);
+                }
+                stmts_.erase(it);
+            }
+        }
+        mysql_close(conn);
+    }
+
+private:
+    std::mutex stmtMtx_;
+    std::unordered_map<MYSQL *, std::unordered_map<std::string, MYSQL_STMT *>> stmts_;
 };
 
 class RedisConnPool : public ConnPool<redisContext>
@@ -149,81 +557,93 @@ public:
     ~RedisConnPool() override
     {
         ClosePool();
-        sem_destroy(&semId_);
     }
 
-    bool InitPool(const char *host, int port, const char *user, const char *pwd, const char *dbName, int connSize) override
+protected:
+    redisContext *Connect_() override
     {
-        MAX_CONN_ = connSize;
-        for (int i = 0; i < MAX_CONN_; i++)
+        struct timeval timeout = {3, 0};
+        redisContext *conn = redisConnectWithTimeout(host_.c_str(), port_, timeout);
+        if (conn == nullptr)
         {
-            redisContext *conn = redisConnect(host, port);
-            if (conn == nullptr)
+            LOG_ERROR("Redis Connect error: can't allocate redis context!");
+            return nullptr;
+        }
+        else if (conn->err)
+        {
+            LOG_ERROR("Redis Connect error: %s", conn->errstr);
+            redisFree(conn);
+            return nullptr;
+        }
+        redisSetTimeout(conn, timeout); // 命令超时，避免Redis无响应时长期占用工作线程
+
+        // Authenticate with the Redis server if needed
+        if (hasPwd_)
+        {
+            redisReply *authReply = nullptr;
+            if (hasUser_)
             {
-                LOG_ERROR("Redis Connect error: can't allocate redis context!");
-                return false;
+                authReply = (redisReply *)redisCommand(conn, "AUTH %s %s", user_.c_str(), pwd_.c_str());
             }
-            else if (conn->err)
+            else
             {
-                LOG_ERROR("Redis Connect error: %s", conn->errstr);
-                return false;
+                authReply = (redisReply *)redisCommand(conn, "AUTH %s", pwd_.c_str());
             }
-
-            // Authenticate with the Redis server if needed
-            if (pwd)
+            if (authReply == nullptr || authReply->type == REDIS_REPLY_ERROR)
             {
-                std::string authCommand;
-                if (user)
+                // Handle authentication error
+                LOG_ERROR("Redis Auth error: %s", authReply ? authReply->str : conn->errstr);
+                if (authReply)
                 {
-                    authCommand = "AUTH " + std::string(user) + " " + std::string(pwd);
+                    freeReplyObject(authReply);
                 }
-                else
-                {
-                    authCommand = "AUTH " + std::string(pwd);
-                }
-
-                redisReply *authReply = (redisReply *)redisCommand(conn, authCommand.c_str());
-                if (authReply == nullptr || authReply->type == REDIS_REPLY_ERROR)
-                {
-                    // Handle authentication error
-                    LOG_ERROR("Redis Auth error: %s", authReply->str);
-                    return false;
-                }
-                freeReplyObject(authReply);
+                redisFree(conn);
+                return nullptr;
             }
+            freeReplyObject(authReply);
+        }
 
-            // Select the specified database
-            if (dbName)
+        // Select the specified database
+        if (hasDBName_)
+        {
+            redisReply *selectReply = (redisReply *)redisCommand(conn, "SELECT %s", dbName_.c_str());
+            if (selectReply == nullptr || selectReply->type == REDIS_REPLY_ERROR)
             {
-                redisReply *selectReply = (redisReply *)redisCommand(conn, "SELECT %s", dbName);
-                if (selectReply == nullptr || selectReply->type == REDIS_REPLY_ERROR)
+                // Handle SELECT error
+                LOG_ERROR("Redis Select error: %s", selectReply ? selectReply->str : conn->errstr);
+                if (selectReply)
                 {
-                    // Handle SELECT error
-                    LOG_ERROR("Redis Select error: %s", selectReply->str);
-                    return false;
+                    freeReplyObject(selectReply);
                 }
-                freeReplyObject(selectReply);
+                redisFree(conn);
+                return nullptr;
             }
-
-            connQue_.push(conn);
-            freeCount_++;
+            freeReplyObject(selectReply);
         }
-        sem_init(&semId_, 0, MAX_CONN_);
-        return true;
+        return conn;
     }
 
-    void ClosePool() override
+    bool Ping_(redisContext *conn) override
     {
-        std::lock_guard<std::mutex> locker(mtx_);
-        while (!connQue_.empty())
+        redisReply *reply = (redisReply *)redisCommand(conn, "PING");
+        if (reply == nullptr)
         {
-            auto item = connQue_.front();
-            connQue_.pop();
-            redisFree(item);
+            return false;
         }
-        freeCount_ = 0;
-        useCount_ = 0;
+        bool alive = (reply->type == REDIS_REPLY_STATUS);
+        freeReplyObject(reply);
+        return alive;
+    }
+
+    bool IsBroken_(redisContext *conn) override
+    {
+        return conn->err != 0;
+    }
+
+    void Close_(redisContext *conn) override
+    {
+        redisFree(conn);
     }
 };
 
-#endif // CONNPOOL_H
\ No newline at end of file
+#endif // CONNPOOL_H
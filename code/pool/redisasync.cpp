@@ -0,0 +1,529 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include "redisasync.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>  // getaddrinfo
+#include <stdlib.h> // strtoll
+#include <string.h> // memcpy
+#include <unistd.h> // close
+#include <assert.h>
+#include <hiredis/hiredis.h> // REDIS_REPLY_*
+
+#include "log/log.h"
+
+using namespace std;
+
+const int RedisAsync::MAX_PENDING;
+const int RedisAsync::RETRY_MS;
+
+RedisAsync::RedisAsync()
+{
+    isOpen_ = false;
+    timeoutMS_ = 1000;
+    epoller_ = nullptr;
+    addr_ = {0};
+    addrLen_ = 0;
+    hasUser_ = hasPwd_ = hasDBName_ = false;
+    next_ = 0;
+    commands_ = 0;
+    rejected_ = 0;
+    failed_ = 0;
+    timeouts_ = 0;
+}
+
+RedisAsync::~RedisAsync()
+{
+    for (auto &conn : conns_)
+    {
+        if (conn->fd >= 0)
+        {
+            close(conn->fd);
+        }
+    }
+}
+
+RedisAsync *RedisAsync::Instance()
+{
+    static RedisAsync inst;
+    return &inst;
+}
+
+bool RedisAsync::Init(const char *host, int port, const char *user, const char *pwd, const char *dbName,
+                      int connNum, Epoller *epoller, int timeoutMS)
+{
+    assert(connNum > 0 && epoller);
+    struct addrinfo hints = {0}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int ret = getaddrinfo(host, to_string(port).c_str(), &hints, &res);
+    if (ret != 0 || res == nullptr)
+    {
+        LOG_ERROR("RedisAsync resolve %s error: %s", host, gai_strerror(ret));
+        return false;
+    }
+    memcpy(&addr_, res->ai_addr, res->ai_addrlen);
+    addrLen_ = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    hasUser_ = (user != nullptr);
+    user_ = user ? user : "";
+    hasPwd_ = (pwd != nullptr);
+    pwd_ = pwd ? pwd : "";
+    hasDBName_ = (dbName != nullptr);
+    dbName_ = dbName ? dbName : "";
+    epoller_ = epoller;
+    timeoutMS_ = timeoutMS;
+
+    conns_.clear(); // Close后重新初始化
+    for (int i = 0; i < connNum; i++)
+    {
+        conns_.emplace_back(new Conn());
+        Conn &conn = *conns_.back();
+        conn.fd = -1;
+        conn.state = CONN_DOWN;
+        conn.wantWrite = false;
+        lock_guard<mutex> locker(conn.mtx);
+        if (!Connect_(conn))
+        {
+            return false;
+        }
+    }
+    isOpen_ = true;
+    return true;
+}
+
+void RedisAsync::Close()
+{
+    isOpen_ = false;
+    for (auto &conn : conns_)
+    {
+        vector<Callback> dropped; // 退出时不再回调
+        lock_guard<mutex> locker(conn->mtx);
+        Reset_(*conn, dropped);
+    }
+}
+
+// 发起非阻塞连接，AUTH/SELECT先行写入发送缓冲区，需持有conn.mtx
+bool RedisAsync::Connect_(Conn &conn)
+{
+    int fd = socket(addr_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LOG_ERROR("RedisAsync socket error: %d", errno);
+        conn.nextRetry = chrono::steady_clock::now() + chrono::milliseconds(RETRY_MS);
+        return false;
+    }
+    if (connect(fd, (struct sockaddr *)&addr_, addrLen_) < 0 && errno != EINPROGRESS)
+    {
+        LOG_ERROR("RedisAsync connect error: %d", errno);
+        close(fd);
+        conn.nextRetry = chrono::steady_clock::now() + chrono::milliseconds(RETRY_MS);
+        return false;
+    }
+
+    conn.outBuff.RetrieveAll();
+    conn.inBuff.RetrieveAll();
+    if (hasPwd_)
+    {
+        vector<string> auth = {"AUTH"};
+        if (hasUser_)
+        {
+            auth.push_back(user_);
+        }
+        auth.push_back(pwd_);
+        EncodeCommand(auth, conn.outBuff);
+        conn.callbacks.push_back({Callback(), chrono::steady_clock::now() + chrono::milliseconds(timeoutMS_)});
+    }
+    if (hasDBName_)
+    {
+        EncodeCommand({"SELECT", dbName_}, conn.outBuff);
+        conn.callbacks.push_back({Callback(), chrono::steady_clock::now() + chrono::milliseconds(timeoutMS_)});
+    }
+
+    conn.fd = fd;
+    conn.state = CONN_CONNECTING;
+    conn.wantWrite = true; // 连接建立后可写
+    epoller_->AddFd(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+    return true;
+}
+
+// 关闭连接并取出所有未应答的回调，需持有conn.mtx
+void RedisAsync::Reset_(Conn &conn, vector<Callback> &failed)
+{
+    if (conn.fd >= 0)
+    {
+        if (epoller_)
+        {
+            epoller_->DelFd(conn.fd);
+        }
+        close(conn.fd);
+        conn.fd = -1;
+    }
+    for (auto &item : conn.callbacks)
+    {
+        if (item.cb)
+        {
+            failed.push_back(move(item.cb));
+        }
+    }
+    conn.callbacks.clear();
+    conn.outBuff.RetrieveAll();
+    conn.inBuff.RetrieveAll();
+    conn.state = CONN_DOWN;
+    conn.wantWrite = false;
+    conn.nextRetry = chrono::steady_clock::now() + chrono::milliseconds(RETRY_MS);
+}
+
+// 仅在有待发送数据时监听EPOLLOUT，需持有conn.mtx
+void RedisAsync::UpdateEvents_(Conn &conn)
+{
+    bool want = conn.outBuff.ReadableBytes() > 0 || conn.state == CONN_CONNECTING;
+    if (want != conn.wantWrite)
+    {
+        conn.wantWrite = want;
+        epoller_->ModFd(conn.fd, EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0));
+    }
+}
+
+bool RedisAsync::Command(const vector<string> &args, const Callback &cb)
+{
+    if (!isOpen_ || args.empty())
+    {
+        return false;
+    }
+    // 轮询选择连接，跳过断开且未到重连时间的连接
+    size_t n = conns_.size();
+    unsigned int start = next_++;
+    for (size_t i = 0; i < n; i++)
+    {
+        Conn &conn = *conns_[(start + i) % n];
+        lock_guard<mutex> locker(conn.mtx);
+        if (conn.state == CONN_DOWN)
+        {
+            if (chrono::steady_clock::now() < conn.nextRetry || !Connect_(conn))
+            {
+                continue;
+            }
+            LOG_INFO("RedisAsync reconnecting");
+        }
+        if (conn.callbacks.size() >= MAX_PENDING)
+        {
+            continue;
+        }
+        EncodeCommand(args, conn.outBuff);
+        conn.callbacks.push_back({cb, chrono::steady_clock::now() + chrono::milliseconds(timeoutMS_)});
+        if (conn.state == CONN_UP)
+        {
+            UpdateEvents_(conn); // 由事件循环线程发送，同一轮的命令合并写出
+        }
+        commands_++;
+        return true;
+    }
+    rejected_++;
+    return false;
+}
+
+bool RedisAsync::IsOwnFd(int fd) const
+{
+    for (auto &conn : conns_)
+    {
+        if (conn->fd == fd)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RedisAsync::OnEvent(int fd, uint32_t events)
+{
+    Conn *target = nullptr;
+    for (auto &conn : conns_)
+    {
+        if (conn->fd == fd)
+        {
+            target = conn.get();
+            break;
+        }
+    }
+    if (target == nullptr)
+    {
+        return;
+    }
+
+    Conn &conn = *target;
+    vector<pair<Callback, RedisReply>> done;
+    vector<Callback> failed;
+    {
+        lock_guard<mutex> locker(conn.mtx);
+        if (conn.fd != fd)
+        {
+            return;
+        }
+        bool broken = false;
+        if (conn.state == CONN_CONNECTING)
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0 || (events & (EPOLLERR | EPOLLHUP)))
+            {
+                LOG_ERROR("RedisAsync connect error: %d", err);
+                broken = true;
+            }
+            else if (events & EPOLLOUT)
+            {
+                conn.state = CONN_UP;
+                LOG_INFO("RedisAsync[%d] connected", fd);
+            }
+        }
+
+        if (!broken && (events & EPOLLIN))
+        {
+            int readErrno = 0;
+            ssize_t len = conn.inBuff.ReadFd(fd, &readErrno);
+            if (len == 0 || (len < 0 && readErrno != EAGAIN && readErrno != EINTR))
+            {
+                broken = true;
+            }
+            RedisReply reply;
+            ssize_t used = 0;
+            while (conn.inBuff.ReadableBytes() > 0 &&
+                   (used = ParseReply(conn.inBuff.Peek(), conn.inBuff.ReadableBytes(), reply)) > 0)
+            {
+                conn.inBuff.Retrieve(used);
+                if (conn.callbacks.empty())
+                {
+                    used = -1; // 多余的应答
+                    break;
+                }
+                Callback cb = move(conn.callbacks.front().cb);
+                conn.callbacks.pop_front();
+                if (!cb)
+                {
+                    if (reply.type == REDIS_REPLY_ERROR)
+                    {
+                        LOG_ERROR("RedisAsync handshake error: %s", reply.str.c_str());
+                        broken = true;
+                        break;
+                    }
+                    continue;
+                }
+                done.emplace_back(move(cb), move(reply));
+                reply = RedisReply();
+            }
+            if (used < 0)
+            {
+                LOG_ERROR("RedisAsync protocol error");
+                broken = true;
+            }
+        }
+
+        if (!broken && (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+        {
+            broken = true;
+        }
+
+        if (!broken && conn.state == CONN_UP && conn.outBuff.ReadableBytes() > 0)
+        {
+            int writeErrno = 0;
+            ssize_t len = conn.outBuff.WriteFd(fd, &writeErrno);
+            if (len < 0 && writeErrno != EAGAIN && writeErrno != EINTR)
+            {
+                broken = true;
+            }
+            else if (conn.outBuff.ReadableBytes() == 0)
+            {
+                conn.outBuff.RetrieveAll();
+            }
+        }
+
+        if (broken)
+        {
+            LOG_WARN("RedisAsync[%d] connection lost, %zu pending", fd, conn.callbacks.size());
+            Reset_(conn, failed);
+            failed_ += failed.size();
+        }
+        else
+        {
+            UpdateEvents_(conn);
+        }
+    }
+
+    // 回调在锁外执行，允许回调中提交新命令
+    for (auto &item : done)
+    {
+        item.first(&item.second);
+    }
+    for (auto &cb : failed)
+    {
+        cb(nullptr);
+    }
+}
+
+// Redis阻塞或网络中断而连接未断开时收不到应答，也没有事件触发，由事件循环定期检查；
+// 最早的命令超时后重置所在连接，所有未应答的命令回调nullptr
+int RedisAsync::CheckTimeout()
+{
+    if (!isOpen_)
+    {
+        return -1;
+    }
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    int next = -1;
+    vector<Callback> failed;
+    for (auto &conn : conns_)
+    {
+        lock_guard<mutex> locker(conn->mtx);
+        if (conn->callbacks.empty())
+        {
+            continue;
+        }
+        chrono::steady_clock::time_point expires = conn->callbacks.front().expires;
+        if (expires <= now)
+        {
+            LOG_WARN("RedisAsync[%d] reply timeout, %zu pending", conn->fd.load(), conn->callbacks.size());
+            size_t before = failed.size();
+            Reset_(*conn, failed);
+            failed_ += failed.size() - before;
+            timeouts_++;
+            continue;
+        }
+        int ms = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(expires - now).count()) + 1;
+        if (next < 0 || ms < next)
+        {
+            next = ms;
+        }
+    }
+    for (auto &cb : failed)
+    {
+        cb(nullptr);
+    }
+    return next;
+}
+
+string RedisAsync::Stats()
+{
+    int up = 0;
+    size_t pending = 0;
+    for (auto &conn : conns_)
+    {
+        lock_guard<mutex> locker(conn->mtx);
+        up += (conn->state == CONN_UP);
+        pending += conn->callbacks.size();
+    }
+    return "up:" + to_string(up) + "/" + to_string(conns_.size()) + " pending:" + to_string(pending) +
+           " commands:" + to_string(commands_) + " rejected:" + to_string(rejected_) + " failed:" + to_string(failed_) + " timeouts:" + to_string(timeouts_);
+}
+
+void RedisAsync::EncodeCommand(const vector<string> &args, Buffer &buff)
+{
+    buff.Append("*" + to_string(args.size()) + "\r\n");
+    for (const string &arg : args)
+    {
+        buff.Append("$" + to_string(arg.size()) + "\r\n");
+        buff.Append(arg);
+        buff.Append("\r\n", 2);
+    }
+}
+
+ssize_t RedisAsync::ParseReply(const char *data, size_t len, RedisReply &reply)
+{
+    return Parse_(data, len, 0, reply, 0);
+}
+
+// 读取pos处到CRLF的一行，返回下一行起始位置
+ssize_t RedisAsync::ParseLine_(const char *data, size_t len, size_t pos, string &line)
+{
+    for (size_t i = pos; i + 1 < len; i++)
+    {
+        if (data[i] == '\r' && data[i + 1] == '\n')
+        {
+            line.assign(data + pos, i - pos);
+            return i + 2;
+        }
+    }
+    return 0;
+}
+
+ssize_t RedisAsync::Parse_(const char *data, size_t len, size_t pos, RedisReply &reply, int depth)
+{
+    if (pos >= len)
+    {
+        return 0;
+    }
+    if (depth > 8)
+    {
+        return -1;
+    }
+    char type = data[pos];
+    string line;
+    ssize_t next = ParseLine_(data, len, pos + 1, line);
+    if (next == 0)
+    {
+        return 0;
+    }
+
+    reply.integer = 0;
+    switch (type)
+    {
+    case '+':
+        reply.type = REDIS_REPLY_STATUS;
+        reply.str = line;
+        return next;
+    case '-':
+        reply.type = REDIS_REPLY_ERROR;
+        reply.str = line;
+        return next;
+    case ':':
+        reply.type = REDIS_REPLY_INTEGER;
+        reply.integer = strtoll(line.c_str(), nullptr, 10);
+        return next;
+    case '$':
+    {
+        long long n = strtoll(line.c_str(), nullptr, 10);
+        if (n < 0)
+        {
+            reply.type = REDIS_REPLY_NIL;
+            return next;
+        }
+        if (static_cast<size_t>(next) + n + 2 > len)
+        {
+            return 0;
+        }
+        reply.type = REDIS_REPLY_STRING;
+        reply.str.assign(data + next, n);
+        return next + n + 2;
+    }
+    case '*':
+    {
+        long long n = strtoll(line.c_str(), nullptr, 10);
+        if (n < 0)
+        {
+            reply.type = REDIS_REPLY_NIL;
+            return next;
+        }
+        if (n * 3 > static_cast<long long>(len - next))
+        {
+            return 0; // 每个元素至少3字节
+        }
+        reply.type = REDIS_REPLY_ARRAY;
+        reply.elements.resize(n);
+        for (long long i = 0; i < n; i++)
+        {
+            next = Parse_(data, len, next, reply.elements[i], depth + 1);
+            if (next <= 0)
+            {
+                return next;
+            }
+        }
+        return next;
+    }
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#ifndef REDIS_ASYNC_H
+#define REDIS_ASYNC_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <sys/socket.h>
+
+#include "buffer/buffer.h"
+#include "server/epoller.h"
+
+// RESP应答，type取值同hiredis的REDIS_REPLY_*
+struct RedisReply
+{
+    int type;
+    long long integer;
+    std::string str;
+    std::vector<RedisReply> elements;
+};
+
+// 挂在服务端epoll上的非阻塞Redis客户端
+// 工作线程提交命令后立即返回，多个连接的命令在少量socket上流水线发送，应答按序回调
+class RedisAsync
+{
+public:
+    typedef std::function<void(const RedisReply *)> Callback; // reply为nullptr表示连接出错
+
+    static RedisAsync *Instance();
+
+    // timeoutMS为单条命令的应答时限，超时后重置所在连接
+    bool Init(const char *host, int port, const char *user, const char *pwd, const char *dbName,
+              int connNum, Epoller *epoller, int timeoutMS = 1000);
+    void Close();
+    bool IsOpen() const { return isOpen_; }
+
+    // 可在任意线程调用；回调在事件循环线程中执行，应尽快返回
+    bool Command(const std::vector<std::string> &args, const Callback &cb);
+
+    // 以下由事件循环线程调用
+    bool IsOwnFd(int fd) const;
+    void OnEvent(int fd, uint32_t events);
+    int CheckTimeout(); // 返回距下一个应答时限的毫秒数，没有等待应答的命令时返回-1
+
+    std::string Stats();
+
+    // 解析一个完整应答，返回消耗的字节数；数据不完整返回0，协议错误返回-1
+    static ssize_t ParseReply(const char *data, size_t len, RedisReply &reply);
+    static void EncodeCommand(const std::vector<std::string> &args, Buffer &buff);
+
+private:
+    RedisAsync();
+    ~RedisAsync();
+
+    enum CONN_STATE
+    {
+        CONN_DOWN,
+        CONN_CONNECTING,
+        CONN_UP,
+    };
+
+    struct Pending
+    {
+        Callback cb; // 空回调为握手命令
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Conn
+    {
+        std::mutex mtx;
+        std::atomic<int> fd;
+        CONN_STATE state;
+        bool wantWrite; // 已监听EPOLLOUT
+        Buffer outBuff;
+        Buffer inBuff;
+        std::deque<Pending> callbacks; // 等待应答的命令，按发送顺序排列
+        std::chrono::steady_clock::time_point nextRetry;
+    };
+
+    bool Connect_(Conn &conn);
+    void Reset_(Conn &conn, std::vector<Callback> &failed);
+    void UpdateEvents_(Conn &conn);
+
+    static ssize_t ParseLine_(const char *data, size_t len, size_t pos, std::string &line);
+    static ssize_t Parse_(const char *data, size_t len, size_t pos, RedisReply &reply, int depth);
+
+    static const int MAX_PENDING = 4096; // 单个连接上未应答命令上限
+    static const int RETRY_MS = 1000;    // 断开后的重连间隔
+
+    bool isOpen_;
+    int timeoutMS_;
+    Epoller *epoller_;
+    struct sockaddr_storage addr_;
+    socklen_t addrLen_;
+    std::string user_, pwd_, dbName_;
+    bool hasUser_, hasPwd_, hasDBName_;
+
+    std::vector<std::unique_ptr<Conn>> conns_;
+    std::atomic<unsigned int> next_;
+
+    std::atomic<unsigned long long> commands_;
+    std::atomic<unsigned long long> rejected_;
+    std::atomic<unsigned long long> failed_;
+    std::atomic<unsigned long long> timeouts_; // 因应答超时重置连接的次数
+};
+
+#endif // REDIS_ASYNC_H
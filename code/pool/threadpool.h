@@ -12,6 +12,9 @@
 #include <queue>
 #include <thread>
 #include <functional>
+#include <chrono>
+#include <string>
+#include <stdio.h>
 #include <assert.h>
 
 class ThreadPool
@@ -29,9 +32,14 @@ public:
                         if(!pool->tasks.empty()) {
                             auto task = std::move(pool->tasks.front());
                             pool->tasks.pop();
+                            pool->busy++;
+                            pool->waitUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - task.enqueued).count();
                             locker.unlock();
-                            task();
+                            task.func();
                             locker.lock();
+                            pool->busy--;
+                            pool->done++;
                         } 
                         else if(pool->isClosed) break;
                         else pool->cond.wait(locker);
@@ -61,18 +69,43 @@ public:
     {
         {
             std::lock_guard<std::mutex> locker(pool_->mtx);
-            pool_->tasks.emplace(std::forward<F>(task));
+            pool_->tasks.push(Task{std::function<void()>(std::forward<F>(task)), std::chrono::steady_clock::now()});
+            if (pool_->tasks.size() > pool_->maxQueued)
+            {
+                pool_->maxQueued = pool_->tasks.size();
+            }
         }
         pool_->cond.notify_one();
     }
 
+    // 排队与执行中的任务数、已完成数及平均排队时间，峰值队列长度每次调用后清零
+    std::string Stats()
+    {
+        std::lock_guard<std::mutex> locker(pool_->mtx);
+        char buf[128];
+        snprintf(buf, sizeof(buf), "queued:%zu peak:%zu busy:%zu done:%llu avgWait:%lluus",
+                 pool_->tasks.size(), pool_->maxQueued, pool_->busy, pool_->done,
+                 pool_->done ? pool_->waitUs / pool_->done : 0ULL);
+        pool_->maxQueued = pool_->tasks.size();
+        return buf;
+    }
+
 private:
+    struct Task
+    {
+        std::function<void()> func;
+        std::chrono::steady_clock::time_point enqueued;
+    };
     struct Pool
     {
         std::mutex mtx;
         std::condition_variable cond;
-        bool isClosed;
-        std::queue<std::function<void()>> tasks;
+        bool isClosed = false;
+        std::queue<Task> tasks;
+        size_t busy = 0;
+        size_t maxQueued = 0;
+        unsigned long long done = 0;
+        unsigned long long waitUs = 0; // 累计排队时间
     };
     std::shared_ptr<Pool> pool_;
 };
@@ -10,24 +10,42 @@
 #include <unistd.h> // close
 #include <assert.h>
 #include <errno.h>
+#include <future> // async
 #include <signal.h>
 #include <sys/socket.h>
 
 #include "log/log.h"
+#include "log/accesslog.h"
+#include "auth/sessiontoken.h"
+#include "auth/sessionstore.h"
+#include "auth/userstore.h"
+#include "cache/sessioncache.h"
+#include "cache/credentialcache.h"
+#include "cache/listcache.h"
+#include "http/uploadsession.h"
+#include "http/objectstore.h"
 #include "pool/connpool.h"
 #include "pool/connRAII.h"
+#include "pool/redisasync.h"
+#include "buffer/blockpool.h"
 
 using namespace std;
 
 bool WebServer::isClose_ = false;
+const int WebServer::STATS_INTERVAL_MS;
+const int WebServer::UPLOAD_SESSION_TTL_SEC;
 
 WebServer::WebServer(
     int port, int trigMode, int timeoutMS, bool OptLinger, bool OptIPv6,
     const char *mysqlAddr, int mysqlPort, const char *mysqlUser, const char *mysqlPwd, const char *mysqlDBName,
     const char *redisAddr, int redisPort, const char *redisUser, const char *redisPwd, const char *redisDBName,
     int connPoolNum, int threadNum,
-    bool enableLog, int logLevel, int logQueSize) : port_(port), enableLinger_(OptLinger), enableIPv6_(OptIPv6), timeoutMS_(timeoutMS),
-                                                    timer_(new HeapTimer()), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller())
+    bool enableLog, int logLevel, int logQueSize, int logFileMB, int logFileNum, bool logCompress,
+    bool enableAccessLog, int accessLogFormat,
+    int sessionCacheSec, int sessionMode, const char *sessionKey,
+    int connPoolTimeoutMS, int redisAsyncNum, int credCacheSec, int connPoolMinReady, int storeBackend, bool dedupStore,
+    int fileIoThreadNum) : port_(port), enableLinger_(OptLinger), enableIPv6_(OptIPv6), timeoutMS_(timeoutMS),
+                                                    memStore_(storeBackend == 1), timer_(new HeapTimer()), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller())
 {
     HttpConn::resDir = "./resources";
     HttpConn::dataDir = "./data";
@@ -37,7 +55,7 @@ WebServer::WebServer(
 
     if (enableLog)
     {
-        Log::Instance()->Init(logLevel, "./log", ".log", logQueSize);
+        Log::Instance()->Init(logLevel, "./log", ".log", logQueSize, static_cast<size_t>(logFileMB) * 1024 * 1024, logFileNum, logCompress);
         if (isClose_)
         {
             LOG_ERROR("========== Server Init error!==========");
@@ -49,24 +67,36 @@ WebServer::WebServer(
             LOG_INFO("Listen Mode: %s, Connect Mode: %s",
                      (listenEvent_ & EPOLLET ? "ET" : "LT"),
                      (connEvent_ & EPOLLET ? "ET" : "LT"));
-            LOG_INFO("LogSys level: %d", logLevel);
+            LOG_INFO("LogSys level: %d, file size: %dMB, history: %d, compress: %s", logLevel, logFileMB, logFileNum, logCompress ? "true" : "false");
             LOG_INFO("resDir: %s, dataDir: %s", HttpConn::resDir.c_str(), HttpConn::dataDir.c_str());
-            LOG_INFO("ConnPool num: %d, ThreadPool num: %d", connPoolNum, threadNum);
+            LOG_INFO("ConnPool num: %d, acquire timeout: %dms, ThreadPool num: %d", connPoolNum, connPoolTimeoutMS, threadNum);
         }
     }
 
-    if (!MySQLConnPool::Instance()->InitPool(mysqlAddr, mysqlPort, mysqlUser, mysqlPwd, mysqlDBName, connPoolNum))
+    if (enableAccessLog)
     {
-        isClose_ = true;
-        LOG_ERROR("========== SQLPool Init error!==========");
+        if (AccessLog::Instance()->Init("./log", "access.log", accessLogFormat))
+        {
+            LOG_INFO("AccessLog format: %d", accessLogFormat);
+        }
+        else
+        {
+            LOG_ERROR("========== AccessLog Init error!==========");
+        }
     }
 
-    if (!RedisConnPool::Instance()->InitPool(redisAddr, redisPort, redisUser, redisPwd, redisDBName, connPoolNum))
+    SessionCache::Instance()->Init(sessionCacheSec * 1000);
+    LOG_INFO("SessionCache ttl: %ds", sessionCacheSec);
+    CredentialCache::Instance()->Init(credCacheSec * 1000);
+    LOG_INFO("CredentialCache ttl: %ds", credCacheSec);
+    ListCache::Instance()->Init();
+    if (sessionMode == 1 || sessionMode == 2)
     {
-        isClose_ = true;
-        LOG_ERROR("========== RedisPool Init error!==========");
+        SessionToken::Instance()->Init(sessionKey ? sessionKey : "", sessionMode == 2);
     }
+    LOG_INFO("Session mode: %s", sessionMode == 1 ? "token" : (sessionMode == 2 ? "token+revocation" : "redis"));
 
+    // 先打开监听socket，连接池预热期间即可处理静态资源请求
     listenFdv4_=-1;
     listenFdv6_=-1;
 
@@ -75,6 +105,64 @@ WebServer::WebServer(
         isClose_ = true;
         LOG_ERROR("========== Socket Init error!==========");
     }
+
+    // 内存后端不依赖MySQL/Redis，用户与session仅保存在进程内，重启后丢失
+    UserStore::Init(memStore_ ? UserStore::BACKEND_MEMORY : UserStore::BACKEND_MYSQL);
+    SessionStore::Init(memStore_ ? SessionStore::BACKEND_MEMORY : SessionStore::BACKEND_REDIS);
+    LOG_INFO("Store backend: %s", memStore_ ? "memory" : "mysql+redis");
+    UploadSessions::Instance()->Init(UPLOAD_SESSION_TTL_SEC, !memStore_); // 使用Redis时上传会话可在重启后恢复
+    ObjectStore::Instance()->Init(HttpConn::dataDir, dedupStore);
+    LOG_INFO("Dedup store: %s", dedupStore ? "on" : "off");
+    // 数据盘变慢时只有文件I/O线程排队，工作线程继续处理静态资源与其他接口
+    if (fileIoThreadNum > 0)
+    {
+        fileIoPool_.reset(new ThreadPool(fileIoThreadNum));
+    }
+    HttpRequest::deferDisk = static_cast<bool>(fileIoPool_);
+    LOG_INFO("FileIoPool num: %d", fileIoThreadNum);
+    if (!memStore_ && !isClose_)
+    {
+        // 连接池在后台预热，事件循环先启动处理静态资源；就绪前依赖存储的接口直接返回503
+        // 两个连接池同时预热，各自就绪connPoolMinReady个连接后即可使用，其余在后台补齐
+        storeReady_ = async(launch::async, [=]
+                            {
+            future<bool> redisReady = async(launch::async, [=]
+                                            { return RedisConnPool::Instance()->InitPool(redisAddr, redisPort, redisUser, redisPwd, redisDBName,
+                                                                                         connPoolNum, connPoolTimeoutMS, 30000, connPoolMinReady); });
+            bool ready = true;
+            if (!MySQLConnPool::Instance()->InitPool(mysqlAddr, mysqlPort, mysqlUser, mysqlPwd, mysqlDBName,
+                                                     connPoolNum, connPoolTimeoutMS, 30000, connPoolMinReady))
+            {
+                ready = false;
+                LOG_ERROR("========== SQLPool Init error!==========");
+            }
+            if (!redisReady.get())
+            {
+                ready = false;
+                LOG_ERROR("========== RedisPool Init error!==========");
+            }
+            // 写入无效fd唤醒事件循环，由主线程完成后续初始化
+            int wakeFd = -1;
+            lock_guard<mutex> lock(pipeMutex);
+            write(pipefd[1], &wakeFd, sizeof(wakeFd));
+            return ready; });
+
+        // session查询走挂在epoll上的异步客户端，与事件循环共用状态，须在主线程初始化
+        if (redisAsyncNum > 0)
+        {
+            initRedisAsync_ = [=]
+            {
+                if (RedisAsync::Instance()->Init(redisAddr, redisPort, redisUser, redisPwd, redisDBName, redisAsyncNum, epoller_.get()))
+                {
+                    LOG_INFO("RedisAsync conn num: %d", redisAsyncNum);
+                }
+                else
+                {
+                    LOG_ERROR("========== RedisAsync Init error!==========");
+                }
+            };
+        }
+    }
 }
 
 WebServer::~WebServer()
@@ -88,8 +176,14 @@ WebServer::~WebServer()
     close(pipefd[0]);
     close(pipefd[1]);
     isClose_ = true;
+    if (storeReady_.valid())
+    {
+        storeReady_.wait(); // 预热未完成时退出，等待预热线程结束后再关闭连接池
+    }
+    RedisAsync::Instance()->Close();
     MySQLConnPool::Instance()->ClosePool();
     RedisConnPool::Instance()->ClosePool();
+    AccessLog::Instance()->Close();
 }
 
 /*
@@ -136,11 +230,38 @@ void WebServer::Start()
     {
         LOG_INFO("========== Server start ==========");
     }
+    statsTick_ = Clock::now() + MS(STATS_INTERVAL_MS);
     while (!isClose_)
     {
+        if (storeReady_.valid() && storeReady_.wait_for(chrono::seconds(0)) == future_status::ready)
+        {
+            OnStoreReady_(storeReady_.get());
+            continue;
+        }
         if (timeoutMS_ > 0)
         {
             timeMS = timer_->GetNextTick(); // 清除当前超时节点并获取最近的下一次超时时间
+            if (!timeoutDeferred_.empty())
+            {
+                RearmDeferred_();
+                timeMS = timer_->GetNextTick();
+            }
+        }
+        int redisMS = RedisAsync::Instance()->CheckTimeout(); // 挂起的请求不会因Redis无应答而一直占用连接
+        if (redisMS >= 0 && (timeMS < 0 || redisMS < timeMS))
+        {
+            timeMS = redisMS;
+        }
+        int statsMS = std::chrono::duration_cast<MS>(statsTick_ - Clock::now()).count();
+        if (statsMS <= 0)
+        {
+            LogStats_();
+            statsTick_ = Clock::now() + MS(STATS_INTERVAL_MS);
+            statsMS = STATS_INTERVAL_MS;
+        }
+        if (timeMS < 0 || timeMS > statsMS)
+        {
+            timeMS = statsMS;
         }
         int eventCnt = epoller_->Wait(timeMS);
         for (int i = 0; i < eventCnt; i++)
@@ -162,6 +283,10 @@ void WebServer::Start()
                     assert(users_.count(endfd) > 0);
                     EndConn_(&users_[endfd]);
                 }
+            }
+            else if (RedisAsync::Instance()->IsOwnFd(fd))
+            {
+                RedisAsync::Instance()->OnEvent(fd, events);
             } // EPOLLRDHUP: 对方异常断开连接 EPOLLHUP: 本方异常断开连接 EPOLLERR: 错误
             else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
             {
@@ -186,6 +311,65 @@ void WebServer::Start()
     }
 }
 
+// 连接池预热结束，失败时退出；成功后初始化异步Redis客户端(初始化失败时退回连接池同步查询)
+void WebServer::OnStoreReady_(bool ready)
+{
+    if (!ready)
+    {
+        isClose_ = true;
+        return;
+    }
+    LOG_INFO("Store pools ready");
+    if (initRedisAsync_)
+    {
+        initRedisAsync_();
+        initRedisAsync_ = nullptr;
+    }
+}
+
+// 定期输出各组件运行统计
+void WebServer::LogStats_()
+{
+    SessionCache *cache = SessionCache::Instance();
+    if (cache->IsOpen())
+    {
+        LOG_INFO("SessionCache size:%zu hit:%llu miss:%llu ratio:%.2f%%",
+                 cache->Size(), cache->Hits(), cache->Misses(), cache->HitRatio() * 100);
+    }
+    CredentialCache *cred = CredentialCache::Instance();
+    if (cred->IsOpen())
+    {
+        LOG_INFO("CredentialCache size:%zu hit:%llu miss:%llu ratio:%.2f%%",
+                 cred->Size(), cred->Hits(), cred->Misses(), cred->HitRatio() * 100);
+    }
+    LOG_INFO("UploadSessions active:%zu", UploadSessions::Instance()->Size());
+    ListCache *list = ListCache::Instance();
+    if (list->IsOpen())
+    {
+        LOG_INFO("ListCache size:%zu hit:%llu miss:%llu ratio:%.2f%%",
+                 list->Size(), list->Hits(), list->Misses(), list->HitRatio() * 100);
+    }
+    if (!memStore_)
+    {
+        LOG_INFO("SQLPool %s", MySQLConnPool::Instance()->Stats().c_str());
+        LOG_INFO("RedisPool %s", RedisConnPool::Instance()->Stats().c_str());
+    }
+    if (RedisAsync::Instance()->IsOpen())
+    {
+        LOG_INFO("RedisAsync %s", RedisAsync::Instance()->Stats().c_str());
+    }
+    if (AccessLog::Instance()->IsOpen())
+    {
+        LOG_INFO("AccessLog dropped:%zu", AccessLog::Instance()->DroppedCount());
+    }
+    LOG_INFO("BlockPool %s", BlockPool::Instance()->Stats().c_str());
+    LOG_INFO("ThreadPool %s", threadpool_->Stats().c_str());
+    if (fileIoPool_)
+    {
+        LOG_INFO("FileIoPool %s", fileIoPool_->Stats().c_str());
+    }
+}
+
 void WebServer::SendError_(int fd, const char *info)
 {
     assert(fd > 0);
@@ -197,7 +381,33 @@ void WebServer::SendError_(int fd, const char *info)
     close(fd);
 }
 
-// CloseConn_为timer超时的回调函数，无论主动关闭还是超时关闭，都需要调用CloseConn_函数
+// timer的回调函数：线程池中仍持有该连接时不能析构，推迟到tick结束后重新计时
+void WebServer::OnTimeout_(HttpConn *client)
+{
+    assert(client);
+    if (client->IsBusy())
+    {
+        timeoutDeferred_.push_back(client->GetFd());
+        return;
+    }
+    CloseConn_(client);
+}
+
+// tick过程中不能修改堆，在其返回后为被推迟的连接重新加入定时器
+void WebServer::RearmDeferred_()
+{
+    for (int fd : timeoutDeferred_)
+    {
+        auto it = users_.find(fd);
+        if (it != users_.end())
+        {
+            timer_->add(fd, timeoutMS_, bind(&WebServer::OnTimeout_, this, &it->second));
+        }
+    }
+    timeoutDeferred_.clear();
+}
+
+// 无论主动关闭还是超时关闭，都需要调用CloseConn_函数
 void WebServer::CloseConn_(HttpConn *client)
 {
     assert(client);
@@ -220,7 +430,7 @@ void WebServer::AddClient_(int fd, sockaddr_storage addr)
     users_[fd].Init(fd, addr);
     if (timeoutMS_ > 0)
     {
-        timer_->add(fd, timeoutMS_, bind(&WebServer::CloseConn_, this, &users_[fd]));
+        timer_->add(fd, timeoutMS_, bind(&WebServer::OnTimeout_, this, &users_[fd]));
     }
     epoller_->AddFd(fd, EPOLLIN | connEvent_);
     SetFdNonblock(fd);
@@ -252,14 +462,22 @@ void WebServer::DealRead_(HttpConn *client)
 {
     assert(client);
     ExtentTime_(client);
-    threadpool_->AddTask(bind(&WebServer::OnRead_, this, client));
+    client->SetBusy(true);
+    PoolFor_(client)->AddTask(bind(&WebServer::OnRead_, this, client));
 }
 
 void WebServer::DealWrite_(HttpConn *client)
 {
     assert(client);
     ExtentTime_(client);
-    threadpool_->AddTask(bind(&WebServer::OnWrite_, this, client));
+    client->SetBusy(true);
+    PoolFor_(client)->AddTask(bind(&WebServer::OnWrite_, this, client));
+}
+
+// 在事件循环线程中调用，EPOLLONESHOT保证此时没有其他线程在处理该连接
+ThreadPool *WebServer::PoolFor_(HttpConn *client)
+{
+    return (fileIoPool_ && client->IsDiskBound()) ? fileIoPool_.get() : threadpool_.get();
 }
 
 // 延长一个连接的超时时间
@@ -281,6 +499,7 @@ void WebServer::OnRead_(HttpConn *client)
     ret = client->read(&readErrno);
     if (ret <= 0 && readErrno != EAGAIN)
     {
+        client->SetBusy(false);
         lock_guard<mutex> lock(pipeMutex);
         write(pipefd[1], &fd, sizeof(fd));
         return;
@@ -288,16 +507,60 @@ void WebServer::OnRead_(HttpConn *client)
     OnProcess(client);
 }
 
+// 交还给事件循环之前清除busy，之后只使用fd，连接可能随即被超时关闭
 void WebServer::OnProcess(HttpConn *client)
 {
+    int fd = client->GetFd();
     if (client->process())
     {
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        client->SetBusy(false);
+        epoller_->ModFd(fd, connEvent_ | EPOLLOUT);
+    }
+    else if (client->IsSuspended())
+    {
+        Suspend_(client); // 挂起期间不监听该连接的事件，仍保持busy直到应答返回
+    }
+    else if (client->IsDiskWait())
+    {
+        fileIoPool_->AddTask(bind(&WebServer::OnProcess, this, client)); // 保持busy，在文件I/O线程中Resume
     }
     else
     {
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+        client->SetBusy(false);
+        epoller_->ModFd(fd, connEvent_ | EPOLLIN);
+    }
+}
+
+// 提交session查询后工作线程立即返回，应答到达后再投递到线程池继续处理
+void WebServer::Suspend_(HttpConn *client)
+{
+    int fd = client->GetFd();
+    uint64_t id = client->GetId();
+    if (!RedisAsync::Instance()->Command(client->SessionCommand(), [this, fd, id](const RedisReply *reply)
+                                         { OnSessionReply_(fd, id, reply); }))
+    {
+        client->OnSessionReply(nullptr); // 无可用连接，按存储不可用返回503
+        OnProcess(client);
+    }
+}
+
+// 在事件循环线程中执行，连接可能已超时关闭或fd已被复用
+// 会阻塞于存储或磁盘的路由投递到线程池，其余直接处理
+void WebServer::OnSessionReply_(int fd, uint64_t id, const RedisReply *reply)
+{
+    auto it = users_.find(fd);
+    if (it == users_.end() || it->second.GetId() != id || !it->second.IsSuspended())
+    {
+        return;
+    }
+    HttpConn *client = &it->second;
+    client->OnSessionReply(reply);
+    if (!client->IsBlocking())
+    {
+        OnProcess(client); // 后续处理不访问存储与磁盘，直接在当前线程完成
+        return;
     }
+    threadpool_->AddTask(bind(&WebServer::OnProcess, this, client));
 }
 
 void WebServer::OnWrite_(HttpConn *client)
@@ -321,10 +584,12 @@ void WebServer::OnWrite_(HttpConn *client)
         if (writeErrno == EAGAIN)
         {
             // 继续传输
+            client->SetBusy(false);
             epoller_->ModFd(fd, connEvent_ | EPOLLOUT);
             return;
         }
     }
+    client->SetBusy(false);
     lock_guard<mutex> lock(pipeMutex);
     write(pipefd[1], &fd, sizeof(fd));
 }
@@ -6,6 +6,8 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 
+#include <future>
+#include <functional>
 #include <unordered_map>
 #include <arpa/inet.h> // sockaddr
 
@@ -22,7 +24,11 @@ public:
         const char *mysqlAddr, int mysqlPort, const char *mysqlUser, const char *mysqlPwd, const char *mysqlDBName,
         const char *redisAddr, int redisPort, const char *redisUser, const char *redisPwd, const char *redisDBName,
         int connPoolNum, int threadNum,
-        bool enableLog, int logLevel, int logQueSize);
+        bool enableLog, int logLevel, int logQueSize, int logFileMB, int logFileNum, bool logCompress,
+        bool enableAccessLog, int accessLogFormat,
+        int sessionCacheSec, int sessionMode, const char *sessionKey,
+        int connPoolTimeoutMS, int redisAsyncNum, int credCacheSec, int connPoolMinReady, int storeBackend, bool dedupStore,
+        int fileIoThreadNum);
 
     ~WebServer();
     void Start();
@@ -36,6 +42,9 @@ private:
     void DealListen_(int listenFd);
     void DealWrite_(HttpConn *client);
     void DealRead_(HttpConn *client);
+    ThreadPool *PoolFor_(HttpConn *client); // 磁盘路由的请求由文件I/O线程池处理
+    void OnTimeout_(HttpConn *client);
+    void RearmDeferred_();
 
     void SendError_(int fd, const char *info);
     void ExtentTime_(HttpConn *client);
@@ -45,8 +54,14 @@ private:
     void OnRead_(HttpConn *client);
     void OnWrite_(HttpConn *client);
     void OnProcess(HttpConn *client);
+    void Suspend_(HttpConn *client);
+    void OnSessionReply_(int fd, uint64_t id, const RedisReply *reply);
+    void OnStoreReady_(bool ready);
+    void LogStats_();
 
     static const int MAX_FD = 65536;
+    static const int STATS_INTERVAL_MS = 60000; // 运行统计输出间隔
+    static const int UPLOAD_SESSION_TTL_SEC = 24 * 3600; // 上传会话未活动的保留时间
 
     static int SetFdNonblock(int fd);
 
@@ -54,6 +69,7 @@ private:
     bool enableLinger_;
     bool enableIPv6_;
     int timeoutMS_; // 毫秒MS
+    bool memStore_; // 用户与session使用进程内存储
     int listenFdv4_;
     int listenFdv6_;
     int pipefd[2]; // 文件描述符数组，0表示读取端，1表示写入端
@@ -62,10 +78,16 @@ private:
     uint32_t listenEvent_;
     uint32_t connEvent_;
 
+    TimeStamp statsTick_; // 下一次输出运行统计的时间
+
     std::unique_ptr<HeapTimer> timer_;
     std::unique_ptr<ThreadPool> threadpool_;
+    std::unique_ptr<ThreadPool> fileIoPool_; // 文件I/O线程池，为空时磁盘操作在工作线程中进行
     std::unique_ptr<Epoller> epoller_;
     std::unordered_map<int, HttpConn> users_;
+    std::vector<int> timeoutDeferred_; // 超时时仍在线程池中的连接
+    std::future<bool> storeReady_;         // 连接池后台预热结果，取得后失效
+    std::function<void()> initRedisAsync_; // 连接池就绪后在主线程执行
 };
 
 #endif // WEBSERVER_H
\ No newline at end of file
@@ -0,0 +1,232 @@
+/*
+ * @Author       : zys
+ * @Date         : 2026-10-18
+ * @copyleft Apache 2.0
+ */
+#include <chrono>
+#include <random>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <hiredis/hiredis.h>
+
+#include "auth/randomid.h"
+#include "buffer/buffer.h"
+#include "buffer/chainbuffer.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static bool CheckReply(redisReply *reply) {
+    if(reply == nullptr) {
+        return false;
+    }
+    bool ok = reply->type != REDIS_REPLY_ERROR;
+    freeReplyObject(reply);
+    return ok;
+}
+
+// 旧流程：EXISTS + HSET + EXPIRE，三次往返
+static double EnrollLegacy(redisContext *redis, int n) {
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        std::string uid = "bench:legacy:" + std::to_string(i);
+        if(!CheckReply((redisReply *)redisCommand(redis, "EXISTS %s", uid.c_str())) ||
+           !CheckReply((redisReply *)redisCommand(redis, "HSET %s username %s", uid.c_str(), "bench")) ||
+           !CheckReply((redisReply *)redisCommand(redis, "EXPIRE %s %d", uid.c_str(), 60))) {
+            return -1;
+        }
+    }
+    return ElapsedUs(start);
+}
+
+// 新流程：SET NX EX，一次往返
+static double EnrollSetNx(redisContext *redis, int n) {
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        std::string uid = "bench:setnx:" + std::to_string(i);
+        if(!CheckReply((redisReply *)redisCommand(redis, "SET %s %s NX EX %d", uid.c_str(), "bench", 60))) {
+            return -1;
+        }
+    }
+    return ElapsedUs(start);
+}
+
+static void Cleanup(redisContext *redis, int n) {
+    for(int i = 0; i < n; i++) {
+        redisAppendCommand(redis, "DEL bench:legacy:%d", i);
+        redisAppendCommand(redis, "DEL bench:setnx:%d", i);
+    }
+    for(int i = 0; i < 2 * n; i++) {
+        void *reply = nullptr;
+        if(redisGetReply(redis, &reply) != REDIS_OK) {
+            break;
+        }
+        freeReplyObject(reply);
+    }
+}
+
+void BenchRedisEnroll(const char *host, int port, const char *pwd, int n) {
+    redisContext *redis = redisConnect(host, port);
+    if(redis == nullptr || redis->err) {
+        printf("RedisEnroll: connect %s:%d failed, skipped\n", host, port);
+        if(redis) {
+            redisFree(redis);
+        }
+        return;
+    }
+    if(pwd && !CheckReply((redisReply *)redisCommand(redis, "AUTH %s", pwd))) {
+        printf("RedisEnroll: auth failed, skipped\n");
+        redisFree(redis);
+        return;
+    }
+
+    Cleanup(redis, n);
+    double legacy = EnrollLegacy(redis, n);
+    double setnx = EnrollSetNx(redis, n);
+    Cleanup(redis, n);
+    redisFree(redis);
+    if(legacy < 0 || setnx < 0) {
+        printf("RedisEnroll: command error\n");
+        return;
+    }
+    printf("RedisEnroll  EXISTS+HSET+EXPIRE: %8.2f us/op  %10.0f op/s\n", legacy / n, n * 1e6 / legacy);
+    printf("RedisEnroll  SET NX EX         : %8.2f us/op  %10.0f op/s\n", setnx / n, n * 1e6 / setnx);
+}
+
+// 旧实现：每次构造random_device与mt19937
+static std::string LegacyRandomID() {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::uniform_int_distribution<> dis(0, characters.size() - 1);
+    std::string uid;
+    for(int i = 0; i < 16; ++i) {
+        uid += characters[dis(gen)];
+    }
+    return uid;
+}
+
+void BenchRandomID(int n) {
+    size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        sink += LegacyRandomID()[0];
+    }
+    double legacy = ElapsedUs(start);
+    char buf[RandomID::LEN];
+    start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        RandomID::Generate(buf);
+        sink += buf[0];
+    }
+    double chacha = ElapsedUs(start);
+    printf("RandomID     mt19937 per call   : %8.3f us/op  %10.0f op/s\n", legacy / n, n * 1e6 / legacy);
+    printf("RandomID     ChaCha20 per thread: %8.3f us/op  %10.0f op/s  (%zu)\n", chacha / n, n * 1e6 / chacha, sink % 10);
+}
+
+static void PrintRate(const char *name, double us, int n, size_t bytes) {
+    printf("Buffer       %-19s: %8.3f us/op  %10.0f op/s  %8.1f MB/s\n", name, us / n, n * 1e6 / us,
+           bytes / us);
+}
+
+// 日志写入模式：追加一行后整体取出
+static void BenchBufferAppendAll(int n) {
+    Buffer buff;
+    const char line[] = "2026-10-18 12:00:00.000000 [info] : Client[12] in!\n";
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        buff.Append(line, sizeof(line) - 1);
+        buff.RetrieveAll();
+    }
+    PrintRate("Append+RetrieveAll", ElapsedUs(start), n, n * (sizeof(line) - 1));
+}
+
+// 报文解析模式：整包追加后按行取出
+static void BenchBufferRetrieveLines(int n) {
+    Buffer buff;
+    const std::string request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n"
+                                "Accept: */*\r\nUser-Agent: bench\r\n\r\n";
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        buff.Append(request);
+        while(buff.ReadableBytes() > 0) {
+            const char *end = static_cast<const char *>(memchr(buff.Peek(), '\n', buff.ReadableBytes()));
+            buff.RetrieveUntil(end + 1);
+        }
+    }
+    PrintRate("Append+Retrieve", ElapsedUs(start), n, n * request.size());
+}
+
+// 大响应后复用：缓冲区增长到size后反复重置
+static void BenchBufferGrownReset(int n, size_t size) {
+    Buffer buff;
+    std::string chunk(size, 'x');
+    buff.Append(chunk);
+    buff.RetrieveAll();
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < n; i++) {
+        buff.Append("HTTP/1.1 200 OK\r\n", 17);
+        buff.RetrieveAll();
+    }
+    PrintRate("RetrieveAll(64MB)", ElapsedUs(start), n, n * 17);
+}
+
+// 从socket读取，每次写入size字节后由ReadFd读出
+template <typename BUFFER>
+static void BenchBufferReadFd(const char *name, int n, size_t size) {
+    int fds[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        printf("Buffer ReadFd: socketpair failed, skipped\n");
+        return;
+    }
+    BUFFER buff;
+    std::string data(size, 'x');
+    int err = 0;
+    double us = 0;
+    for(int i = 0; i < n; i++) {
+        if(write(fds[1], data.data(), data.size()) != static_cast<ssize_t>(data.size())) {
+            break;
+        }
+        Clock::time_point start = Clock::now();
+        size_t got = 0;
+        while(got < size) {
+            ssize_t len = buff.ReadFd(fds[0], &err);
+            if(len <= 0) {
+                break;
+            }
+            got += len;
+        }
+        buff.RetrieveAll();
+        us += ElapsedUs(start);
+    }
+    close(fds[0]);
+    close(fds[1]);
+    PrintRate(name, us, n, n * size);
+}
+
+void BenchBuffer() {
+    BenchBufferAppendAll(1000000);
+    BenchBufferRetrieveLines(200000);
+    BenchBufferGrownReset(1000, 64 * 1024 * 1024);
+    BenchBufferReadFd<Buffer>("ReadFd(1KB)", 20000, 1024);
+    BenchBufferReadFd<Buffer>("ReadFd(64KB)", 2000, 64 * 1024);
+    BenchBufferReadFd<ChainBuffer>("Chain ReadFd(1KB)", 20000, 1024);
+    BenchBufferReadFd<ChainBuffer>("Chain ReadFd(64KB)", 2000, 64 * 1024);
+}
+
+int main(int argc, char *argv[]) {
+    // ./bench [redis_host] [redis_port] [redis_pwd]
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? atoi(argv[2]) : 6379;
+    const char *pwd = argc > 3 ? argv[3] : nullptr;
+    BenchBuffer();
+    BenchRandomID(100000);
+    BenchRedisEnroll(host, port, pwd, 10000);
+}
@@ -4,8 +4,37 @@
  * @copyleft Apache 2.0
  */ 
 #include "../code/log/log.h"
+#include "../code/log/accesslog.h"
+#include "../code/cache/sessioncache.h"
+#include "../code/cache/credentialcache.h"
+#include "../code/cache/listcache.h"
+#include "../code/auth/sessiontoken.h"
+#include "../code/auth/sessionstore.h"
+#include "../code/auth/userstore.h"
+#include "../code/auth/randomid.h"
 #include "../code/pool/threadpool.h"
+#include "../code/pool/connpool.h"
+#include "../code/pool/redisasync.h"
+#include "../code/buffer/buffer.h"
+#include "../code/buffer/chainbuffer.h"
+#include "../code/buffer/blockpool.h"
+#include "../code/buffer/arena.h"
+#include "../code/http/httprequest.h"
+#include "../code/http/router.h"
+#include "../code/http/chunked.h"
+#include "../code/http/multipart.h"
+#include "../code/http/bodywriter.h"
+#include "../code/http/httpresponse.h"
+#include <netinet/in.h>
 #include <features.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
 
 #if __GLIBC__ == 2 && __GLIBC_MINOR__ < 30
 #include <sys/syscall.h>
@@ -35,6 +64,46 @@ void TestLog() {
     }
 }
 
+void TestLogRotate() {
+    // 64KB切分，保留3个历史文件并压缩
+    Log::Instance()->Init(0, "./testlog3", ".log", 5000, 64 * 1024, 3, true);
+    for(int j = 0; j < 20000; j++) {
+        LOG_BASE(1, "%s 333333333 %d ============= ", "Test", j);
+    }
+
+    // 保留数跨天统计；重启后接着当天已有的最大序号，不覆盖已压缩的文件
+    assert(system("rm -rf ./testlog4 && mkdir ./testlog4") == 0);
+    time_t now = time(nullptr);
+    struct tm t;
+    localtime_r(&now, &t);
+    char today[32];
+    snprintf(today, sizeof(today), "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+    const std::string dir = "./testlog4/";
+    for(const std::string &name : {std::string("2000_01_01.log"), std::string("2000_01_01-1.log.gz"),
+                                   std::string("2000_01_02-3.log"), std::string("access.log"),
+                                   std::string(today) + "-5.log.gz"}) {
+        FILE *fp = fopen((dir + name).c_str(), "w");
+        fputs("old", fp);
+        fclose(fp);
+    }
+    Log::Instance()->Init(0, "./testlog4", ".log", 5000, 64 * 1024, 3, true);
+    for(int j = 0; j < 5000; j++) {
+        LOG_BASE(1, "%s 444444444 %d ============= ", "Test", j);
+    }
+    Log::Instance()->flush();
+    struct stat st;
+    bool pruned = false;
+    for(int i = 0; i < 200 && !pruned; i++) { // 压缩与删除在后台线程中完成
+        usleep(10000);
+        pruned = stat((dir + "2000_01_02-3.log").c_str(), &st) != 0;
+    }
+    assert(pruned && stat((dir + "2000_01_01.log").c_str(), &st) != 0);
+    assert(stat((dir + "access.log").c_str(), &st) == 0);
+    assert(stat((dir + today + "-6.log").c_str(), &st) != 0 || stat((dir + today + "-6.log.gz").c_str(), &st) == 0);
+    assert(stat((dir + today + ".log").c_str(), &st) != 0); // 从序号6开始写入
+    Log::Instance()->Init(0, "./testlog3", ".log", 5000, 64 * 1024, 3, true);
+}
+
 void ThreadLogTask(int i, int cnt) {
     for(int j = 0; j < 10000; j++ ){
         LOG_BASE(i,"PID:[%04d]======= %05d ========= ", gettid(), cnt++);
@@ -50,7 +119,1071 @@ void TestThreadPool() {
     getchar();
 }
 
+void TestAccessLog() {
+    AccessRecord rec;
+    rec.clientIP = "127.0.0.1";
+    rec.method = "GET";
+    rec.path = "/index.html";
+    rec.version = "1.1";
+    rec.userAgent = "Test \"agent\"";
+    rec.status = 200;
+    rec.upstreamUs = 0;
+    for(int format = 0; format < 3; format++) {
+        AccessLog::Instance()->Init("./testaccess", "access.log", format, 4096);
+        for(int i = 0; i < 10000; i++) {
+            rec.bytesSent = i;
+            rec.latencyUs = i * 10;
+            AccessLog::Instance()->Append(rec);
+        }
+        AccessLog::Instance()->Close();
+    }
+
+    // 客户端提供的字段不能破坏行结构或伪造字段
+    assert(system("rm -rf ./testaccess2") == 0);
+    rec.path = "/a\"b\n127.0.0.1 - - [x] \"GET /";
+    rec.version = "1.1\",\"status\":999,\"x\":\"";
+    rec.userAgent = "ua\\\"\r\n";
+    for(int format = 1; format < 3; format++) {
+        AccessLog::Instance()->Init("./testaccess2", "access.log", format, 4096);
+        AccessLog::Instance()->Append(rec);
+        AccessLog::Instance()->Close();
+    }
+    FILE *fp = fopen("./testaccess2/access.log", "r");
+    char line[4096];
+    std::vector<std::string> lines;
+    while(fgets(line, sizeof(line), fp)) {
+        lines.push_back(line);
+    }
+    fclose(fp);
+    assert(lines.size() == 2);
+    assert(lines[0].find("/a\\x22b\\x0A127.0.0.1") != std::string::npos);
+    assert(lines[0].find("HTTP/1.1\\x22,\\x22status") != std::string::npos);
+    assert(lines[0].find("\"ua\\x5C\\x22\\x0D\\x0A\"") != std::string::npos);
+    assert(lines[1].find("\"version\":\"1.1\\\",\\\"status\\\":999") != std::string::npos);
+    assert(lines[1].find("\"status\":200") != std::string::npos);
+}
+
+void TestBuffer() {
+    Buffer buff(8);
+    buff.Append("hello world", 11); // 扩容
+    assert(buff.ReadableBytes() == 11);
+    buff.Retrieve(6);
+    assert(std::string(buff.Peek(), buff.ReadableBytes()) == "world");
+    buff.RetrieveAll();
+    assert(buff.ReadableBytes() == 0 && buff.PrependableBytes() == 0);
+    buff.Append("abc", 3); // 重置后覆盖旧数据
+    assert(buff.RetrieveAllToStr() == "abc");
+    buff.Append(std::string(4, 'x'));
+    buff.Retrieve(2);
+    buff.Append("yyyyyyyyyy", 10); // 前移已读空间或扩容
+    assert(buff.RetrieveAllToStr() == "xxyyyyyyyyyy");
+}
+
+void TestChainBuffer() {
+    size_t inUse = BlockPool::Instance()->InUseBytes();
+    ChainBuffer buff;
+    buff.Append(std::string(991, 'a')); // 首块数据区为1KB减去块头
+    buff.Append("\r\nline2\r\n");     // CRLF跨越块边界
+    assert(buff.ReadableBytes() == 1000 && buff.BlockCount() == 2);
+    size_t pos = buff.Find("\r\n", 2);
+    assert(pos == 991);
+    assert(buff.RetrieveToStr(pos) == std::string(991, 'a'));
+    buff.Retrieve(2);
+    assert(buff.Find("\r\n", 2) == 5);
+    assert(buff.Find("\r\nx", 3) == ChainBuffer::npos);
+    assert(buff.RetrieveAllToStr() == "line2\r\n");
+    assert(buff.BlockCount() == 0);
+    assert(BlockPool::Instance()->InUseBytes() == inUse); // 取完即归还
+
+    const size_t block = BlockPool::MAX_BLOCK;
+    // Linearize：跨块数据合并为连续内存
+    buff.Append(std::string(block * 2, 'b'));
+    buff.Append("cd", 2);
+    const char *p = buff.Linearize(block * 2 + 2);
+    assert(p[0] == 'b' && p[block * 2] == 'c' && p[block * 2 + 1] == 'd');
+    assert(buff.PeekBytes() == block * 2 + 2);
+
+    // 整块移动，不拷贝数据
+    ChainBuffer other;
+    other.Append("tail", 4);
+    buff.Append(other);
+    assert(other.ReadableBytes() == 0 && other.BlockCount() == 0);
+    buff.Append("!", 1);
+    buff.Retrieve(block * 2 + 2);
+    assert(buff.RetrieveAllToStr() == "tail!");
+
+    // readv/writev
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    std::string payload;
+    for(int i = 0; i < 100000; i++) {
+        payload += static_cast<char>('a' + i % 26);
+    }
+    ChainBuffer out, in;
+    out.Append(payload);
+    int err = 0;
+    while(out.ReadableBytes() > 0 || in.ReadableBytes() < payload.size()) {
+        if(out.ReadableBytes() > 0) {
+            assert(out.WriteFd(fds[1], &err) > 0);
+        }
+        assert(in.ReadFd(fds[0], &err) > 0);
+    }
+    assert(in.RetrieveAllToStr() == payload);
+    close(fds[0]);
+    close(fds[1]);
+    assert(BlockPool::Instance()->InUseBytes() == inUse);
+}
+
+void TestBlockPool() {
+    BlockPool *pool = BlockPool::Instance();
+    size_t cap = 0;
+    void *small = pool->Alloc(100, cap);
+    assert(cap == 1024);
+    void *big = pool->Alloc(BlockPool::MAX_BLOCK + 1, cap);
+    assert(cap == BlockPool::MAX_BLOCK + 1);
+    pool->Free(big, cap);
+    pool->Free(small, 1024);
+    assert(pool->Alloc(1000, cap) == small); // 线程缓存复用
+    pool->Free(small, cap);
+
+    // 其他线程释放的块进入全局池后可被再次取用
+    std::vector<void *> blocks;
+    std::thread([&blocks, pool] {
+        size_t c = 0;
+        for(int i = 0; i < 64; i++) {
+            blocks.push_back(pool->Alloc(16 * 1024, c));
+        }
+        for(void *p : blocks) {
+            pool->Free(p, c);
+        }
+    }).join();
+    size_t cached = pool->CachedBytes();
+    assert(cached >= 64 * 16 * 1024);
+    std::thread([&blocks, pool] {
+        size_t c = 0;
+        void *p = pool->Alloc(16 * 1024, c);
+        assert(std::find(blocks.begin(), blocks.end(), p) != blocks.end());
+        pool->Free(p, c);
+    }).join();
+}
+
+void TestArena() {
+    size_t inUse = BlockPool::Instance()->InUseBytes();
+    {
+        Arena arena;
+        StrSpan a = arena.Copy("Content-Type", 12);
+        assert(a.Equals("Content-Type") && a.EqualsNoCase("content-type") && !a.Equals("content-type"));
+        arena.Alloc(8 * 1024); // 超过块大小时单独分配
+        StrSpan b = arena.Copy("abc", 3);
+        assert(a.str() == "Content-Type" && b.str() == "abc"); // 新块不影响已有数据
+        arena.Reset();
+        assert(arena.Used() == 0 && BlockPool::Instance()->InUseBytes() == inUse);
+    }
+
+    // 请求行与头部解析
+    HttpRequest req;
+    ChainBuffer buff;
+    for(int i = 0; i < 2; i++) { // 第二轮验证Init后的状态复用
+        req.Init("./resources", "./data");
+        buff.Append("GET /index?a=1%202&b=x+y&a=3 HTTP/1.1\r\n"
+                    "Host: localhost\r\n"
+                    "connection: Keep-Alive\r\n"
+                    "User-Agent:curl\r\n\r\n");
+        assert(req.parse(buff) == HttpRequest::GET_REQUEST);
+        assert(req.State() == HttpRequest::FINISH);
+        assert(req.path() == "/index.html" && req.url() == "/index?a=1%202&b=x+y&a=3" && req.version() == "1.1");
+        assert(req.GetHeader("Connection") == "Keep-Alive" && req.GetHeader("user-agent") == "curl");
+        assert(req.GetHeader("Cookie") == "" && req.IsKeepAlive());
+        assert(req.GetHeader(HttpRequest::HDR_HOST) == "localhost" && req.GetHeader("HOST") == "localhost");
+        assert(req.reqRes() == "./resources/index.html");
+    }
+    // 小写的常用头部与未识别头部
+    req.Init("./resources", "./data");
+    buff.Append("GET / HTTP/1.1\r\ncontent-type: text/plain\r\nX-Trace-Id: 42\r\nCONNECTION: close\r\n\r\n");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && !req.IsKeepAlive());
+    assert(req.GetHeader(HttpRequest::HDR_CONTENT_TYPE) == "text/plain" && req.GetHeader("x-trace-id") == "42");
+    assert(req.GetHeader(HttpRequest::HDR_HOST) == "" && req.GetHeader("X-Not-Sent") == "");
+
+    req.Init("./resources", "./data");
+    buff.Append("GET /index  HTTP/1.1\r\n\r\n");
+    assert(req.parse(buff) == HttpRequest::BAD_REQUEST);
+    req.Release();
+    buff.RetrieveAll();
+    assert(BlockPool::Instance()->InUseBytes() == inUse);
+}
+
+void TestRouter() {
+    Router<int> empty({});
+    assert(empty.Find(1, "/", 1) == nullptr);
+
+    Router<int> router({
+        {1, "/login", 10, 0},
+        {2, "/login", 20, 4},
+        {1, "/", 30, 0},
+    });
+    assert(router.Find(1, "/login", 6)->handler == 10);
+    assert(router.Find(2, "/login", 6)->handler == 20 && router.Find(2, "/login", 6)->flags == 4);
+    assert(router.Find(3, "/login", 6) == nullptr);
+    assert(router.Find(1, "/login", 5) == nullptr && router.Find(1, "/logout", 7) == nullptr);
+    assert(router.Find(1, "/", 1)->handler == 30 && router.Find(1, "", 0) == nullptr);
+
+    // 路由表中的处理对象
+    HttpRequest req;
+    ChainBuffer buff;
+    req.Init("./resources", "./data");
+    buff.Append("GET /user HTTP/1.1\r\n\r\n"); // 别名改写后命中路由，无session按匿名处理
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && req.reqRes() == "./resources/user.html");
+    assert(req.authState() == HttpRequest::AUTH_ANON && req.IsBlocking()); // 响应需要读取页面文件
+    req.Init("./resources", "./data");
+    buff.Append("GET /userinfo HTTP/1.1\r\n\r\n");
+    assert(req.parse(buff) == HttpRequest::UNAUTH_REQUEST && !req.IsBlocking());
+    req.Init("./resources", "./data");
+    buff.Append("GET /fileslist HTTP/1.1\r\n\r\n");
+    assert(req.parse(buff) == HttpRequest::UNAUTH_REQUEST && req.IsBlocking());
+    req.Init("./resources", "./data");
+    buff.Append("GET /login HTTP/1.1\r\n\r\n"); // 仅注册了POST
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && req.reqRes() == "./resources/login");
+    req.Init("./resources", "./data");
+    buff.Append("DELETE /index.html HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc");
+    assert(req.parse(buff) == HttpRequest::METHOD_NOT_ALLOWED && req.reqRes() == "{\"err\":405}");
+    assert(buff.ReadableBytes() == 3); // 消息体未读取
+    buff.RetrieveAll();
+}
+
+void TestChunked() {
+    const std::string body = "5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\nGET";
+    // 逐字节送入，验证跨块与不完整的分帧
+    ChunkedDecoder decoder;
+    decoder.Reset(16, 1024);
+    ChainBuffer buff;
+    std::string out;
+    ChunkedDecoder::STATUS st = ChunkedDecoder::NEED_MORE;
+    for(size_t i = 0; i < body.size() && st != ChunkedDecoder::DONE; i++) {
+        buff.Append(body.data() + i, 1);
+        size_t len = 0;
+        while((st = decoder.Next(buff, len)) == ChunkedDecoder::DATA) {
+            out.append(buff.Peek(), len);
+            buff.Retrieve(len);
+        }
+        assert(st != ChunkedDecoder::ERROR);
+    }
+    assert(st == ChunkedDecoder::DONE && out == "hello world" && decoder.BodyBytes() == 11);
+    assert(buff.ReadableBytes() == 0);
+
+    // 一次送入，之后的数据留给下一个请求
+    decoder.Reset(16, 1024);
+    buff.Append(body);
+    out.clear();
+    size_t n = 0;
+    while((st = decoder.Next(buff, n)) == ChunkedDecoder::DATA) {
+        out.append(buff.Peek(), n);
+        buff.Retrieve(n);
+    }
+    assert(st == ChunkedDecoder::DONE && out == "hello world" && buff.RetrieveAllToStr() == "GET");
+
+    size_t len = 0;
+    const char *bad[] = {"11\r\n", "zz\r\n", "1\r\nabc\r\n", "ffffffffffffffffff\r\n"};
+    for(const char *b : bad) {
+        decoder.Reset(16, 1024);
+        buff.Append(b, strlen(b));
+        while((st = decoder.Next(buff, len)) == ChunkedDecoder::DATA) {
+            buff.Retrieve(len);
+        }
+        assert(st == ChunkedDecoder::ERROR);
+        buff.RetrieveAll();
+    }
+}
+
+class RecordListener : public MultipartParser::Listener {
+public:
+    void OnPartBegin(const MultipartParser::Part &part) override {
+        parts.push_back(part.name + "|" + part.filename + "|" + part.contentType + "|");
+    }
+    void OnPartData(const char *data, size_t len) override {
+        parts.back().append(data, len);
+    }
+    void OnPartEnd() override {
+        parts.back() += "$";
+    }
+    std::vector<std::string> parts;
+};
+
+// 统计直接取自调用方缓冲区的文件内容字节数
+class DirectListener : public MultipartParser::Listener {
+public:
+    void OnPartBegin(const MultipartParser::Part &) override {}
+    void OnPartData(const char *data, size_t len) override {
+        total += len;
+        if(data >= begin && data + len <= end) {
+            direct += len;
+        }
+    }
+    void OnPartEnd() override {}
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    size_t total = 0;
+    size_t direct = 0;
+};
+
+void TestMultipart() {
+    assert(MultipartParser::GetBoundary("multipart/form-data; boundary=\"ab\"; x=1") == "ab");
+    const std::string body = "preamble\r\n--xyz\r\n"
+                             "Content-Disposition: form-data; name=\"k\"\r\n\r\n"
+                             "v\r\n--xyz\r\n"
+                             "content-disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                             "Content-Type: text/plain\r\n\r\n"
+                             "line1\r\n--xy\r\nline2\r\n\r\n--xyz\r\n"
+                             "Content-Disposition: form-data; name=\"empty\"\r\n\r\n"
+                             "\r\n--xyz--\r\nepilogue";
+    const std::vector<std::string> expect = {"k|||v$", "file|a.txt|text/plain|line1\r\n--xy\r\nline2\r\n$", "empty|||$"};
+    for(size_t step : {body.size(), (size_t)1, (size_t)7}) {
+        MultipartParser parser;
+        RecordListener listener;
+        parser.Reset("xyz", &listener);
+        for(size_t i = 0; i < body.size(); i += step) {
+            assert(parser.Feed(body.data() + i, std::min(step, body.size() - i)));
+        }
+        assert(parser.Finished());
+        assert(listener.parts == expect); // 文件内容不含分隔符前的CRLF
+    }
+
+    MultipartParser parser;
+    RecordListener listener;
+    parser.Reset("xyz", &listener);
+    const std::string bad = "--xyz\r\nno-colon\r\n\r\n";
+    assert(!parser.Feed(bad.data(), bad.size()) && !parser.Finished());
+
+    // 分多次送入时只拼接上次的尾部，其余内容不经拷贝交给Listener
+    const std::string big = "--xyz\r\nContent-Disposition: form-data; name=\"f\"\r\n\r\n" +
+                            std::string(64 * 1024, 'd') + "\r\n--xyz--\r\n";
+    DirectListener direct;
+    parser.Reset("xyz", &direct);
+    const size_t step = 4096;
+    for(size_t i = 0; i < big.size(); i += step) {
+        direct.begin = big.data() + i;
+        direct.end = direct.begin + std::min(step, big.size() - i);
+        assert(parser.Feed(direct.begin, direct.end - direct.begin));
+    }
+    assert(parser.Finished() && direct.total == 64 * 1024);
+    assert(direct.direct > direct.total * 9 / 10);
+}
+
+void TestUploadSplice() {
+    char dir[] = "/tmp/testspliceXXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    const std::string path = std::string(dir) + "/";
+    std::string data(300 * 1024, 'x');
+    for(size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    // 已在读缓冲区中的前缀经Write写入，其余经管道splice
+    UploadSink sink;
+    sink.Open(path, data.size());
+    assert(!sink.OpenFile(".hidden") && !sink.CanSplice());
+    sink.Open(path, data.size());
+    assert(sink.OpenFile("raw.bin") && sink.CanSplice());
+    const size_t prefix = 1000;
+    sink.Write(data.data(), prefix);
+    std::thread writer([&] {
+        assert(write(fds[1], data.data() + prefix, data.size() - prefix) == (ssize_t)(data.size() - prefix));
+    });
+    size_t left = data.size() - prefix;
+    while(left > 0) {
+        int err = 0;
+        ssize_t n = sink.Splice(fds[0], left, &err);
+        assert(n > 0 || (n < 0 && err == EAGAIN));
+        left -= n > 0 ? n : 0;
+    }
+    writer.join();
+    sink.Commit();
+    assert(sink.Error() == 0 && sink.Saved() && sink.FileSize() == data.size());
+    FILE *fp = fopen((path + "raw.bin").c_str(), "r");
+    std::string saved(data.size() + 1, '\0');
+    assert(fread(&saved[0], 1, saved.size(), fp) == data.size());
+    fclose(fp);
+    saved.resize(data.size());
+    assert(saved == data);
+
+    // 预分配的长度大于实际内容时截掉多余部分
+    sink.Open(path, 4096);
+    assert(sink.OpenFile("short.bin"));
+    sink.Write("abc", 3);
+    sink.Commit();
+    struct stat st;
+    assert(stat((path + "short.bin").c_str(), &st) == 0 && st.st_size == 3);
+    close(fds[0]);
+    close(fds[1]);
+    assert(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+}
+
+void TestUploadSession() {
+    char dir[] = "/tmp/testsessionXXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    const std::string path = std::string(dir) + "/bob/";
+    SessionStore::Init(SessionStore::BACKEND_MEMORY);
+    UploadSessions *sessions = UploadSessions::Instance();
+    sessions->Init(3600, true);
+    int err = 0;
+    assert(!sessions->Create("bob", path, "../x", 100, 0, err) && err == 400);
+    assert(!sessions->Create("bob", path, "a.bin", 100, 1024, err) && err == 400); // 块过小
+
+    const size_t chunk = UploadSessions::MIN_CHUNK_SIZE, size = chunk * 3 + 100;
+    std::string data(size, '\0');
+    for(size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    UploadSessions::SessionPtr session = sessions->Create("bob", path, "a.bin", size, chunk, err);
+    assert(session && err == 0 && session->Chunks() == 4 && session->ChunkLen(3) == 100);
+    assert(sessions->Find(session->Id(), "alice") == nullptr);
+    assert(sessions->Find(session->Id(), "bob") == session);
+    assert(session->BeginChunk(4, 100) == 400 && session->BeginChunk(0, 100) == 400);
+
+    // 各块并发写入，第2块中途失败后可重传
+    std::vector<std::thread> writers;
+    for(size_t i : {0, 2, 3}) {
+        assert(session->BeginChunk(i, session->ChunkLen(i)) == 0);
+        writers.emplace_back([&, i] {
+            assert(session->Write(i, 0, data.data() + i * chunk, session->ChunkLen(i)));
+            session->EndChunk(i, true);
+        });
+    }
+    assert(session->BeginChunk(1, chunk) == 0 && session->BeginChunk(1, chunk) == 409);
+    session->EndChunk(1, false);
+    for(auto &t : writers) {
+        t.join();
+    }
+    assert(session->Missing() == std::vector<size_t>{1});
+    size_t fileSize = 0;
+    time_t uploadDate = 0;
+    assert(session->Commit(fileSize, uploadDate) == 409);
+
+    // 重启后从存储恢复，已完成的块不必重传
+    std::string saved;
+    assert(SessionStore::Instance()->Get("upload:" + session->Id(), saved) == STORE_OK);
+    UploadSessions::SessionPtr restored = UploadSession::Restore(session->Id(), saved);
+    assert(restored && restored->Open(false) && restored->Missing() == std::vector<size_t>{1});
+    assert(restored->BeginChunk(1, chunk) == 0);
+    assert(restored->Write(1, 0, data.data() + chunk, 1000) && restored->Write(1, 1000, data.data() + chunk + 1000, chunk - 1000));
+    restored->EndChunk(1, true);
+    assert(restored->Commit(fileSize, uploadDate) == 0 && fileSize == size);
+    assert(restored->Commit(fileSize, uploadDate) == 410);
+    sessions->Remove(session->Id());
+    assert(sessions->Find(session->Id(), "bob") == nullptr);
+
+    FILE *fp = fopen((path + "a.bin").c_str(), "r");
+    std::string content(size + 1, '\0');
+    assert(fread(&content[0], 1, content.size(), fp) == size);
+    fclose(fp);
+    content.resize(size);
+    assert(content == data);
+    assert(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+}
+
+static std::string WriteTemp(const std::string &path, const std::string &content) {
+    FILE *fp = fopen(path.c_str(), "w");
+    fwrite(content.data(), 1, content.size(), fp);
+    fclose(fp);
+    Sha256 hash;
+    hash.Update(content.data(), content.size());
+    return hash.HexDigest();
+}
+
+void TestObjectStore() {
+    Sha256 abc;
+    abc.Update("ab", 2);
+    abc.Update("c", 1);
+    assert(abc.HexDigest() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    char dir[] = "/tmp/testobjectsXXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    const std::string root = dir;
+    mkdir((root + "/a").c_str(), 0777);
+    mkdir((root + "/b").c_str(), 0777);
+    ObjectStore *store = ObjectStore::Instance();
+    store->Init(root, true);
+    fclose(fopen((root + "/.objects/orphan").c_str(), "w"));
+    assert(store->Collect() == 1);
+
+    // 相同内容只保存一份，用户文件与对象是同一inode
+    std::string digest = WriteTemp(root + "/a/.1.part", "same content");
+    assert(store->Commit(root + "/a/.1.part", digest, root + "/a/x"));
+    assert(WriteTemp(root + "/b/.2.part", "same content") == digest);
+    assert(store->Commit(root + "/b/.2.part", digest, root + "/b/y"));
+    struct stat obj, x, y;
+    assert(stat((root + "/.objects/" + digest).c_str(), &obj) == 0 && obj.st_nlink == 3);
+    assert(stat((root + "/a/x").c_str(), &x) == 0 && stat((root + "/b/y").c_str(), &y) == 0);
+    assert(x.st_ino == obj.st_ino && y.st_ino == obj.st_ino);
+
+    // 重复上传同名同内容，不留下临时链接
+    WriteTemp(root + "/a/.4.part", "same content");
+    assert(store->Commit(root + "/a/.4.part", digest, root + "/a/x"));
+    assert(stat((root + "/.objects/" + digest).c_str(), &obj) == 0 && obj.st_nlink == 3);
+    assert(access((root + "/a/.4.part.link").c_str(), F_OK) != 0 && access((root + "/a/.4.part").c_str(), F_OK) != 0);
+
+    // 覆盖为其他内容后旧对象仍被b/y引用；删除最后一个引用时删除对象
+    std::string other = WriteTemp(root + "/a/.5.part", "other content");
+    assert(store->Commit(root + "/a/.5.part", other, root + "/a/x"));
+    assert(stat((root + "/.objects/" + digest).c_str(), &obj) == 0 && obj.st_nlink == 2);
+    assert(store->Remove(root + "/b/y"));
+    assert(access((root + "/.objects/" + digest).c_str(), F_OK) != 0);
+    assert(store->Remove(root + "/a/x"));
+    assert(access((root + "/.objects/" + other).c_str(), F_OK) != 0);
+    assert(!store->Remove(root + "/a/x"));
+
+    store->Init(root, false);
+    assert(!store->IsOpen());
+    assert(system(("rm -rf " + root).c_str()) == 0);
+}
+
+void TestBodyWriter() {
+    char dir[] = "/tmp/testlistXXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    const std::string path = std::string(dir) + "/";
+    const int files = 500; // 超过一段的大小
+    for(int i = 0; i < files; i++) {
+        FILE *fp = fopen((path + "file\"" + std::to_string(i)).c_str(), "w");
+        fputs("x", fp);
+        fclose(fp);
+    }
+    fclose(fopen((path + ".hidden.part").c_str(), "w"));
+
+    // chunked响应：逐段生成后用ChunkedDecoder还原
+    HttpResponse response;
+    std::string reqRes, authInfo, resDir = "./resources";
+    response.Init(HttpRequest::GET_INFO, reqRes, HttpRequest::AUTH_PASS, authInfo, resDir, true, 200);
+    response.SetBodyWriter(std::unique_ptr<BodyWriter>(new DirListWriter(path)), true);
+    ChainBuffer buff;
+    response.MakeResponse(buff);
+    int segments = 1;
+    while(response.Streaming()) {
+        response.ProduceBody(buff);
+        segments++;
+    }
+    assert(segments > 2);
+    size_t headEnd = buff.Find("\r\n\r\n", 4);
+    std::string head = buff.RetrieveToStr(headEnd + 4);
+    assert(head.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+    assert(head.find("Content-Length") == std::string::npos);
+    ChunkedDecoder decoder;
+    decoder.Reset(BodyWriter::SEGMENT_SIZE * 2, 1 << 30);
+    std::string body;
+    size_t len = 0;
+    ChunkedDecoder::STATUS st;
+    while((st = decoder.Next(buff, len)) == ChunkedDecoder::DATA) {
+        body += buff.RetrieveToStr(len);
+    }
+    assert(st == ChunkedDecoder::DONE && buff.ReadableBytes() == 0);
+    nlohmann::json list = nlohmann::json::parse(body);
+    assert(list.is_array() && list.size() == files);
+    std::unordered_set<std::string> names;
+    for(auto &item : list) {
+        assert(item["fileSize"] == 1);
+        names.insert(item["fileName"].get<std::string>());
+    }
+    assert(names.size() == files && names.count("file\"0") && !names.count(".hidden.part"));
+
+    // HTTP/1.0：一次生成，带Content-Length
+    response.Init(HttpRequest::GET_INFO, reqRes, HttpRequest::AUTH_PASS, authInfo, resDir, false, 200);
+    response.SetBodyWriter(std::unique_ptr<BodyWriter>(new DirListWriter(path)), false);
+    response.MakeResponse(buff);
+    assert(!response.Streaming());
+    head = buff.RetrieveToStr(buff.Find("\r\n\r\n", 4) + 4);
+    assert(head.find("Content-Length: " + std::to_string(buff.ReadableBytes()) + "\r\n") != std::string::npos);
+    assert(nlohmann::json::parse(buff.RetrieveAllToStr()) == list);
+
+    // 空目录
+    std::string empty = path + "empty/";
+    DirListWriter writer(empty);
+    assert(!writer.Next(buff) && buff.RetrieveAllToStr() == "[]");
+    assert(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+}
+
+void TestSessionCache() {
+    SessionCache *cache = SessionCache::Instance();
+    cache->Init(1000, 100, 1024);
+    std::string user;
+    assert(cache->Lookup("sid1", user) == SessionCache::MISS);
+    cache->Insert("sid1", true, "admin");
+    cache->Insert("sid2", false, "");
+    assert(cache->Lookup("sid1", user) == SessionCache::VALID && user == "admin");
+    assert(cache->Lookup("sid2", user) == SessionCache::INVALID);
+    cache->Invalidate("sid1");
+    assert(cache->Lookup("sid1", user) == SessionCache::MISS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    assert(cache->Lookup("sid2", user) == SessionCache::MISS); // 失败结果已过期
+    for(int i = 0; i < 4096; i++) {
+        cache->Insert("sid" + std::to_string(i), true, "user");
+    }
+    assert(cache->Size() <= 1024);
+    printf("SessionCache hit ratio: %.2f\n", cache->HitRatio());
+
+    // session使用独立的key，上传会话等记录的key与旧格式的session_id都不能通过验证
+    SessionStore::Init(SessionStore::BACKEND_MEMORY);
+    const std::string sid = RandomID::Generate(), raw = RandomID::Generate();
+    assert(SessionStore::Instance()->Create(SessionStore::SessionKey(sid), "admin", 60) == STORE_OK);
+    assert(SessionStore::Instance()->Set("upload:" + sid, "{\"user\":\"admin\"}", 60) == STORE_OK);
+    assert(SessionStore::Instance()->Create(raw, "admin", 60) == STORE_OK);
+    HttpRequest req;
+    ChainBuffer buff;
+    for(const std::string &bad : {"upload:" + sid, raw, std::string("../admin")}) {
+        req.Init("./resources", "./data");
+        buff.Append("GET /userinfo HTTP/1.1\r\nCookie: session_id=" + bad + "\r\n\r\n");
+        req.parse(buff);
+        assert(req.authState() == HttpRequest::AUTH_FAIL);
+    }
+    req.Init("./resources", "./data");
+    buff.Append("GET /userinfo HTTP/1.1\r\nCookie: session_id=" + sid + "\r\n\r\n");
+    req.parse(buff);
+    assert(req.authState() == HttpRequest::AUTH_PASS);
+}
+
+void TestCredentialCache() {
+    CredentialCache *cache = CredentialCache::Instance();
+    assert(cache->Lookup("admin", "123") == CredentialCache::MISS); // 未开启
+    cache->Init(60 * 1000, 1024);
+    assert(cache->Lookup("admin", "123") == CredentialCache::MISS);
+    cache->Insert("admin", "123");
+    assert(cache->Lookup("admin", "123") == CredentialCache::MATCH);
+    assert(cache->Lookup("admin", "1234") == CredentialCache::MISMATCH);
+    cache->Invalidate("admin");
+    assert(cache->Lookup("admin", "123") == CredentialCache::MISS);
+
+    // 缓存的密码在外部被修改：不一致时以用户存储为准，成功后更新摘要
+    UserStore::Init(UserStore::BACKEND_MEMORY);
+    SessionStore::Init(SessionStore::BACKEND_MEMORY);
+    assert(UserStore::Instance()->Register("carol", "new") == STORE_OK);
+    cache->Insert("carol", "old");
+    HttpRequest req;
+    ChainBuffer buff;
+    req.Init("./resources", "./data");
+    buff.Append("POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                "Content-Length: 27\r\n\r\nusername=carol&password=new");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && req.authState() == HttpRequest::AUTH_SET);
+    assert(cache->Lookup("carol", "new") == CredentialCache::MATCH);
+    req.Init("./resources", "./data");
+    buff.Append("POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                "Content-Length: 27\r\n\r\nusername=carol&password=old");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && req.authState() != HttpRequest::AUTH_SET);
+}
+
+// 用固定的目录mtime模拟带外修改，避免时间戳精度影响结果
+static void TouchDir(const std::string &dir, time_t sec) {
+    struct timespec times[2] = {{sec, 0}, {sec, 0}};
+    assert(utimensat(AT_FDCWD, dir.c_str(), times, 0) == 0);
+}
+
+void TestListCache() {
+    ListCache *cache = ListCache::Instance();
+    char tmp[] = "/tmp/testlistcacheXXXXXX";
+    assert(mkdtemp(tmp) != nullptr);
+    const std::string dir = std::string(tmp) + "/user/";
+    assert(!cache->Get(dir)); // 未开启
+    cache->Init(60 * 1000, 16);
+    assert(*cache->Get(dir) == "[]"); // 目录不存在时创建
+
+    fclose(fopen((dir + "b").c_str(), "w"));
+    fclose(fopen((dir + "a").c_str(), "w"));
+    fclose(fopen((dir + ".x.part").c_str(), "w"));
+    TouchDir(dir, 1000);
+    ListCache::Listing first = cache->Get(dir);
+    nlohmann::json list = nlohmann::json::parse(*first);
+    assert(list.size() == 2 && list[0]["fileName"] == "a" && list[1]["fileName"] == "b");
+    unsigned long long hits = cache->Hits();
+    assert(cache->Get(dir) == first && cache->Hits() == hits + 1); // 同一份序列化结果
+
+    // 增量更新不重新扫描目录：c并不存在于磁盘
+    cache->Update(dir, "c", 5, 123);
+    cache->Remove(dir, "a");
+    list = nlohmann::json::parse(*cache->Get(dir));
+    assert(cache->Hits() == hits + 2);
+    assert(list.size() == 2 && list[0]["fileName"] == "b" && list[1]["fileName"] == "c");
+    assert(list[1]["fileSize"] == 5 && list[1]["uploadDate"] == 123);
+
+    // 目录mtime变化后重新扫描
+    fclose(fopen((dir + "d").c_str(), "w"));
+    TouchDir(dir, 2000);
+    list = nlohmann::json::parse(*cache->Get(dir));
+    assert(list.size() == 3 && list[2]["fileName"] == "d");
+    assert(cache->Size() == 1);
+    assert(system(("rm -rf " + std::string(tmp)).c_str()) == 0);
+}
+
+void TestSessionToken() {
+    SessionToken *token = SessionToken::Instance();
+    token->Init("test-key", false);
+    std::string user;
+    std::string t = token->Issue("admin", 60);
+    assert(token->Verify(t, user) == STORE_OK && user == "admin");
+    std::string forged = t;
+    forged[0] = forged[0] == '9' ? '8' : '9'; // 篡改过期时间
+    assert(token->Verify(forged, user) == STORE_FAIL);
+    assert(token->Verify(token->Issue("admin", -1), user) == STORE_FAIL); // 已过期
+    assert(token->Verify("a.b.c", user) == STORE_FAIL);
+}
+
+void TestMemStore() {
+    MemUserStore users;
+    assert(users.Verify("admin", "123") == STORE_FAIL);
+    assert(users.Register("admin", "123") == STORE_OK);
+    assert(users.Register("admin", "456") == STORE_FAIL); // 用户名已被使用
+    assert(users.Verify("admin", "123") == STORE_OK);
+    assert(users.Verify("admin", "456") == STORE_FAIL);
+
+    MemSessionStore sessions;
+    std::string user;
+    assert(sessions.Create("sid", "admin", 60) == STORE_OK);
+    assert(sessions.Create("sid", "other", 60) == STORE_FAIL); // NX
+    assert(sessions.Get("sid", user) == STORE_OK && user == "admin");
+    assert(sessions.Remove("sid") == STORE_OK);
+    assert(sessions.Get("sid", user) == STORE_FAIL);
+    assert(sessions.Create("expired", "admin", 0) == STORE_OK);
+    assert(sessions.Get("expired", user) == STORE_FAIL);
+    assert(sessions.Create("expired", "admin", 60) == STORE_OK); // 过期后可重新创建
+    for(int i = 0; i < 100000; i++) { // 触发分片清理
+        assert(sessions.Create("s" + std::to_string(i), "admin", 0) == STORE_OK);
+    }
+    assert(sessions.Get("expired", user) == STORE_OK);
+
+    // token吊销记录写入进程内存储
+    SessionStore::Init(SessionStore::BACKEND_MEMORY);
+    SessionToken *token = SessionToken::Instance();
+    token->Init("test-key", true);
+    std::string t = token->Issue("admin", 60);
+    assert(token->Verify(t, user) == STORE_OK);
+    assert(token->Revoke(t) == STORE_OK);
+    assert(token->Revoke(t) == STORE_OK); // 重复登出
+    assert(token->Verify(t, user) == STORE_FAIL);
+    token->Init("test-key", false);
+}
+
+void TestFileIoDefer() {
+    char dir[] = "/tmp/testdeferXXXXXX";
+    assert(mkdtemp(dir) != nullptr);
+    assert(mkdir((std::string(dir) + "/bob").c_str(), 0777) == 0);
+    SessionToken *token = SessionToken::Instance();
+    token->Init("test-key", false);
+    const std::string cookie = "Cookie: session_id=" + token->Issue("bob", 60) + "\r\n";
+    HttpRequest::deferDisk = true;
+    HttpRequest req;
+    ChainBuffer buff;
+
+    // 鉴权后挂起，Resume时不再鉴权，直接执行处理函数
+    req.Init("./resources", dir);
+    buff.Append("GET /download?file=a.txt HTTP/1.1\r\n" + cookie + "\r\n");
+    assert(req.parse(buff) == HttpRequest::PENDING_REQUEST && req.IsDiskWait() && !req.IsDiskBound());
+    assert(req.State() != HttpRequest::FINISH);
+    assert(req.Resume(buff) == HttpRequest::GET_REQUEST && !req.IsDiskWait() && req.IsDiskBound());
+    assert(req.reqType() == HttpRequest::GET_FILE && req.reqRes() == std::string(dir) + "/bob/a.txt");
+
+    // 鉴权失败与不访问磁盘的路由不挂起
+    req.Init("./resources", dir);
+    buff.Append("GET /download?file=a.txt HTTP/1.1\r\n\r\n");
+    assert(req.parse(buff) == HttpRequest::UNAUTH_REQUEST && !req.IsDiskWait());
+    req.Init("./resources", dir);
+    buff.Append("GET /userinfo HTTP/1.1\r\n" + cookie + "\r\n");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && !req.IsDiskBound());
+
+    // 流式上传在读取消息体之前挂起，消息体留在缓冲区中
+    req.Init("./resources", dir);
+    buff.Append("PUT /upload?file=raw.txt HTTP/1.1\r\n" + cookie + "Content-Length: 5\r\n\r\nhel");
+    assert(req.parse(buff) == HttpRequest::PENDING_REQUEST && buff.ReadableBytes() == 3);
+    assert(req.Resume(buff) == HttpRequest::NO_REQUEST && req.IsDiskBound());
+    buff.Append("lo");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST);
+    struct stat st;
+    assert(stat((std::string(dir) + "/bob/raw.txt").c_str(), &st) == 0 && st.st_size == 5);
+    req.Init("./resources", dir);
+    assert(!req.IsDiskBound());
+
+    HttpRequest::deferDisk = false;
+    req.Init("./resources", dir);
+    buff.Append("GET /download?file=a.txt HTTP/1.1\r\n" + cookie + "\r\n");
+    assert(req.parse(buff) == HttpRequest::GET_REQUEST && !req.IsDiskBound());
+
+    // file不是字符串时返回400，不抛出异常
+    for(const std::string body : {"{\"file\":1}", "[\"a.txt\"]", "{}"}) {
+        req.Init("./resources", dir);
+        buff.Append("POST /delete HTTP/1.1\r\n" + cookie + "Content-Type: application/json\r\nContent-Length: " +
+                    std::to_string(body.size()) + "\r\n\r\n" + body);
+        assert(req.parse(buff) == HttpRequest::GET_REQUEST && req.reqRes() == "{\"err\":400}");
+    }
+
+    // 两个线程池的统计相互独立
+    ThreadPool pool(2);
+    std::atomic<int> done(0);
+    for(int i = 0; i < 8; i++) {
+        pool.AddTask([&done] { done++; });
+    }
+    while(done < 8) {
+        std::this_thread::yield();
+    }
+    std::string stats = pool.Stats();
+    assert(stats.find("peak:") != std::string::npos && stats.find("avgWait:") != std::string::npos);
+    assert(system(("rm -rf " + std::string(dir)).c_str()) == 0);
+}
+
+void TestRandomID() {
+    // RFC 8439 2.3.2
+    uint32_t key[8], nonce[3] = {0x09000000, 0x4a000000, 0};
+    for(int i = 0; i < 8; i++) {
+        key[i] = (4 * i) | (4 * i + 1) << 8 | (4 * i + 2) << 16 | (4 * i + 3) << 24;
+    }
+    uint8_t block[64];
+    RandomID::ChaCha20Block(key, 1, nonce, block);
+    const uint8_t expect[16] = {0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15,
+                                0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4};
+    assert(memcmp(block, expect, sizeof(expect)) == 0);
+    assert(block[60] == 0xa2 && block[63] == 0x4e);
+
+    std::unordered_set<std::string> ids;
+    for(int i = 0; i < 10000; i++) {
+        std::string id = RandomID::Generate();
+        assert(id.size() == RandomID::LEN);
+        assert(id.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_") == std::string::npos);
+        assert(ids.insert(id).second);
+    }
+    // 各线程独立播种
+    std::string other;
+    std::thread([&other] { other = RandomID::Generate(); }).join();
+    assert(ids.count(other) == 0);
+}
+
+// 以int模拟连接，value为0表示已断开
+class FakeConnPool : public ConnPool<int> {
+public:
+    ~FakeConnPool() override { ClosePool(); }
+    std::atomic<int> connects{0};
+protected:
+    int *Connect_() override { connects++; return new int(1); }
+    bool Ping_(int *conn) override { return *conn != 0; }
+    bool IsBroken_(int *conn) override { return *conn == 0; }
+    void Close_(int *conn) override { delete conn; }
+};
+
+// 建立连接较慢，用于观察预热期间的行为
+class SlowConnPool : public FakeConnPool {
+protected:
+    int *Connect_() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return FakeConnPool::Connect_();
+    }
+};
+
+void TestConnPool() {
+    FakeConnPool pool;
+    assert(pool.GetConn(0) == nullptr); // 未初始化时快速失败
+    assert(pool.InitPool("localhost", 0, nullptr, nullptr, nullptr, 2, 50, 20));
+    int *a = pool.GetConn();
+    int *b = pool.GetConn();
+    assert(a && b);
+    assert(pool.GetConn(10) == nullptr); // 连接耗尽时等待超时
+    pool.FreeConn(a);
+    assert((a = pool.GetConn()) != nullptr);
+
+    *b = 0; // 使用中断开，归还后由后台线程重连
+    pool.FreeConn(b);
+    assert((b = pool.GetConn(2000)) != nullptr && *b == 1);
+    assert(pool.connects == 3);
+    pool.FreeConn(a);
+    pool.FreeConn(b);
+    printf("ConnPool %s\n", pool.Stats().c_str());
+
+    // 就绪1个连接即返回，其余连接在后台补齐
+    FakeConnPool lazy;
+    assert(lazy.InitPool("localhost", 0, nullptr, nullptr, nullptr, 16, 50, 20, 1));
+    assert(lazy.GetFreeConnCount() >= 1);
+    std::vector<int *> conns;
+    for (int i = 0; i < 16; i++) {
+        int *conn = lazy.GetConn(2000);
+        assert(conn);
+        conns.push_back(conn);
+    }
+    assert(lazy.connects == 16);
+    for (int *conn : conns) {
+        lazy.FreeConn(conn);
+    }
+
+    // 预热未就绪时直接失败，不等待正在建立的连接
+    SlowConnPool slow;
+    std::thread warm([&slow] { assert(slow.InitPool("localhost", 0, nullptr, nullptr, nullptr, 1, 50, 20)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(slow.GetConn(1000) == nullptr);
+    warm.join();
+    int *conn = slow.GetConn(0);
+    assert(conn);
+    slow.FreeConn(conn);
+}
+
+void TestRedisReply() {
+    Buffer buff;
+    RedisAsync::EncodeCommand({"GET", "a b"}, buff);
+    assert(buff.RetrieveAllToStr() == "*2\r\n$3\r\nGET\r\n$3\r\na b\r\n");
+
+    RedisReply reply;
+    std::string data = "*3\r\n:1\r\n$-1\r\n$5\r\nadmin\r\n+OK\r\n";
+    ssize_t used = RedisAsync::ParseReply(data.data(), data.size(), reply);
+    assert(used == static_cast<ssize_t>(data.size()) - 5);
+    assert(reply.type == REDIS_REPLY_ARRAY && reply.elements.size() == 3);
+    assert(reply.elements[0].integer == 1 && reply.elements[1].type == REDIS_REPLY_NIL);
+    assert(reply.elements[2].str == "admin");
+    assert(RedisAsync::ParseReply(data.data(), 12, reply) == 0); // 不完整
+    assert(RedisAsync::ParseReply("?x\r\n", 4, reply) == -1);
+}
+
+// 异步session查询的应答映射：旧版本以hash保存的session返回WRONGTYPE，按不存在处理而不是503
+void TestSessionReply() {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    assert(bind(listenFd, (struct sockaddr *)&addr, len) == 0 && listen(listenFd, 1) == 0);
+    getsockname(listenFd, (struct sockaddr *)&addr, &len);
+    Epoller epoller;
+    assert(RedisAsync::Instance()->Init("127.0.0.1", ntohs(addr.sin_port), nullptr, nullptr, nullptr, 1, &epoller));
+    SessionStore::Init(SessionStore::BACKEND_REDIS);
+    assert(SessionStore::IsWrongType("WRONGTYPE Operation against a key holding the wrong kind of value"));
+    assert(!SessionStore::IsWrongType("ERR unknown command"));
+
+    RedisReply wrongType = {REDIS_REPLY_ERROR, 0, "WRONGTYPE Operation against a key holding the wrong kind of value", {}};
+    RedisReply other = {REDIS_REPLY_ERROR, 0, "LOADING Redis is loading the dataset in memory", {}};
+    RedisReply user = {REDIS_REPLY_STRING, 0, "admin", {}};
+    const RedisReply *replies[] = {&wrongType, &other, &user, nullptr};
+    const HttpRequest::AUTH_STATE expect[] = {HttpRequest::AUTH_FAIL, HttpRequest::AUTH_BUSY, HttpRequest::AUTH_PASS, HttpRequest::AUTH_BUSY};
+    HttpRequest req;
+    ChainBuffer buff;
+    for(int i = 0; i < 4; i++) {
+        const std::string sid = RandomID::Generate();
+        req.Init("./resources", "./data");
+        buff.Append("GET /userinfo HTTP/1.1\r\nCookie: session_id=" + sid + "\r\n\r\n");
+        req.parse(buff);
+        assert(req.authState() == HttpRequest::AUTH_WAIT);
+        assert(req.SessionCommand().size() == 2 && req.SessionCommand()[1] == SessionStore::SessionKey(sid));
+        req.OnSessionReply(replies[i]);
+        req.Resume(buff);
+        assert(req.authState() == expect[i]);
+    }
+    RedisAsync::Instance()->Close();
+    SessionStore::Init(SessionStore::BACKEND_MEMORY);
+    close(listenFd);
+}
+
+// 本地监听socket模拟Redis，验证流水线发送与按序回调
+void TestRedisAsync() {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    assert(bind(listenFd, (struct sockaddr *)&addr, len) == 0 && listen(listenFd, 1) == 0);
+    getsockname(listenFd, (struct sockaddr *)&addr, &len);
+
+    Epoller epoller;
+    RedisAsync *redis = RedisAsync::Instance();
+    assert(redis->Init("127.0.0.1", ntohs(addr.sin_port), nullptr, nullptr, nullptr, 1, &epoller));
+    std::vector<std::string> got;
+    for (int i = 0; i < 3; i++) {
+        assert(redis->Command({"GET", "k" + std::to_string(i)}, [&got](const RedisReply *reply) {
+            got.push_back(reply ? reply->str : "error");
+        }));
+    }
+    int fd = accept(listenFd, nullptr, nullptr);
+    assert(fd >= 0);
+
+    std::string req;
+    while (req.size() < 3 * 21) { // 每条命令 *2 $3 GET $2 kN 共21字节
+        int n = epoller.Wait(1000);
+        for (int i = 0; i < n; i++) {
+            redis->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i));
+        }
+        char buf[256];
+        ssize_t r = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (r > 0) {
+            req.append(buf, r);
+        }
+    }
+    assert(req.find("k2") != std::string::npos);
+    std::string resp = "$2\r\nv0\r\n$2\r\nv1\r\n$2\r\nv2\r\n";
+    assert(write(fd, resp.data(), resp.size()) == static_cast<ssize_t>(resp.size()));
+    while (got.size() < 3) {
+        int n = epoller.Wait(1000);
+        assert(n > 0);
+        for (int i = 0; i < n; i++) {
+            redis->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i));
+        }
+    }
+    assert(got[0] == "v0" && got[1] == "v1" && got[2] == "v2");
+
+    // 连接断开时未应答的命令回调nullptr
+    assert(redis->Command({"GET", "k"}, [&got](const RedisReply *reply) {
+        got.push_back(reply ? reply->str : "error");
+    }));
+    close(fd);
+    while (got.size() < 4) {
+        int n = epoller.Wait(1000);
+        assert(n > 0);
+        for (int i = 0; i < n; i++) {
+            redis->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i));
+        }
+    }
+    assert(got[3] == "error");
+    redis->Close();
+
+    // 连接正常但Redis不应答：超过应答时限后重置连接，未应答的命令回调nullptr
+    assert(redis->Init("127.0.0.1", ntohs(addr.sin_port), nullptr, nullptr, nullptr, 1, &epoller, 100));
+    assert(redis->Command({"GET", "k"}, [&got](const RedisReply *reply) {
+        got.push_back(reply ? reply->str : "timeout");
+    }));
+    fd = accept(listenFd, nullptr, nullptr);
+    assert(fd >= 0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (true) {
+        int ms = redis->CheckTimeout(); // 超时的回调在其中执行
+        if (got.size() == 5) {
+            break;
+        }
+        assert(ms > 0 && ms <= 101);
+        int n = epoller.Wait(ms);
+        for (int i = 0; i < n; i++) {
+            redis->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i));
+        }
+    }
+    assert(got[4] == "timeout" && std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    assert(redis->Stats().find("timeouts:1") != std::string::npos && redis->CheckTimeout() == -1);
+    close(fd);
+    redis->Close();
+    close(listenFd);
+}
+
 int main() {
     TestLog();
+    TestLogRotate();
+    TestAccessLog();
+    TestBuffer();
+    TestChainBuffer();
+    TestBlockPool();
+    TestArena();
+    TestRouter();
+    TestChunked();
+    TestMultipart();
+    TestUploadSplice();
+    TestUploadSession();
+    TestObjectStore();
+    TestBodyWriter();
+    TestSessionCache();
+    TestSessionReply();
+    TestCredentialCache();
+    TestListCache();
+    TestSessionToken();
+    TestMemStore();
+    TestFileIoDefer();
+    TestRandomID();
+    TestConnPool();
+    TestRedisReply();
+    TestRedisAsync();
     TestThreadPool();
 }
\ No newline at end of file